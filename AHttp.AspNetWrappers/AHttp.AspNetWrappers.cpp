@@ -141,7 +141,7 @@ namespace AHttp
 
         virtual String^ GetLocalAddress() override {
 			if (_hostName == nullptr) {
-				_hostName = getManagedString (_context->RequestHeader.getHeader(ahttp::strings::HeaderHost) );
+				_hostName = getManagedString (_context->RequestHeader.getHeader (ahttp::RequestHeaderHost) );
 				int pos = _hostName->IndexOf(":");
 				if (pos > -1)
 					_hostName = _hostName->Substring (0, pos);
@@ -237,19 +237,15 @@ namespace AHttp
 				return _unknownRequestHeaders;
 			
 			// lazy load
-			int headersCount = (int) _context->RequestHeader.Headers.size();
+			int headersCount = (int) _context->RequestHeader.headersCount();
 			 
 			_unknownRequestHeaders = gcnew array< array<String^>^>(headersCount);
             
-			aconnect::str2str_map_ci::const_iterator iter = _context->RequestHeader.Headers.begin();
-			
-			for (int ndx = 0; 
-				iter != _context->RequestHeader.Headers.end(); 
-				++iter, ++ndx) 
+			for (int ndx = 0; ndx < headersCount; ++ndx) 
 			{
                 _unknownRequestHeaders[ndx] = gcnew array<String^>(2);
-                _unknownRequestHeaders[ndx][0] = getManagedString (iter->first);
-                _unknownRequestHeaders[ndx][1] = getManagedString (iter->second);
+                _unknownRequestHeaders[ndx][0] = getManagedString (_context->RequestHeader.headerName (ndx));
+                _unknownRequestHeaders[ndx][1] = getManagedString (_context->RequestHeader.headerValue (ndx));
             }
 
 			return _unknownRequestHeaders;
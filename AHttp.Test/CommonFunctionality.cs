@@ -6,6 +6,8 @@ using Microsoft.VisualStudio.TestTools.UnitTesting;
 using System.Net;
 using AHttp.Test.Properties;
 using System.Threading;
+using System.Net.Sockets;
+using System.IO;
 
 namespace AHttp.Test
 {
@@ -148,5 +150,31 @@ namespace AHttp.Test
                 }
 			}
 		}
+
+        [TestMethod]
+        public void NotFoundResponseHasStatusLine()
+        {
+            Uri target = new Uri(Settings.Default.TargetServer);
+
+            // raw socket is used - status line must be checked as it is sent by server
+            using (TcpClient client = new TcpClient(target.Host, target.Port))
+            {
+                client.ReceiveTimeout = 30 * 1000;
+                NetworkStream stream = client.GetStream();
+
+                byte[] request = Encoding.ASCII.GetBytes(
+                    "GET /not-existing-" + DateTime.Now.Ticks + " HTTP/1.1\r\n" +
+                    "Host: " + target.Authority + "\r\n" +
+                    "Connection: close\r\n\r\n");
+                stream.Write(request, 0, request.Length);
+
+                using (StreamReader reader = new StreamReader(stream, Encoding.ASCII))
+                {
+                    string statusLine = reader.ReadLine();
+                    Assert.IsNotNull(statusLine, "Empty response");
+                    Assert.IsTrue(statusLine.StartsWith("HTTP/1.1 404"), "Invalid status line: " + statusLine);
+                }
+            }
+        }
 	}
 }
@@ -27,11 +27,13 @@ distribution.
 #include "lib_file_begin.inl"
 
 #include <cerrno>
+#include <algorithm>
 
 #include "util.hpp"
 #include "util.time.hpp"
 #include "util.network.hpp"
 #include "aconnect.hpp"
+#include "reactor.hpp"
 
 namespace aconnect 
 {
@@ -42,30 +44,33 @@ namespace aconnect
 		
 	public:
 		Server		*server; 
+		Acceptor	*acceptor; 
 
-		ThreadGuard (Server	*srv)
-			:server (srv) {	assert(server); }
+		ThreadGuard (Acceptor *acc)
+			:server (acc->server), acceptor (acc) {	assert(server); }
 		
 		~ThreadGuard () {
-			server->removeWorker();
+			acceptor->removeWorker();
 		}
 	};
 
 	void WorkerThreadProcAdapter::operator () () {
 		
-		ThreadGuard guard (_client.server);
+		ThreadGuard guard (_client.acceptor);
 	
 		try {
 			
 			do {
-				// process request
-				_proc (_client);
-				
-				// guard.server->logDebug("Close socket: %d", _client.sock);
-				if (!_client.isClosed())
-					_client.close();
+				// pre-spawned worker starts without connection
+				if (!_client.isClosed()) 
+				{
+					// process request
+					_proc (_client);
 					
-
+					// guard.server->logDebug("Close socket: %d", _client.sock);
+					if (!_client.isClosed())
+						_client.close();
+				}
 				
 			} while (guard.server->settings().enablePooling 
 				&& !guard.server->isStopped()
@@ -97,7 +102,11 @@ namespace aconnect
 		port = 0; 
 		sock = INVALID_SOCKET;
 		server = NULL;
+		acceptor = NULL;
+		queuedAt = 0;
+		isReadClosed = false;
 		util::zeroMemory(ip, sizeof(ip));
+		initialData.clear();
 	}
 
 	string ClientInfo::getRequest (SocketStateCheck &stateCheck) const {
@@ -123,10 +132,21 @@ namespace aconnect
 	//////////////////////////////////////////////////////////////////////////
 	//
 	//		Server
-	void Server::run (Server *server) 
+	Server::~Server () 
+	{ 
+		clear ();
+		
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			delete _acceptors[ndx];
+		_acceptors.clear();
+	}
+
+	void Server::run (Acceptor *acceptor) 
 	{
-		socket_type serverSock = server->socket();
-		const int maxWorkersCount = server->settings().workersCount;
+		Server *server = acceptor->server;
+		socket_type serverSock = acceptor->socket;
+
+		++server->_runningAcceptorsCount;
 
 		try 
 		{
@@ -155,45 +175,19 @@ namespace aconnect
 					clientInfo.sock = clientSock;
 					clientInfo.port = clientAddr.sin_port;
 					clientInfo.server = server;
+					clientInfo.acceptor = acceptor;
 					util::readIpAddress (clientInfo.ip, clientAddr.sin_addr);
 					
-					if (!server->settings().enablePooling) {
-						server->workerProc()(clientInfo);
+					if (server->resumeClient (clientInfo, server->settings().socketReadTimeout))
 						continue;
-					}
 
-					if (server->currentPendingWorkersCount() > 0)  
-					{
-						boost::mutex::scoped_lock lock (server->pendingMutex());
-					
-						if (server->currentPendingWorkersCount() > 0) 
-						{
-							server->requests().push_back (ClientInfo());
-							server->requests().back().swap (clientInfo);
-
-							server->pendingCondition().notify_one();
-							
-							lock.unlock(); // release lock to give time to pending worker
-							
-							boost::thread::yield ();
-							continue;
-						}
-					}
-
-					// create new worker thread
-					{
-						boost::mutex::scoped_lock lock (server->loadMutex());
-						if (server->currentWorkersCount () < maxWorkersCount) {
-							runWorkerThread (server, clientInfo);
-							continue;
-						}
+					// reactor is destroyed by server stop
+					if (server->isStopped()) {
+						util::closeSocket (clientSock);
+						break;
 					}
 
-					
-					// wait for worker finish
-					boost::mutex::scoped_lock lock (server->finishMutex());
-					server->finishCondition().wait (lock);
-					runWorkerThread (server, clientInfo);
+					server->processClient (clientInfo);
 				
 				} catch (socket_error &err) { 
 
@@ -240,7 +234,8 @@ namespace aconnect
 			server->logError ("Unknown exception caught in main aconnect server thread procedure" );
 		} 
 
-		if (server->stopProcessProc())
+		// the last stopped acceptor reports server stop
+		if (0 == --server->_runningAcceptorsCount && server->stopProcessProc())
 			server->stopProcessProc()();
 	}
 
@@ -253,14 +248,11 @@ namespace aconnect
 
 		_isStopped = false;
 
-		if (!inCurrentThread && NULL != _mainThread)
+		if (!inCurrentThread && !_acceptors.empty() && NULL != _acceptors.front()->thread)
 			throw server_started_error();
 	
-		_socket = util::createSocket (_settings.domain);
-		logDebug ("aconnect server socket created: %d, port: %d", 
-			_socket, _port);
-	
-		applySettings ();
+		if (_acceptors.empty())
+			createAcceptors ();
 
 		// bind server
 		struct sockaddr_in local;
@@ -287,23 +279,224 @@ namespace aconnect
 			logWarning ("Error loading host name, ip: %s", util::formatIpAddr(_settings.ip).c_str());
 		}
 		
-		if ( bind( _socket, (sockaddr*) &local, sizeof(local) ) != 0 )
-            throw socket_error (_socket, "Could not bind socket");
+		std::vector<Acceptor*>::iterator it;
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+		{
+			socket_type sock = util::createSocket (_settings.domain);
+			(*it)->socket = sock;
+			logDebug ("aconnect server socket created: %d, port: %d", 
+				sock, _port);
+		
+			applySettings (sock);
+
+			if ( bind( sock, (sockaddr*) &local, sizeof(local) ) != 0 )
+				throw socket_error (sock, "Could not bind socket");
 
-        if ( listen( _socket, settings().backlog ) != 0 )
-            throw socket_error (_socket, "Listen to socket failed");
+			if ( listen( sock, settings().backlog ) != 0 )
+				throw socket_error (sock, "Listen to socket failed");
+		}
+
+		if (_settings.enableReactor) {
+#if defined (__GNUC__)
+			_reactor = new Reactor (this);
+			_reactor->start (_settings.reactorThreadsCount);
+			logDebug ("aconnect reactor started, threads count: %d", _settings.reactorThreadsCount);
+#else
+			logWarning ("Reactor mode is not supported on current platform, thread-per-connection mode used");
+#endif
+		}
+
+		if (_settings.enablePooling && _settings.preSpawnWorkers) {
+			for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+				spawnWorkers (*it);
+		}
+
+		// run threads, first acceptor is processed in current thread when requested
+		for (size_t ndx = inCurrentThread ? 1 : 0; ndx < _acceptors.size(); ++ndx)
+		{
+			_acceptors[ndx]->thread = new boost::thread (ThreadProcAdapter<acceptor_thread_proc, Acceptor*>
+				(Server::run, _acceptors[ndx]) );
+		}
+		boost::thread::yield ();
 
-		// run thread
 		if (inCurrentThread) {
 			lock.unlock();
-			Server::run (this);
-		} else {
-			
-			_mainThread = new boost::thread (ThreadProcAdapter<server_thread_proc, Server*>
-				(Server::run, this) );
+			Server::run (_acceptors.front());
+		}
+	}
+
+	void Server::createAcceptors ()
+	{
+		int listenersCount = util::max2 (_settings.listenersCount, 1);
+
+#if !defined (SO_REUSEPORT)
+		if (listenersCount > 1) {
+			logWarning ("SO_REUSEPORT is not supported on current platform, single listening socket used");
+			listenersCount = 1;
+		}
+#endif
+		// workers limit is shared between groups
+		const int maxWorkersCount = util::max2 (_settings.workersCount / listenersCount, 1);
+		
+		int queueSize = maxWorkersCount;
+		if (_settings.preSpawnWorkers && _settings.pendingQueueSize > 0)
+			queueSize = util::max2 (_settings.pendingQueueSize / listenersCount, 1);
+
+		for (int ndx = 0; ndx < listenersCount; ++ndx)
+			_acceptors.push_back (new Acceptor (this, maxWorkersCount, queueSize));
+	}
+
+	void Server::spawnWorkers (Acceptor *acceptor)
+	{
+		ClientInfo idleClient;
+		idleClient.server = this;
+		idleClient.acceptor = acceptor;
+
+		boost::mutex::scoped_lock lock (acceptor->loadMutex);
+		while (acceptor->workersCount < acceptor->maxWorkersCount)
+			runWorkerThread (this, idleClient);
+	}
+
+	void Server::shedConnection (ClientInfo &clientInfo)
+	{
+		++clientInfo.acceptor->shedCount;
+
+		try {
+			if (errorProcessProc())
+				errorProcessProc()(clientInfo.sock);
 			
-			boost::thread::yield ();
+			util::closeSocket (clientInfo.sock, false);
+		
+		} catch (socket_error &err) {
+			logDebug ("Rejected connection processing failed: %s", err.what());
+		}
+		
+		clientInfo.sock = INVALID_SOCKET;
+	}
+
+	void Server::join ()
+	{
+		std::vector<Acceptor*>::iterator it;
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+			if ((*it)->thread)
+				(*it)->thread->join();
+	}
+
+	long Server::currentWorkersCount () const
+	{
+		long count = 0;
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			count += _acceptors[ndx]->workersCount;
+		return count;
+	}
+
+	long Server::currentPendingWorkersCount () const
+	{
+		long count = 0;
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			count += _acceptors[ndx]->pendingWorkersCount;
+		return count;
+	}
+
+	long Server::pendingQueueDepth () const
+	{
+		long count = 0;
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			count += (long) _acceptors[ndx]->requests.size();
+		return count;
+	}
+
+	long Server::shedConnectionsCount () const
+	{
+		long count = 0;
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			count += _acceptors[ndx]->shedCount;
+		return count;
+	}
+
+	long Server::queuedConnectionsCount () const
+	{
+		long count = 0;
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			count += util::atomicLoad (&_acceptors[ndx]->queuedCount);
+		return count;
+	}
+
+	long Server::queueWaitTime () const
+	{
+		long time = 0;
+		for (size_t ndx = 0; ndx < _acceptors.size(); ++ndx)
+			time += util::atomicLoad (&_acceptors[ndx]->queueWaitTime);
+		return time;
+	}
+
+	void Server::processClient (ClientInfo &clientInfo) 
+	{
+		if (!settings().enablePooling) {
+			workerProc()(clientInfo);
+			return;
+		}
+
+		if (dispatchClient (clientInfo))
+			return;
+		
+		// wait for worker finish
+		boost::mutex::scoped_lock lock (clientInfo.acceptor->finishMutex);
+		clientInfo.acceptor->finishCondition.wait (lock);
+		runWorkerThread (this, clientInfo);
+	}
+
+	bool Server::dispatchClient (ClientInfo &clientInfo) 
+	{
+		// connection is processed in own thread
+		if (!settings().enablePooling) {
+			runWorkerThread (this, clientInfo);
+			return true;
+		}
+
+		Acceptor *acceptor = clientInfo.acceptor;
+		assert (acceptor && "Client connection acceptor is not defined");
+
+		clientInfo.queuedAt = util::getTickCount();
+
+		// all workers are started - queue connection or reject it
+		if (settings().preSpawnWorkers) 
+		{
+			if (acceptor->requests.tryPush (clientInfo))
+				acceptor->requestsSignal.post();
+			else
+				shedConnection (clientInfo);
+			return true;
 		}
+
+		if (acceptor->pendingWorkersCount > 0 && acceptor->requests.tryPush (clientInfo))  
+		{
+			acceptor->requestsSignal.post();
+
+			// all pending workers can expire meanwhile - take connection back
+			if (acceptor->pendingWorkersCount > 0 || !acceptor->requests.tryPop (clientInfo))
+				return true;
+		}
+
+		// create new worker thread
+		boost::mutex::scoped_lock lock (acceptor->loadMutex);
+		if (acceptor->workersCount < acceptor->maxWorkersCount) {
+			runWorkerThread (this, clientInfo);
+			return true;
+		}
+
+		return false;
+	}
+
+	bool Server::resumeClient (const ClientInfo &client, int idleTimeout)
+	{
+		// reactor can be destroyed by server stop meanwhile
+		boost::mutex::scoped_lock lock (_reactorMutex);
+		if (!_reactor || isStopped())
+			return false;
+
+		_reactor->add (client, idleTimeout);
+		return true;
 	}
 
 	void Server::runWorkerThread (Server *server, const ClientInfo &clientInfo) 
@@ -313,7 +506,7 @@ namespace aconnect
 
 		// process request
 		WorkerThreadProcAdapter adapter (server->workerProc(), clientInfo);
-		server->addWorker();
+		clientInfo.acceptor->addWorker();
 		
 		boost::thread worker (adapter);
 		boost::thread::yield ();
@@ -321,31 +514,48 @@ namespace aconnect
 	
 	bool Server::waitRequest (ClientInfo &client) 
 	{
-		++_pendingWorkersCount;
-		assert (_pendingWorkersCount <= _workersCount 
+		Acceptor *acceptor = client.acceptor;
+		assert (client.isClosed() && "Client connection is not closed correctly");
+
+		++acceptor->pendingWorkersCount;
+		assert (acceptor->pendingWorkersCount <= acceptor->workersCount 
 			&& "Too many pending workers!");
 
-		boost::mutex::scoped_lock lock (_pendingMutex);
-		
-		// wait for new request
-		bool waitResult = _pendingCondition.timed_wait (lock, 
-				aconnect::util::createTimePeriod (settings().workerLifeTime) );
-		
-		--_pendingWorkersCount;
-		assert (_pendingWorkersCount >= 0 && "Negative pending workers count!");
+		// pre-spawned workers live until server stop
+		const int lifeTime = settings().preSpawnWorkers ? -1 : settings().workerLifeTime;
 
-		if (waitResult && !isStopped()) 
-		{ 
-			assert (!requests().empty() && "Requests queue is empty");
-			assert (client.isClosed() && "Client connection is not closed correctly");
+		bool loaded = false;
+		while (true) 
+		{
+			// wait for new request
+			bool signaled = acceptor->requestsSignal.timedWait (lifeTime);
 
-			client.swap (requests().front());
-			requests().pop_front();
+			if (isStopped())
+				break;
 
-			assert (client.sock != INVALID_SOCKET);
+			if (!signaled) {
+				// connection can be queued directly before timeout
+				--acceptor->pendingWorkersCount;
+				return acceptor->requests.tryPop (client);
+			}
+
+			// signal can be left by expired worker - wait again when queue is empty
+			if ( (loaded = acceptor->requests.tryPop (client)) )
+				break;
 		}
 		
-		return waitResult;
+		--acceptor->pendingWorkersCount;
+		assert (acceptor->pendingWorkersCount >= 0 && "Negative pending workers count!");
+		
+		if (loaded) {
+			assert (client.sock != INVALID_SOCKET);
+			
+			util::atomicAdd (&acceptor->queuedCount, 1);
+			util::atomicAdd (&acceptor->queueWaitTime, 
+				(atomic_type) (util::getTickCount() - client.queuedAt));
+		}
+
+		return loaded;
 	}
 	
 	void Server::stop (bool waitAllWorkers)
@@ -356,50 +566,113 @@ namespace aconnect
 
 		_isStopped = true;
 		
+		std::vector<Acceptor*>::iterator it;
+		
+		// wake up pending workers, extra signals release workers which are going to wait
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+			for (int ndx = 0; ndx < (*it)->maxWorkersCount; ++ndx)
+				(*it)->requestsSignal.post();
+
 		if (waitAllWorkers) 
 		{
-			_logger->debug ("Threads pool unloading, pending workers count: %d", (long) _pendingWorkersCount );
+			_logger->debug ("Threads pool unloading, pending workers count: %d", currentPendingWorkersCount() );
 
-			while (_pendingWorkersCount > 0) 
+			for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
 			{
-				boost::mutex::scoped_lock lock (pendingMutex());
-				pendingCondition().notify_one();
+				while ((*it)->pendingWorkersCount > 0) 
+				{
+					(*it)->requestsSignal.post();
+					boost::thread::yield ();
+				}
 			}
 
-			_logger->debug ("Threads pool unloading, workers count: %d", (long) _workersCount );
+			_logger->debug ("Threads pool unloading, workers count: %d", currentWorkersCount() );
 
-			while (_workersCount > 0) 
+			for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
 			{
-				boost::mutex::scoped_lock lock (finishMutex() );
-				finishCondition().wait (lock);
+				while ((*it)->workersCount > 0) 
+				{
+					boost::mutex::scoped_lock lock ((*it)->finishMutex);
+					(*it)->finishCondition.wait (lock);
+				}
 			}
 		}
 
-		try {
-			if (_socket != INVALID_SOCKET) {
-				util::closeSocket ( _socket );
-				_socket = INVALID_SOCKET;
+#if defined (__GNUC__)
+		// wake up acceptors blocked in accept()
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+			if ((*it)->socket != INVALID_SOCKET)
+				shutdown ((*it)->socket, SHUT_RDWR);
+#endif
+
+		// acceptors pass connections to reactor - it must be destroyed after they are finished,
+		// acceptor can stop server itself, so lock is released while threads are joined
+		lock.unlock();
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+			if ((*it)->thread && (*it)->thread->get_id() != boost::this_thread::get_id())
+				(*it)->thread->join();
+		lock.lock();
+
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+		{
+			try {
+				if ((*it)->socket != INVALID_SOCKET) {
+					util::closeSocket ( (*it)->socket );
+					(*it)->socket = INVALID_SOCKET;
+				}
+			} catch (socket_error &err) {
+				logWarning (err);
 			}
-		} catch (socket_error &err) {
-			logWarning (err);
 		}
 
 		clear ();      
 	}
 
-	
+	void Server::clear () 
+	{
+		std::vector<Acceptor*>::iterator it;
+		for (it = _acceptors.begin(); it != _acceptors.end(); ++it)
+		{
+			if ((*it)->thread) {
+				delete (*it)->thread; 
+				(*it)->thread = NULL;
+			}
+		}
+		
+		// workers and acceptor processed in current thread can resume clients meanwhile
+		Reactor *reactor = NULL;
+		{
+			boost::mutex::scoped_lock lock (_reactorMutex);
+			std::swap (reactor, _reactor);
+		}
+
+		if (reactor) {
+			reactor->stop();
+			delete reactor;
+		}
+	}
 
-	void Server::applySettings () 
+	void Server::applySettings (socket_type sock) 
 	{
 		int intValue = 0;
 		
 		intValue = (_settings.reuseAddr ? 1 : 0);
-		if ( setsockopt( _socket, SOL_SOCKET, SO_REUSEADDR, 
+		if ( setsockopt( sock, SOL_SOCKET, SO_REUSEADDR, 
 			(char *) &intValue, sizeof(intValue) ) != 0 )
-				throw socket_error (_socket, "Reuse address option setup failed");
+				throw socket_error (sock, "Reuse address option setup failed");
+
+#if defined (SO_REUSEPORT)
+		// several listening sockets are bound to the same port, kernel balances connections
+		if (_acceptors.size() > 1) {
+			intValue = 1;
+			if ( setsockopt( sock, SOL_SOCKET, SO_REUSEPORT, 
+				(char *) &intValue, sizeof(intValue) ) != 0 )
+					throw socket_error (sock, "Reuse port option setup failed");
+		}
+#endif
 
-		util::setSocketReadTimeout ( _socket, _settings.socketReadTimeout );
-		util::setSocketWriteTimeout ( _socket, _settings.socketWriteTimeout );
+		util::setSocketReadTimeout ( sock, _settings.socketReadTimeout );
+		util::setSocketWriteTimeout ( sock, _settings.socketWriteTimeout );
 	}
 	//
 	//
@@ -31,19 +31,25 @@ distribution.
 #include <boost/thread.hpp>
 #include <boost/detail/atomic_count.hpp>
 #include <list>
+#include <vector>
 
 
 #include "types.hpp"
 #include "util.hpp"
 #include "logger.hpp"
 #include "server_settings.hpp"
+#include "util.atomic.hpp"
+#include "ring_buffer.hpp"
 
 namespace aconnect 
 {
 	typedef void (*worker_thread_proc) (const struct ClientInfo&);
 	typedef void (*process_error_proc) (const socket_type clientSock);
 	typedef void (*server_thread_proc) (class Server *);   
+	typedef void (*acceptor_thread_proc) (struct Acceptor *);   
 	typedef void (*process_stop_proc) ();
+
+	class Reactor;
 	
 	struct ClientInfo
 	{
@@ -51,6 +57,10 @@ namespace aconnect
 		ip_addr_type			ip;
 		mutable socket_type		sock;
 		class Server			*server;
+		struct Acceptor			*acceptor;		// listener which accepted connection
+		mutable string			initialData;	// request data read before worker start (reactor mode)
+		unsigned long			queuedAt;		// tick count when connection was queued to pending workers
+		bool					isReadClosed;	// client has shut down sending (reactor mode), connection is not kept alive
 
 		// constructor
 		ClientInfo();
@@ -72,6 +82,10 @@ namespace aconnect
 				std::swap (ip[ndx], other.ip[ndx]);
 			
 			std::swap (server, other.server);
+			std::swap (acceptor, other.acceptor);
+			std::swap (queuedAt, other.queuedAt);
+			std::swap (isReadClosed, other.isReadClosed);
+			initialData.swap (other.initialData);
 		};
 	};
 	
@@ -88,6 +102,60 @@ namespace aconnect
 	};
 	
 
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Acceptor - listening socket with own accept thread and worker-threads group
+
+	struct Acceptor : private boost::noncopyable
+	{
+		class Server	*server;
+		socket_type		socket;
+		boost::thread	*thread;
+		int				maxWorkersCount;
+		
+		boost::detail::atomic_count workersCount;
+		boost::detail::atomic_count pendingWorkersCount;
+
+		boost::mutex finishMutex;
+		boost::condition_variable_any finishCondition;
+		
+		boost::mutex loadMutex;
+
+		RingBuffer<ClientInfo> requests;	// connections passed to pending workers
+		Semaphore requestsSignal;			// pending workers are parked here
+
+		// statistics
+		boost::detail::atomic_count shedCount;	// connections rejected by full queue
+		volatile atomic_type queuedCount;		// connections passed through queue
+		volatile atomic_type queueWaitTime;		// total wait time in queue (msec)
+
+		Acceptor (class Server *owner, int maxWorkers, int queueSize) :
+			server (owner),
+			socket (INVALID_SOCKET),
+			thread (NULL),
+			maxWorkersCount (maxWorkers),
+			workersCount (0),
+			pendingWorkersCount (0),
+			requests (queueSize),
+			shedCount (0),
+			queuedCount (0),
+			queueWaitTime (0)
+		{ }
+
+		inline void addWorker () {	
+			++workersCount;		
+		}
+
+		inline void removeWorker () {	
+			boost::mutex::scoped_lock lock (finishMutex);
+			--workersCount;
+            
+			assert (workersCount >= 0 && "Negative workers count!");
+			finishCondition.notify_one();
+		}
+	};
+	
+
 	//////////////////////////////////////////////////////////////////////////
 	//
 	//		Server class
@@ -100,17 +168,13 @@ namespace aconnect
 			_worker_proc (NULL),
 			_errorProcess_proc (NULL),
 			_stopProcess_proc(NULL),
-			_mainThread(NULL), 
-			_socket(INVALID_SOCKET),
-			_workersCount (0),
-			_pendingWorkersCount (0),
+			_runningAcceptorsCount (0),
             _logger( NULL ),
+			_reactor (NULL),
 			_isStopped (false)
 		{ }
 
-		virtual ~Server () { 
-			clear ();
-		}
+		virtual ~Server ();
 
 		void init (port_type port, worker_thread_proc workerProc, 
 			const ServerSettings &settings = ServerSettings())
@@ -125,14 +189,32 @@ namespace aconnect
 		void stop (bool waitAllWorkers = false);
 		bool waitRequest (ClientInfo &client);
 
-		// server thread function
-		void static run (Server *server);
-
-		inline void join ()
-        {
-			if (_mainThread)
-				_mainThread->join();
-		}
+		/**
+		* Pass accepted client connection to worker of its acceptor group: 
+		* pending worker from pool, new worker thread or wait for worker finish.
+		* @param[in]	clientInfo		Client connection with opened socket
+		*/
+		void processClient (ClientInfo &clientInfo);
+
+		/**
+		* Pass accepted client connection to worker without waiting for worker finish,
+		* returns false when all workers of acceptor group are busy (connection is left in 'clientInfo').
+		* @param[in,out]	clientInfo		Client connection with opened socket
+		*/
+		bool dispatchClient (ClientInfo &clientInfo);
+
+		/**
+		* Pass connection to reactor to wait next request without worker locking,
+		* returns false when reactor mode is disabled or server is stopped.
+		* @param[in]	client			Processed client connection
+		* @param[in]	idleTimeout		Time to wait next request (sec)
+		*/
+		bool resumeClient (const ClientInfo &client, int idleTimeout);
+
+		// acceptor thread function
+		void static run (Acceptor *acceptor);
+
+		void join ();
 		
 
         //////////////////////////////////////////////////////////////////////////////////////////
@@ -141,46 +223,32 @@ namespace aconnect
 		virtual bool isStopped ()							{   return _isStopped;      }   
 
 		inline port_type port()	const						{	return _port;		    }
-		inline socket_type socket() const					{	return _socket;		    }
+		inline socket_type socket() const					{	return _acceptors.empty() ? INVALID_SOCKET : _acceptors.front()->socket; }
 		inline const ServerSettings& settings()	const		{	return _settings;	    } 
 		inline worker_thread_proc workerProc()const			{	return _worker_proc;     } 
 		inline process_error_proc errorProcessProc() const	{	return _errorProcess_proc;} 
 		inline process_stop_proc stopProcessProc() const	{	return _stopProcess_proc;} 
 		
-		inline boost::mutex&  finishMutex()					{	return _finishMutex;	}
-		inline boost::condition_variable_any&  finishCondition()			{	return _finishCondition;}
-		inline boost::mutex&  pendingMutex()				{	return _pendingMutex;	}
-		inline boost::condition_variable_any&  pendingCondition()		{	return _pendingCondition;}
 		inline boost::mutex&  stopMutex()					{	return _stopMutex;		}
-		inline boost::mutex&  loadMutex()					{	return _loadMutex;		}
+		inline const std::vector<Acceptor*>& acceptors() const	{	return _acceptors;	}
 		
 		inline void setLog (Logger *log)					{   _logger = log;          }
         inline Logger* log () const							{   return _logger;         }   
 		
-		inline std::list<ClientInfo>& requests()			{	return _requestsQueue;		}
-		
 		inline void setErrorProcessProc(process_error_proc proc)	{	_errorProcess_proc = proc;} 
 		inline void setStopProcessProc(process_stop_proc proc)		{	_stopProcess_proc = proc;} 
 
-        inline void addWorker () {	
-			++_workersCount;		
-		}
-
-		inline long currentWorkersCount () {	
-			return _workersCount;		
-		}
+		long currentWorkersCount () const;
+		long currentPendingWorkersCount () const;
 		
-		inline void removeWorker () {	
-			boost::mutex::scoped_lock lock (finishMutex());
-			--_workersCount;
-            
-			assert (_workersCount >= 0 && "Negative workers count!");
-			_finishCondition.notify_one();
-		}
-
-		inline long currentPendingWorkersCount () {	
-			return _pendingWorkersCount;		
-		}
+		// pending connections queue statistics
+		long pendingQueueDepth () const;
+		long shedConnectionsCount () const;
+		long queuedConnectionsCount () const;
+		long queueWaitTime () const;			// total, msec
+
+		// reject connection: error response is sent by error process procedure, socket is closed
+		void shedConnection (ClientInfo &clientInfo);
 			
 		inline void logDebug (string_constptr format, ...)	{	
 			if (_logger) {
@@ -210,15 +278,12 @@ namespace aconnect
 		}
 
 	protected:
-		void applySettings ();
+		void createAcceptors ();
+		void spawnWorkers (Acceptor *acceptor);
+		void applySettings (socket_type sock);
 		void static runWorkerThread (Server *server, const ClientInfo &clientInfo);
 		
-		inline void clear () {
-			if (_mainThread) {
-				delete _mainThread; 
-				_mainThread = NULL;
-			}
-		}
+		void clear ();
 
 	
 	// fields
@@ -230,25 +295,16 @@ namespace aconnect
 
 		ServerSettings _settings;
         
-        boost::thread *_mainThread;
-        socket_type _socket;
+		std::vector<Acceptor*> _acceptors;
+		boost::detail::atomic_count _runningAcceptorsCount;
         
-        boost::detail::atomic_count _workersCount;
-		boost::detail::atomic_count _pendingWorkersCount;
         Logger     *_logger;   
+		Reactor	   *_reactor;
 		
-		boost::mutex _finishMutex;
-		boost::condition_variable_any _finishCondition;
-		
-		boost::mutex _pendingMutex;
-		boost::condition_variable_any _pendingCondition;
-
-
 		boost::mutex _stopMutex;
-		boost::mutex _loadMutex;
+		boost::mutex _reactorMutex;		// guards reactor destruction
 
 		bool _isStopped;
-		std::list<ClientInfo> _requestsQueue;
 	};
 
 	//
@@ -0,0 +1,550 @@
+/*
+This file is part of [aconnect] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "lib_file_begin.inl"
+
+#if defined (__GNUC__)
+
+#include <cerrno>
+#include <ctime>
+#include <set>
+#include <vector>
+#include <list>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+
+#include <boost/thread.hpp>
+
+#include "util.hpp"
+#include "util.network.hpp"
+#include "util.scan.hpp"
+#include "aconnect.hpp"
+#include "timer_wheel.hpp"
+#include "reactor.hpp"
+
+namespace aconnect
+{
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Reactor internals
+
+	namespace
+	{
+		// timer wheel ticks are seconds of monotonic clock
+		inline timer_tick_type monotonicSeconds ()
+		{
+			timespec now;
+			clock_gettime (CLOCK_MONOTONIC, &now);
+			return (timer_tick_type) now.tv_sec;
+		}
+	}
+
+	struct ReactorConnection
+	{
+		ClientInfo		client;
+		string			data;
+		int				idleTimeout;	// sec
+		timer_tick_type	headerDeadline;	// request header must be read (and dispatched) before, 0 - not started
+		TimerNode		timer;
+		bool			isParked;
+		std::list<ReactorConnection*>::iterator parkedPos;
+
+		ReactorConnection () : idleTimeout (0), headerDeadline (0), timer (this), isParked (false) { }
+	};
+
+	struct ReactorLoop
+	{
+		Reactor			*reactor;
+		int				epollFd;
+		int				wakeFd;
+		boost::thread	*thread;
+		bool			isStopped;
+		TimerWheel		timers;
+
+		boost::mutex	incomingMutex;
+		std::list<ReactorConnection*>	incoming;
+		std::list<ReactorConnection*>	parked;		// read connections waiting for free worker
+		size_t							parkedCount;
+		std::set<ReactorConnection*>	connections;
+
+		ReactorLoop (Reactor *owner) :
+			reactor (owner), epollFd (-1), wakeFd (-1), thread (NULL), isStopped (false),
+			timers (monotonicSeconds()), parkedCount (0) { }
+
+		inline void wakeUp () {
+			eventfd_write (wakeFd, 1);
+		}
+	};
+
+	namespace
+	{
+		inline void setNonBlocking (socket_type s, bool nonBlocking) throw (socket_error)
+		{
+			int flags = fcntl (s, F_GETFL, 0);
+			if (flags == -1)
+				throw socket_error (s, "Reading socket flags failed");
+
+			flags = nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+			if (fcntl (s, F_SETFL, flags) == -1)
+				throw socket_error (s, "Socket O_NONBLOCK flag setup failed");
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Reactor
+
+	Reactor::Reactor (Server *server, string_constref endMark) :
+		_server (server),
+		_endMark (endMark),
+		_nextLoop (0)
+	{
+		assert (_server);
+	}
+
+	Reactor::~Reactor ()
+	{
+		stop ();
+	}
+
+	void Reactor::start (int loopsCount) throw (socket_error)
+	{
+		assert (_loops.empty() && "Reactor is already started");
+
+		for (int ndx = 0; ndx < util::max2 (loopsCount, 1); ++ndx)
+		{
+			ReactorLoop *loop = new ReactorLoop (this);
+			_loops.push_back (loop);
+
+			loop->epollFd = epoll_create (MaxEventsCount);
+			if (loop->epollFd == -1)
+				throw socket_error (INVALID_SOCKET, "Reactor: epoll_create failed");
+
+			loop->wakeFd = eventfd (0, EFD_NONBLOCK);
+			if (loop->wakeFd == -1)
+				throw socket_error (INVALID_SOCKET, "Reactor: eventfd creation failed");
+
+			struct epoll_event ev;
+			util::zeroMemory (&ev, sizeof(ev));
+			ev.events = EPOLLIN;
+			ev.data.ptr = NULL; // wake up marker
+
+			if (epoll_ctl (loop->epollFd, EPOLL_CTL_ADD, loop->wakeFd, &ev) != 0)
+				throw socket_error (INVALID_SOCKET, "Reactor: wake up descriptor registration failed");
+
+			loop->thread = new boost::thread (ThreadProcAdapter<void (*)(ReactorLoop*), ReactorLoop*>
+				(Reactor::run, loop) );
+		}
+	}
+
+	void Reactor::stop ()
+	{
+		std::vector<ReactorLoop*>::iterator it;
+		for (it = _loops.begin(); it != _loops.end(); ++it)
+		{
+			ReactorLoop *loop = *it;
+			if (loop->thread) {
+				{
+					boost::mutex::scoped_lock lock (loop->incomingMutex);
+					loop->isStopped = true;
+				}
+				loop->wakeUp();
+
+				if (loop->thread->get_id() != boost::this_thread::get_id())
+					loop->thread->join();
+				delete loop->thread;
+			}
+
+			// close all owned connections
+			loop->connections.insert (loop->incoming.begin(), loop->incoming.end());
+			std::set<ReactorConnection*>::iterator connIter;
+			for (connIter = loop->connections.begin(); connIter != loop->connections.end(); ++connIter) {
+				loop->timers.cancel (&(*connIter)->timer);
+				util::closeSocket ((*connIter)->client.sock, false);
+				delete *connIter;
+			}
+
+			if (loop->wakeFd != -1)
+				close (loop->wakeFd);
+			if (loop->epollFd != -1)
+				close (loop->epollFd);
+
+			delete loop;
+		}
+
+		_loops.clear();
+	}
+
+	void Reactor::add (const ClientInfo &client, int idleTimeout) throw (socket_error)
+	{
+		assert (!_loops.empty() && "Reactor is not started");
+		if (_loops.empty())
+			throw socket_error (client.sock, "Reactor is not started");
+
+		setNonBlocking (client.sock, true);
+
+		ReactorConnection *conn = new ReactorConnection ();
+		conn->client = client;
+		conn->idleTimeout = idleTimeout;
+
+		// data received by previous request processing
+		conn->data.swap (conn->client.initialData);
+
+		// connection is owned by reactor now
+		client.sock = INVALID_SOCKET;
+
+		ReactorLoop *loop = _loops[ (++_nextLoop) % _loops.size() ];
+		{
+			boost::mutex::scoped_lock lock (loop->incomingMutex);
+			loop->incoming.push_back (conn);
+		}
+		loop->wakeUp();
+	}
+
+	void Reactor::run (ReactorLoop *loop)
+	{
+		Server *server = loop->reactor->server();
+		struct epoll_event events[MaxEventsCount];
+		std::vector<TimerNode*> expired;
+
+		try
+		{
+			while (!loop->isStopped && !server->isStopped())
+			{
+				int eventsCount = epoll_wait (loop->epollFd, events, MaxEventsCount, 
+					loop->parked.empty() ? TimerTickInterval : DispatchRetryInterval);
+
+				if (eventsCount == -1) {
+					if (errno == EINTR)
+						continue;
+					throw socket_error (INVALID_SOCKET, "Reactor: epoll_wait failed");
+				}
+
+				for (int ndx = 0; ndx < eventsCount; ++ndx)
+				{
+					ReactorConnection *conn = (ReactorConnection*) events[ndx].data.ptr;
+
+					if (NULL == conn)
+						registerIncoming (loop);
+					else if (conn->isParked)
+						checkParked (loop, conn, events[ndx].events);
+					else
+						readConnection (loop, conn);
+				}
+
+				if (!loop->parked.empty())
+					dispatchParked (loop);
+
+				expired.clear();
+				if (loop->timers.advance (monotonicSeconds(), expired) > 0)
+					closeExpiredConnections (loop, expired);
+			}
+
+		} catch (std::exception &err) {
+			server->logError ("Exception caught in reactor thread (%s): %s",
+				typeid(err).name(), err.what());
+		} catch (...)  {
+			server->logError ("Unknown exception caught in reactor thread procedure" );
+		}
+	}
+
+	void Reactor::registerIncoming (ReactorLoop *loop)
+	{
+		eventfd_t value;
+		eventfd_read (loop->wakeFd, &value);
+
+		std::list<ReactorConnection*> incoming;
+		{
+			boost::mutex::scoped_lock lock (loop->incomingMutex);
+			if (loop->isStopped)
+				return;
+			incoming.swap (loop->incoming);
+		}
+
+		std::list<ReactorConnection*>::iterator it;
+		for (it = incoming.begin(); it != incoming.end(); ++it)
+		{
+			ReactorConnection *conn = *it;
+			loop->connections.insert (conn);
+
+			// keep-alive connection can contain already loaded request
+			if (!conn->data.empty() &&
+				util::findString (conn->data, loop->reactor->endMark()) != string::npos) {
+				dispatchConnection (loop, conn);
+				continue;
+			}
+
+			struct epoll_event ev;
+			util::zeroMemory (&ev, sizeof(ev));
+			ev.events = EPOLLIN | EPOLLRDHUP;
+			ev.data.ptr = conn;
+
+			if (epoll_ctl (loop->epollFd, EPOLL_CTL_ADD, conn->client.sock, &ev) != 0) {
+				loop->reactor->server()->logWarning ("Reactor: client socket registration failed, "
+					"socket: %d, error code: %d", conn->client.sock, errno);
+				closeConnection (loop, conn);
+				continue;
+			}
+
+			updateTimer (loop, conn);
+		}
+	}
+
+	void Reactor::readConnection (ReactorLoop *loop, ReactorConnection *conn)
+	{
+		char_type buff[ReadChunkSize];
+		const size_t initialSize = conn->data.size();
+		int bytesRead = 0;
+
+		while ( (bytesRead = recv (conn->client.sock, buff, ReadChunkSize, 0)) > 0 ) 
+		{
+			conn->data.append (buff, bytesRead);
+
+			// header size is checked below, rest of data is read at the next event
+			if (conn->data.size() > (size_t) MaxHeaderSize)
+				break;
+		}
+
+		// client can shut down sending right after the request
+		const bool readClosed = (0 == bytesRead);
+
+		if (bytesRead == SOCKET_ERROR && errno != EAGAIN
+				&& errno != EWOULDBLOCK && errno != EINTR) {
+			// connection broken
+			closeConnection (loop, conn);
+			return;
+		}
+
+		if (conn->data.size() == initialSize) {
+			if (readClosed)
+				closeConnection (loop, conn);
+			return;
+		}
+
+		// look for header end, previous data part is already checked
+		string_constref endMark = loop->reactor->endMark();
+		size_t searchPos = initialSize > endMark.size() ? initialSize - endMark.size() : 0;
+
+		if (util::findString (conn->data, endMark, searchPos) != string::npos) {
+			// request is served, but connection is not kept alive
+			conn->client.isReadClosed = readClosed;
+			dispatchConnection (loop, conn);
+
+		} else if (readClosed) {
+			// connection closed by client
+			closeConnection (loop, conn);
+
+		} else if (conn->data.size() > (size_t) MaxHeaderSize) {
+			loop->reactor->server()->logWarning ("Reactor: too large request header received, client IP: %s",
+				util::formatIpAddr (conn->client.ip).c_str());
+			closeConnection (loop, conn);
+		
+		} else {
+			updateTimer (loop, conn);
+		}
+	}
+
+	void Reactor::dispatchConnection (ReactorLoop *loop, ReactorConnection *conn)
+	{
+		epoll_ctl (loop->epollFd, EPOLL_CTL_DEL, conn->client.sock, NULL);
+		loop->timers.cancel (&conn->timer);
+
+		// connections are passed to workers in arrival order
+		if (loop->parked.empty() && passConnection (loop, conn))
+			return;
+
+		if (loop->parkedCount >= (size_t) MaxParkedCount) {
+			loop->reactor->server()->logWarning ("Reactor: too many connections wait for free worker, "
+				"connection rejected, client IP: %s", util::formatIpAddr (conn->client.ip).c_str());
+			
+			loop->reactor->server()->shedConnection (conn->client);
+			closeConnection (loop, conn);
+			return;
+		}
+
+		parkConnection (loop, conn, false);
+	}
+
+	void Reactor::dispatchParked (ReactorLoop *loop)
+	{
+		while (!loop->parked.empty())
+		{
+			ReactorConnection *conn = loop->parked.front();
+			unparkConnection (loop, conn);
+			
+			if (!passConnection (loop, conn)) {
+				// connection keeps its place
+				parkConnection (loop, conn, true);
+				break;
+			}
+		}
+	}
+
+	void Reactor::parkConnection (ReactorLoop *loop, ReactorConnection *conn, bool atFront)
+	{
+		conn->isParked = true;
+		conn->parkedPos = loop->parked.insert (atFront ? loop->parked.begin() : loop->parked.end(), conn);
+		++loop->parkedCount;
+
+		// client disconnection is watched while connection waits
+		if (!conn->client.isReadClosed) {
+			struct epoll_event ev;
+			util::zeroMemory (&ev, sizeof(ev));
+			ev.events = EPOLLRDHUP;
+			ev.data.ptr = conn;
+
+			epoll_ctl (loop->epollFd, EPOLL_CTL_ADD, conn->client.sock, &ev);
+		}
+
+		// waiting time is limited by header deadline or by idle timeout
+		if (0 == conn->headerDeadline)
+			conn->headerDeadline = loop->timers.currentTick() + 
+				(timer_tick_type) util::max2 (conn->idleTimeout, 1);
+		
+		updateTimer (loop, conn);
+	}
+
+	void Reactor::unparkConnection (ReactorLoop *loop, ReactorConnection *conn)
+	{
+		assert (conn->isParked);
+
+		loop->parked.erase (conn->parkedPos);
+		--loop->parkedCount;
+		conn->isParked = false;
+
+		epoll_ctl (loop->epollFd, EPOLL_CTL_DEL, conn->client.sock, NULL);
+		loop->timers.cancel (&conn->timer);
+	}
+
+	void Reactor::checkParked (ReactorLoop *loop, ReactorConnection *conn, unsigned int events)
+	{
+		if (events & (EPOLLERR | EPOLLHUP)) {
+			// connection reset - nobody waits for response
+			closeConnection (loop, conn);
+			return;
+		}
+
+		// client has shut down sending only: request is served without keep-alive
+		conn->client.isReadClosed = true;
+		epoll_ctl (loop->epollFd, EPOLL_CTL_DEL, conn->client.sock, NULL);
+	}
+
+	bool Reactor::passConnection (ReactorLoop *loop, ReactorConnection *conn)
+	{
+		Server *server = loop->reactor->server();
+
+		ClientInfo client;
+		client.swap (conn->client);
+		client.initialData.swap (conn->data);
+
+		try
+		{
+			// workers use blocking sockets with SO_RCVTIMEO/SO_SNDTIMEO
+			setNonBlocking (client.sock, false);
+			
+			if (!server->dispatchClient (client)) {
+				// all workers are busy - connection is kept
+				conn->data.swap (client.initialData);
+				conn->client.swap (client);
+				return false;
+			}
+
+		} catch (std::exception &ex)  {
+
+			server->logError ("Reactor: connection dispatching failed (%s): %s",
+				typeid(ex).name(), ex.what());
+
+			if (client.sock != INVALID_SOCKET) {
+				if (server->errorProcessProc())
+					server->errorProcessProc()(client.sock);
+				util::closeSocket (client.sock, false);
+			}
+		}
+
+		loop->connections.erase (conn);
+		delete conn;
+		return true;
+	}
+
+	void Reactor::closeConnection (ReactorLoop *loop, ReactorConnection *conn)
+	{
+		if (conn->isParked) {
+			loop->parked.erase (conn->parkedPos);
+			--loop->parkedCount;
+		}
+		
+		epoll_ctl (loop->epollFd, EPOLL_CTL_DEL, conn->client.sock, NULL);
+		util::closeSocket (conn->client.sock, false);
+
+		loop->connections.erase (conn);
+		loop->timers.cancel (&conn->timer);
+		delete conn;
+	}
+
+	void Reactor::updateTimer (ReactorLoop *loop, ReactorConnection *conn)
+	{
+		const timer_tick_type now = loop->timers.currentTick();
+		timer_tick_type delay = (timer_tick_type) util::max2 (conn->idleTimeout, 1);
+
+		// request header is started - slow clients are limited by header deadline
+		if (!conn->data.empty()) 
+		{
+			const int headerTimeout = loop->reactor->server()->settings().requestHeaderTimeout;
+			if (0 == conn->headerDeadline && headerTimeout > 0)
+				conn->headerDeadline = now + (timer_tick_type) headerTimeout;
+
+			if (0 != conn->headerDeadline)
+				delay = util::min2 (delay, (long) (conn->headerDeadline - now) > 0 ? 
+					conn->headerDeadline - now : (timer_tick_type) 1);
+		}
+
+		loop->timers.arm (&conn->timer, delay);
+	}
+
+	void Reactor::closeExpiredConnections (ReactorLoop *loop, const std::vector<TimerNode*> &expired)
+	{
+		std::vector<TimerNode*>::const_iterator it;
+		for (it = expired.begin(); it != expired.end(); ++it)
+		{
+			ReactorConnection *conn = (ReactorConnection*) (*it)->data;
+
+			if (conn->isParked)
+				loop->reactor->server()->logWarning ("Reactor: free worker waiting timeout expired, client IP: %s",
+					util::formatIpAddr (conn->client.ip).c_str());
+			else if (!conn->data.empty())
+				loop->reactor->server()->logDebug ("Reactor: request header reading timeout expired, client IP: %s",
+					util::formatIpAddr (conn->client.ip).c_str());
+
+			closeConnection (loop, conn);
+		}
+	}
+
+	//
+	//////////////////////////////////////////////////////////////////////////
+}
+
+#endif // __GNUC__
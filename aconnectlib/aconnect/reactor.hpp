@@ -0,0 +1,113 @@
+/*
+This file is part of [aconnect] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef ACONNECT_REACTOR_H
+#define ACONNECT_REACTOR_H
+
+#include <boost/utility.hpp>
+#include <boost/detail/atomic_count.hpp>
+#include <vector>
+
+#include "types.hpp"
+#include "error.hpp"
+
+namespace aconnect
+{
+	class Server;
+	struct ClientInfo;
+	struct ReactorLoop;
+	struct TimerNode;
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Reactor - epoll based connections reader (Linux only):
+	//	N threads own non-blocking client sockets until request header
+	//	is completely read, then connection is passed to server workers.
+	//	Reactor threads never wait for workers: when all of them are busy
+	//	connection is parked and dispatching is retried later,
+	//	parked connections count and waiting time are limited.
+	//	Idle and header reading timeouts are tracked by timer wheel.
+
+	class Reactor : private boost::noncopyable
+	{
+	public:
+		Reactor (Server *server, string_constref endMark = "\r\n\r\n");
+		~Reactor ();
+
+		// start 'loopsCount' reactor threads
+		void start (int loopsCount) throw (socket_error);
+		void stop ();
+
+		/**
+		* Pass client connection to reactor, socket will be owned by reactor
+		* until request header is read or 'idleTimeout' expired.
+		* @param[in]	client			Accepted client connection
+		* @param[in]	idleTimeout		Max time to wait data (sec)
+		*/
+		void add (const ClientInfo &client, int idleTimeout) throw (socket_error);
+
+		inline Server* server() const				{	return _server;		}
+		inline string_constref endMark() const		{	return _endMark;	}
+
+		static const int MaxHeaderSize = 64 * 1024;		// bytes
+		static const int ReadChunkSize = 8 * 1024;		// bytes
+		static const int MaxEventsCount = 256;
+		static const int TimerTickInterval = 1000;		// msec, timer wheel tick
+		static const int DispatchRetryInterval = 10;	// msec, parked connections dispatching retry
+		static const int MaxParkedCount = 1024;			// per reactor thread, connections above are rejected
+
+	protected:
+		static void run (ReactorLoop *loop);
+
+		static void registerIncoming (ReactorLoop *loop);
+		static void readConnection (ReactorLoop *loop, struct ReactorConnection *conn);
+		static void dispatchConnection (ReactorLoop *loop, struct ReactorConnection *conn);
+		// pass connection to worker, returns false when all workers are busy
+		static bool passConnection (ReactorLoop *loop, struct ReactorConnection *conn);
+		static void dispatchParked (ReactorLoop *loop);
+		// parked connection keeps its timer and is watched for disconnection
+		static void parkConnection (ReactorLoop *loop, struct ReactorConnection *conn, bool atFront);
+		static void unparkConnection (ReactorLoop *loop, struct ReactorConnection *conn);
+		static void checkParked (ReactorLoop *loop, struct ReactorConnection *conn, unsigned int events);
+		static void closeConnection (ReactorLoop *loop, struct ReactorConnection *conn);
+		
+		// arm connection timer: idle timeout or request header deadline
+		static void updateTimer (ReactorLoop *loop, struct ReactorConnection *conn);
+		static void closeExpiredConnections (ReactorLoop *loop, const std::vector<TimerNode*> &expired);
+
+	// fields
+	protected:
+		Server	*_server;
+		string	_endMark;
+		std::vector<ReactorLoop*> _loops;
+		boost::detail::atomic_count _nextLoop;
+	};
+
+	//
+	//////////////////////////////////////////////////////////////////////////
+}
+
+#endif // ACONNECT_REACTOR_H
@@ -0,0 +1,162 @@
+/*
+This file is part of [aconnect] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef ACONNECT_RING_BUFFER_H
+#define ACONNECT_RING_BUFFER_H
+
+#include <boost/utility.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "types.hpp"
+#include "util.atomic.hpp"
+
+namespace aconnect
+{
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Bounded lock-free MPMC queue (D. Vyukov's algorithm),
+	//	items are moved in/out by T::swap - no allocation on push/pop.
+
+	template <typename T>
+	class RingBuffer : private boost::noncopyable
+	{
+	public:
+		// capacity is rounded up to power of 2
+		explicit RingBuffer (size_t capacity) :
+			_capacity (roundCapacity (capacity)),
+			_mask (_capacity - 1),
+			_cells (new Cell[_capacity]),
+			_pushPos (0),
+			_popPos (0)
+		{
+			for (size_t ndx = 0; ndx < _capacity; ++ndx)
+				_cells[ndx].sequence = (atomic_type) ndx;
+		}
+
+		// 'item' is swapped with empty cell value, returns false when buffer is full
+		bool tryPush (T &item)
+		{
+			Cell *cell;
+			atomic_type pos = util::atomicLoad (&_pushPos);
+
+			while (true)
+			{
+				cell = &_cells[pos & _mask];
+				atomic_type diff = distance (util::atomicLoad (&cell->sequence), pos);
+
+				if (0 == diff) {
+					if (util::atomicCompareExchange (&_pushPos, pos, pos + 1))
+						break;
+					pos = util::atomicLoad (&_pushPos);
+
+				} else if (diff < 0) {
+					return false;
+
+				} else {
+					pos = util::atomicLoad (&_pushPos);
+				}
+			}
+
+			cell->value.swap (item);
+			util::atomicStore (&cell->sequence, pos + 1);
+			return true;
+		}
+
+		// 'item' receives queued value, returns false when buffer is empty
+		bool tryPop (T &item)
+		{
+			Cell *cell;
+			atomic_type pos = util::atomicLoad (&_popPos);
+
+			while (true)
+			{
+				cell = &_cells[pos & _mask];
+				atomic_type diff = distance (util::atomicLoad (&cell->sequence), pos + 1);
+
+				if (0 == diff) {
+					if (util::atomicCompareExchange (&_popPos, pos, pos + 1))
+						break;
+					pos = util::atomicLoad (&_popPos);
+
+				} else if (diff < 0) {
+					return false;
+
+				} else {
+					pos = util::atomicLoad (&_popPos);
+				}
+			}
+
+			item.swap (cell->value);
+			util::atomicStore (&cell->sequence, pos + (atomic_type) _mask + 1);
+			return true;
+		}
+
+		inline size_t capacity() const		{	return _capacity;	}
+
+		// approximate items count
+		inline size_t size() const	{
+			atomic_type count = distance (util::atomicLoad (&_pushPos), util::atomicLoad (&_popPos));
+			return count > 0 ? (size_t) count : 0;
+		}
+
+	protected:
+		struct Cell
+		{
+			volatile atomic_type	sequence;
+			T						value;
+		};
+
+		// difference with counters overflow support
+		inline static atomic_type distance (atomic_type first, atomic_type second) {
+			return (atomic_type) ((unsigned long) first - (unsigned long) second);
+		}
+
+		inline static size_t roundCapacity (size_t capacity) {
+			size_t res = 2;
+			while (res < capacity)
+				res <<= 1;
+			return res;
+		}
+
+	// fields
+	protected:
+		const size_t _capacity;
+		const size_t _mask;
+		boost::scoped_array<Cell> _cells;
+
+		// push and pop positions are placed in separate cache lines
+		char _pad0[64];
+		volatile atomic_type _pushPos;
+		char _pad1[64];
+		volatile atomic_type _popPos;
+		char _pad2[64];
+	};
+
+	//
+	//////////////////////////////////////////////////////////////////////////
+}
+
+#endif // ACONNECT_RING_BUFFER_H
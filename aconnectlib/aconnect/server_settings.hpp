@@ -40,10 +40,16 @@ namespace aconnect
 		bool			reuseAddr;
 		bool			enablePooling;
 		int				workersCount;
+		int				listenersCount;			// SO_REUSEPORT listening sockets count
+		bool			preSpawnWorkers;
+		int				pendingQueueSize;
+		bool			enableReactor;			// epoll reactor mode (Linux only)
+		int				reactorThreadsCount;
 
 		int		workerLifeTime;			// sec
 		int		socketReadTimeout;		// sec
 		int		socketWriteTimeout;		// sec
+		int		requestHeaderTimeout;	// sec, reactor mode
 
 		string	resolvedHostName;
 
@@ -54,9 +60,15 @@ namespace aconnect
 			reuseAddr (false),		// SO_REUSEADDR flag setup on server socket
 			enablePooling (true),	// show whether create worker-threads pool or not
 			workersCount (500),		// maximum worker-threads count
+			listenersCount (1),		// listening sockets count, each one has own accept thread and workers group
+			preSpawnWorkers (false),// start all worker-threads at once, shed connections when queue is full
+			pendingQueueSize (0),	// pending connections queue size in pre-spawned mode, 0 - workers count
+			enableReactor (false),	// read request headers in reactor threads, not in workers
+			reactorThreadsCount (2),// reactor threads count (each owns epoll descriptor)
 			workerLifeTime (300),	// thread in pool lifetime
 			socketReadTimeout (60),	// server socket SO_RCVTIMEO timeout
-			socketWriteTimeout (60) // server socket SO_SNDTIMEO timeout
+			socketWriteTimeout (60),// server socket SO_SNDTIMEO timeout
+			requestHeaderTimeout (30)// max time to read request header in reactor mode, 0 - not limited
 		{ 
 			memcpy (ip, network::DefaultLocalIpAddress, ARRAY_SIZE(ip) * sizeof(byte_type));
 		}
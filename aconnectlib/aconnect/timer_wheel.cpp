@@ -0,0 +1,153 @@
+/*
+This file is part of [aconnect] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "lib_file_begin.inl"
+
+#include <assert.h>
+
+#include "util.hpp"
+#include "timer_wheel.hpp"
+
+namespace aconnect
+{
+	TimerWheel::TimerWheel (timer_tick_type currentTick) :
+		_currentTick (currentTick),
+		_size (0)
+	{
+		for (int level = 0; level < LevelsCount; ++level) {
+			for (size_t ndx = 0; ndx < SlotsCount; ++ndx)
+				_slots[level][ndx].prev = _slots[level][ndx].next = &_slots[level][ndx];
+		}
+	}
+
+	TimerWheel::~TimerWheel ()
+	{
+		// disarm pending timers, nodes are owned by callers
+		for (int level = 0; level < LevelsCount; ++level) {
+			for (size_t ndx = 0; ndx < SlotsCount; ++ndx) {
+				TimerNode *head = &_slots[level][ndx];
+				while (head->next != head)
+					unlink (head->next);
+			}
+		}
+	}
+
+	void TimerWheel::arm (TimerNode *node, timer_tick_type delay)
+	{
+		assert (node);
+
+		if (node->isArmed())
+			cancel (node);
+
+		node->expireTick = _currentTick + util::min2 (util::max2 (delay, (timer_tick_type) 1), MaxDelay);
+		place (node);
+		++_size;
+	}
+
+	void TimerWheel::cancel (TimerNode *node)
+	{
+		assert (node);
+		if (!node->isArmed())
+			return;
+
+		unlink (node);
+		--_size;
+	}
+
+	size_t TimerWheel::advance (timer_tick_type tick, std::vector<TimerNode*> &expired)
+	{
+		size_t expiredCount = 0;
+
+		while (_currentTick != tick && (long) (tick - _currentTick) > 0)
+		{
+			++_currentTick;
+
+			// lower level wrapped - move timers from next slot of upper level
+			for (int level = 1; level < LevelsCount; ++level) {
+				if ((_currentTick & ((1UL << (level * LevelBits)) - 1)) != 0)
+					break;
+				cascade (level, (_currentTick >> (level * LevelBits)) & SlotMask);
+			}
+
+			TimerNode *head = &_slots[0][_currentTick & SlotMask];
+			while (head->next != head) {
+				TimerNode *node = head->next;
+				unlink (node);
+				--_size;
+
+				expired.push_back (node);
+				++expiredCount;
+			}
+		}
+
+		return expiredCount;
+	}
+
+	void TimerWheel::place (TimerNode *node)
+	{
+		const timer_tick_type delay = node->expireTick - _currentTick;
+		
+		int level = 0;
+		while (level < LevelsCount - 1 && delay >= (1UL << ((level + 1) * LevelBits)))
+			++level;
+
+		link (&_slots[level][(node->expireTick >> (level * LevelBits)) & SlotMask], node);
+	}
+
+	void TimerWheel::cascade (int level, size_t slotNdx)
+	{
+		TimerNode *head = &_slots[level][slotNdx];
+		if (head->next == head)
+			return;
+		
+		// detach list first - nodes can be placed to the same slot again
+		TimerNode *node = head->next;
+		head->prev->next = NULL;
+		head->prev = head->next = head;
+
+		while (node) {
+			TimerNode *next = node->next;
+			node->prev = node->next = NULL;
+			place (node);
+			node = next;
+		}
+	}
+
+	void TimerWheel::link (TimerNode *head, TimerNode *node)
+	{
+		node->prev = head->prev;
+		node->next = head;
+		head->prev->next = node;
+		head->prev = node;
+	}
+
+	void TimerWheel::unlink (TimerNode *node)
+	{
+		node->prev->next = node->next;
+		node->next->prev = node->prev;
+		node->prev = node->next = NULL;
+	}
+}
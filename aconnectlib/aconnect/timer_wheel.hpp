@@ -0,0 +1,105 @@
+/*
+This file is part of [aconnect] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef ACONNECT_TIMER_WHEEL_H
+#define ACONNECT_TIMER_WHEEL_H
+
+#include <vector>
+#include <boost/utility.hpp>
+
+#include "types.hpp"
+
+namespace aconnect
+{
+	typedef unsigned long timer_tick_type;
+
+	// timer entry, must be embedded into owner object - no allocation on arm/cancel
+	struct TimerNode
+	{
+		TimerNode *prev;
+		TimerNode *next;
+		timer_tick_type expireTick;
+		void *data;			// owner object
+
+		TimerNode (void *owner = NULL) : prev (NULL), next (NULL), expireTick (0), data (owner) { }
+		
+		inline bool isArmed() const	{	return next != NULL;	}
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Hierarchical timer wheel: 4 levels of 64 slots, O(1) arm and cancel,
+	//	timers of higher levels are cascaded down when lower level wraps.
+	//	Not thread-safe, owned by one thread (reactor loop for example).
+
+	class TimerWheel : private boost::noncopyable
+	{
+	public:
+		explicit TimerWheel (timer_tick_type currentTick = 0);
+		~TimerWheel ();
+
+		/**
+		* Arm (or re-arm) timer
+		* @param[in]	node		Timer entry
+		* @param[in]	delay		Ticks count before expiration, at least 1 tick is used
+		*/
+		void arm (TimerNode *node, timer_tick_type delay);
+		void cancel (TimerNode *node);
+
+		/**
+		* Move wheel to 'tick', expired timers are disarmed and added to 'expired'
+		* @return	expired timers count
+		*/
+		size_t advance (timer_tick_type tick, std::vector<TimerNode*> &expired);
+
+		inline timer_tick_type currentTick() const	{	return _currentTick;	}
+		inline size_t size() const					{	return _size;			}
+
+		static const int LevelBits = 6;
+		static const int LevelsCount = 4;
+		static const timer_tick_type SlotsCount = 1 << LevelBits;
+		static const timer_tick_type SlotMask = SlotsCount - 1;
+		static const timer_tick_type MaxDelay = (1UL << (LevelBits * LevelsCount)) - 1;
+
+	protected:
+		void place (TimerNode *node);
+		void cascade (int level, size_t slotNdx);
+
+		static void link (TimerNode *head, TimerNode *node);
+		static void unlink (TimerNode *node);
+
+	// fields
+	protected:
+		timer_tick_type _currentTick;
+		size_t _size;
+		TimerNode _slots[LevelsCount][SlotsCount];	// list heads
+	};
+
+	//
+	//////////////////////////////////////////////////////////////////////////
+}
+
+#endif // ACONNECT_TIMER_WHEEL_H
@@ -0,0 +1,166 @@
+/*
+This file is part of [aconnect] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "lib_file_begin.inl"
+
+#if defined (__GNUC__)
+#	include <ctime>
+#	include <unistd.h>
+#	include <sys/syscall.h>
+#	include <linux/futex.h>
+#endif
+
+#include "util.time.hpp"
+#include "util.atomic.hpp"
+
+namespace aconnect
+{
+#if defined (__GNUC__)
+	namespace
+	{
+		inline timespec monotonicTime ()
+		{
+			timespec now;
+			clock_gettime (CLOCK_MONOTONIC, &now);
+			return now;
+		}
+
+		inline int futexWait (volatile int *addr, int expected, const timespec *timeout)
+		{
+			return (int) syscall (SYS_futex, addr, FUTEX_WAIT_PRIVATE, expected, timeout, NULL, 0);
+		}
+
+		inline int futexWake (volatile int *addr, int count)
+		{
+			return (int) syscall (SYS_futex, addr, FUTEX_WAKE_PRIVATE, count, NULL, NULL, 0);
+		}
+	}
+#endif
+
+	void Semaphore::post ()
+	{
+		// there is waiting thread
+		if (util::atomicAdd (&_count, 1) <= 0)
+			wakeOne ();
+	}
+
+	bool Semaphore::timedWait (int timeoutSec)
+	{
+		if (util::atomicAdd (&_count, -1) >= 0)
+			return true;
+
+		if (waitWakeup (timeoutSec))
+			return true;
+
+		// timeout expired - cancel waiting
+		while (true)
+		{
+			atomic_type count = util::atomicLoad (&_count);
+
+			if (count < 0) {
+				if (util::atomicCompareExchange (&_count, count, count + 1))
+					return false;
+
+			} else {
+				// wake up is already posted for current thread - consume it
+				waitWakeup (-1);
+				return true;
+			}
+		}
+	}
+
+#if defined (__GNUC__)
+
+	void Semaphore::wakeOne ()
+	{
+		__sync_add_and_fetch (&_wakeups, 1);
+		futexWake (&_wakeups, 1);
+	}
+
+	bool Semaphore::waitWakeup (int timeoutSec)
+	{
+		timespec deadline = monotonicTime ();
+		deadline.tv_sec += timeoutSec;
+
+		while (true)
+		{
+			int wakeups = _wakeups;
+			if (wakeups > 0) {
+				if (__sync_bool_compare_and_swap (&_wakeups, wakeups, wakeups - 1))
+					return true;
+				continue;
+			}
+
+			if (timeoutSec < 0) {
+				futexWait (&_wakeups, 0, NULL);
+				continue;
+			}
+
+			timespec now = monotonicTime (),
+				remaining;
+			remaining.tv_sec = deadline.tv_sec - now.tv_sec;
+			remaining.tv_nsec = deadline.tv_nsec - now.tv_nsec;
+			if (remaining.tv_nsec < 0) {
+				remaining.tv_nsec += 1000000000L;
+				--remaining.tv_sec;
+			}
+
+			if (remaining.tv_sec < 0)
+				return false;
+
+			futexWait (&_wakeups, 0, &remaining);
+		}
+	}
+
+#else
+
+	void Semaphore::wakeOne ()
+	{
+		boost::mutex::scoped_lock lock (_mutex);
+		++_wakeups;
+		_condition.notify_one();
+	}
+
+	bool Semaphore::waitWakeup (int timeoutSec)
+	{
+		boost::mutex::scoped_lock lock (_mutex);
+		boost::xtime deadline = util::createTimePeriod (timeoutSec);
+
+		while (_wakeups == 0)
+		{
+			if (timeoutSec < 0)
+				_condition.wait (lock);
+			else if (!_condition.timed_wait (lock, deadline) && _wakeups == 0)
+				return false;
+		}
+
+		--_wakeups;
+		return true;
+	}
+
+#endif
+
+}
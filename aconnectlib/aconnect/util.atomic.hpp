@@ -0,0 +1,131 @@
+/*
+This file is part of [aconnect] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef ACONNECT_ATOMIC_UTIL_H
+#define ACONNECT_ATOMIC_UTIL_H
+
+#if defined (WIN32)
+#	include <windows.h>
+#endif
+
+#include <boost/utility.hpp>
+#include <boost/thread.hpp>
+
+#include "types.hpp"
+
+namespace aconnect
+{
+	typedef long atomic_type;
+
+	namespace util
+	{
+		// full memory barrier
+		inline void memoryBarrier ()
+		{
+#if defined (WIN32)
+			MemoryBarrier ();
+#else
+			__sync_synchronize ();
+#endif
+		}
+
+		// load with acquire semantic
+		inline atomic_type atomicLoad (const volatile atomic_type *value)
+		{
+			atomic_type res = *value;
+			memoryBarrier ();
+			return res;
+		}
+
+		// store with release semantic
+		inline void atomicStore (volatile atomic_type *value, atomic_type newValue)
+		{
+			memoryBarrier ();
+			*value = newValue;
+		}
+
+		// returns new value
+		inline atomic_type atomicAdd (volatile atomic_type *value, atomic_type delta)
+		{
+#if defined (WIN32)
+			return InterlockedExchangeAdd (value, delta) + delta;
+#else
+			return __sync_add_and_fetch (value, delta);
+#endif
+		}
+
+		inline bool atomicCompareExchange (volatile atomic_type *value,
+			atomic_type expected, atomic_type newValue)
+		{
+#if defined (WIN32)
+			return InterlockedCompareExchange (value, newValue, expected) == expected;
+#else
+			return __sync_bool_compare_and_swap (value, expected, newValue);
+#endif
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Counting semaphore: lock-free post/wait when count allows it,
+	//	waiting threads are parked on futex (Linux) or on condition variable.
+
+	class Semaphore : private boost::noncopyable
+	{
+	public:
+		Semaphore () : _count (0), _wakeups (0) { }
+
+		void post ();
+
+		/**
+		* Wait for semaphore signal
+		* @param[in]	timeoutSec		Max time to wait (sec), negative value - infinite wait
+		* @return	false when timeout expired
+		*/
+		bool timedWait (int timeoutSec);
+
+		inline atomic_type waitersCount () const	{
+			atomic_type count = util::atomicLoad (&_count);
+			return count < 0 ? -count : 0;
+		}
+
+	protected:
+		void wakeOne ();
+		bool waitWakeup (int timeoutSec);
+
+	// fields
+	protected:
+		volatile atomic_type	_count;		// negative value - waiting threads count
+		volatile int			_wakeups;	// posted but not consumed wake ups
+
+#if !defined (__GNUC__)
+		boost::mutex _mutex;
+		boost::condition_variable_any _condition;
+#endif
+	};
+}
+
+#endif // ACONNECT_ATOMIC_UTIL_H
@@ -52,50 +52,66 @@ namespace algo = boost::algorithm;
 
 namespace 
 {
-	inline bool isSafeForUrlPart (aconnect::char_type ch) {
-		/*
-		if ((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') )
-		return true;
-		if (ch == '.' || ch == '-' || ch == '_' || ch == '\'')
-		return true;
-		return false;
-		*/
-
-		static const bool validChars[] = { 
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, true,
-			false, false, false, false, false, true, true, false, true, true,
-			true, true, true, true, true, true, true, true, false, false,
-			false, false, false, false, false, true, true, true, true, true,
-			true, true, true, true, true, true, true, true, true, true,
-			true, true, true, true, true, true, true, true, true, true,
-			true, false, false, false, false, true, false, true, true, true,
-			true, true, true, true, true, true, true, true, true, true,
-			true, true, true, true, true, true, true, true, true, true,
-			true, true, true, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false, false, false, false, false, false,
-			false, false, false, false, false };
-			
-		return validChars [(unsigned char) ch];
+	static const aconnect::char_type HexList[] = "0123456789ABCDEF";
+
+	const aconnect::char_type UrlEncodedSymbols[] = { '%', '+' };
+	const aconnect::char_type HtmlSpecialSymbols[] = { '&', '<', '>' };
+
+	// max unsafe symbols count encoded to one append
+	const size_t EncodedRunLength = 64;
+
+	inline bool isUrlEncodedSymbol (aconnect::char_type ch) {
+		return ch == '%' || ch == '+';
+	}
+	inline bool isHtmlSpecialSymbol (aconnect::char_type ch) {
+		return ch == '&' || ch == '<' || ch == '>';
 	}
 
-	static const aconnect::char_type HexList[] = "0123456789ABCDEF";
+	// 'pos' points to '%'
+	inline aconnect::char_type decodeUrlSymbol (aconnect::string_constptr pos, aconnect::string_constptr end) 
+	{
+		using aconnect::util::parseHexSymbol;
+		
+		if (end - pos < 3)
+			throw std::out_of_range ("Invalid hex symbol");
+		return (aconnect::char_type) ((parseHexSymbol (pos[1]) << 4) + parseHexSymbol (pos[2]));
+	}
+
+	/**
+	* Decode [pos, end) to 'out', 'out' can point to source (in place decoding).
+	* Escapes going in a row are decoded without scanning - scan call costs more 
+	* than one symbol check on '%'-heavy data.
+	* @return		Decoded data end
+	*/
+	aconnect::char_type* decodeUrlTo (aconnect::char_type *out, 
+		aconnect::string_constptr pos, aconnect::string_constptr end)
+	{
+		while (pos != end)
+		{
+			if (!isUrlEncodedSymbol (*pos)) 
+			{
+				aconnect::string_constptr special = aconnect::util::findAnyOf (pos, end, 
+					UrlEncodedSymbols, ARRAY_SIZE (UrlEncodedSymbols));
+				
+				if (out != pos)
+					memmove (out, pos, special - pos);
+				out += special - pos;
+				pos = special;
+
+				if (pos == end)
+					break;
+			}
+
+			if (*pos == '+') {
+				*out++ = ' ';
+				pos += 1;
+			} else {
+				*out++ = decodeUrlSymbol (pos, end);
+				pos += 3;
+			}
+		}
 
-	inline void encodeUrlSymbol (aconnect::str_stream& in, aconnect::char_type ch) {
-		in << '%' << HexList[(ch >> 4) & 0xF] << HexList[ch & 0xF];
+		return out;
 	}
 }
 
@@ -184,45 +200,87 @@ namespace aconnect {
 	//
 	string decodeUrl (string_constref url) 
 	{
-		if (url.find('%') == string::npos && url.find('+') == string::npos)
+		string_constptr end = url.c_str() + url.size();
+		if (findAnyOf (url.c_str(), end, UrlEncodedSymbols, ARRAY_SIZE (UrlEncodedSymbols)) == end)
 			return url;
 
-		string::size_type pos = url.find ('%'), prevPos = 0;
-		str_stream res;
+		string res;
+		res.reserve (url.size());
+		appendDecodedUrl (res, url.c_str(), url.size());
+		
+		return res;
+	}
+
+	string encodeUrlPart (string_constref str)
+	{
+		string res;
+		res.reserve (str.size());
+		appendEncodedUrlPart (res, str.c_str(), str.size());
 		
-		do {
-			res << algo::replace_all_copy (url.substr (prevPos, pos - prevPos), "+", " ");
+		return res;
+	}
 
-			if (pos == string::npos)
-				break;
+	void appendDecodedUrl (string& target, string_constptr data, size_t size)
+	{
+		if (size == 0)
+			return;
+
+		// decoded data is not longer than source, it is written directly to 'target'
+		const size_t initialSize = target.size();
+		target.resize (initialSize + size);
+
+		try {
+			char_type *begin = &target[0];
+			target.resize (decodeUrlTo (begin + initialSize, data, data + size) - begin);
+		} catch (...) {
+			target.resize (initialSize);
+			throw;
+		}
+	}
+
+	size_t decodeUrlInPlace (char_type *data, size_t size)
+	{
+		string_constptr end = data + size, 
+			special;
 
-			char_type ch = (parseHexSymbol (url [pos + 1]) << 4 ) + parseHexSymbol (url [pos + 2]);
-			res << ch;
+		// escapes are checked before data changing - source is kept on error
+		for (special = findSymbol (data, end, '%'); special != end; )
+		{
+			decodeUrlSymbol (special, end);
+			special += 3;
 			
-			prevPos = pos + 3;
-			pos = url.find ('%', prevPos);
+			if (special != end && *special != '%')
+				special = findSymbol (special, end, '%');
+		}
 
-		} while ( true );
-		
-		return res.str();
+		return decodeUrlTo (data, data, end) - data;
 	}
 
-	string encodeUrlPart (string_constref str)
+	void appendEncodedUrlPart (string& target, string_constptr data, size_t size)
 	{
-		str_stream encodedUrl;
-		string::const_iterator it = str.begin(),
-			end = str.end();
+		string_constptr pos = data, 
+			end = data + size, 
+			unsafe;
+		char_type encoded[3 * EncodedRunLength];
 
-		while (it != end) 
+		while ((unsafe = findUrlUnsafe (pos, end)) != end) 
 		{
-			if (isSafeForUrlPart (*it))
-				encodedUrl << *it;
-			else
-				encodeUrlSymbol (encodedUrl, *it);
-			++it;
+			target.append (pos, unsafe - pos);
+
+			// unsafe symbols going in a row are encoded without scanning
+			size_t encodedSize = 0;
+			do {
+				encoded[encodedSize++] = '%';
+				encoded[encodedSize++] = HexList[(*unsafe >> 4) & 0xF];
+				encoded[encodedSize++] = HexList[*unsafe & 0xF];
+				++unsafe;
+			} while (unsafe != end && encodedSize < ARRAY_SIZE (encoded) && !isUrlSafe (*unsafe));
+
+			target.append (encoded, encodedSize);
+			pos = unsafe;
 		}
-				
-		return encodedUrl.str();
+		
+		target.append (pos, end - pos);
 	}
 
 	string getUtf8String (string_constref str) throw (std::runtime_error)
@@ -256,16 +314,44 @@ namespace aconnect {
 
 	string escapeHtml (string_constref str) 
 	{
-		using namespace boost::algorithm;
 		// javasript: String (s_).replace (/&/g, "&amp;").replace (/</g, "&lt;").replace (/>/g, "&gt;");	
+		string_constptr end = str.c_str() + str.size();
+		if (findAnyOf (str.c_str(), end, HtmlSpecialSymbols, ARRAY_SIZE (HtmlSpecialSymbols)) == end)
+			return str;
 
-		string result = replace_all_copy (str, "&", "&amp;");
-		replace_all (result, "<", "&lt;" );
-		replace_all (result, ">", "&gt;" );
+		string res;
+		res.reserve (str.size() + str.size() / 8);
+		appendEscapedHtml (res, str.c_str(), str.size());
 
-		return result;
+		return res;
 	};
 
+	void appendEscapedHtml (string& target, string_constptr data, size_t size)
+	{
+		string_constptr pos = data, 
+			end = data + size, 
+			special;
+
+		while ((special = findAnyOf (pos, end, HtmlSpecialSymbols, ARRAY_SIZE (HtmlSpecialSymbols))) != end) 
+		{
+			target.append (pos, special - pos);
+			
+			// special symbols going in a row are escaped without scanning
+			do {
+				switch (*special) {
+				case '&':	target.append ("&amp;", 5);		break;
+				case '<':	target.append ("&lt;", 4);		break;
+				default:	target.append ("&gt;", 4);		break;
+				}
+				++special;
+			} while (special != end && isHtmlSpecialSymbol (*special));
+			
+			pos = special;
+		}
+		
+		target.append (pos, end - pos);
+	}
+
 	void parseKeyValuePairs (string str, std::map<string, string>& pairs, 
 		string_constptr delimiter, string_constptr valueTrimSymbols)
 	{
@@ -30,10 +30,16 @@ distribution.
 #	include <signal.h>
 #elif defined (__GNUC__)
 #	include <sys/signal.h>
+#	include <sys/sendfile.h>
+#	include <sys/socket.h>
+#	include <sys/uio.h>
+#	include <fcntl.h>
+#	include <unistd.h>
 #endif  //__GNUC__
 
-#include <boost/scoped_array.hpp>
 #include <boost/algorithm/string.hpp>
+#include <boost/thread/tss.hpp>
+#include <vector>
 
 #include "util.hpp"
 #include "util.network.hpp"
@@ -49,6 +55,22 @@ namespace aconnect {
 	}
 
 	namespace util {
+
+	// per-thread reusable read buffer, grows on demand up to requested block size
+	static boost::thread_specific_ptr< std::vector<char_type> > threadReadBuffer;
+
+	inline std::vector<char_type>& getReadBuffer (size_t size)
+	{
+		std::vector<char_type> *buff = threadReadBuffer.get();
+		if (!buff) {
+			buff = new std::vector<char_type> ();
+			threadReadBuffer.reset (buff);
+		}
+
+		if (buff->size() < size)
+			buff->resize (size);
+		return *buff;
+	}
 	
 	// create socket with selected domain (Address family) and type
 	socket_type createSocket (int domain, int type) throw (socket_error)
@@ -104,16 +126,123 @@ namespace aconnect {
 		} while (bytesCount > 0);
 	};
 
+	void writeToSocket (socket_type s, const WriteBuffer *buffers, size_t count, bool hasMore) throw (socket_error)
+	{
+#if defined (__GNUC__)
+		const int MaxBlocksCount = 64;
+		struct iovec blocks[MaxBlocksCount];
+		size_t ndx = 0;
+
+		while (ndx < count)
+		{
+			int blocksCount = 0;
+			for (; ndx < count && blocksCount < MaxBlocksCount; ++ndx) {
+				if (0 == buffers[ndx].size)
+					continue;
+				blocks[blocksCount].iov_base = const_cast<char_type*> (buffers[ndx].data);
+				blocks[blocksCount].iov_len = buffers[ndx].size;
+				++blocksCount;
+			}
+
+			struct iovec *curBlock = blocks;
+			struct msghdr msg;
+			util::zeroMemory (&msg, sizeof (msg));
+			
+			const int flags = (hasMore || ndx < count) ? MSG_MORE : 0;
+
+			while (blocksCount > 0)
+			{
+				msg.msg_iov = curBlock;
+				msg.msg_iovlen = blocksCount;
+
+				ssize_t written = sendmsg (s, &msg, flags);
+				if (written == SOCKET_ERROR)
+					throw socket_error (s, "Writing data to socket");
+
+				// skip completely written blocks, then move start of partially written one
+				while (blocksCount > 0 && (size_t) written >= curBlock->iov_len) {
+					written -= curBlock->iov_len;
+					++curBlock;
+					--blocksCount;
+				}
+
+				if (blocksCount > 0) {
+					curBlock->iov_base = (char_type*) curBlock->iov_base + written;
+					curBlock->iov_len -= written;
+				}
+			}
+		}
+#else
+		for (size_t ndx = 0; ndx < count; ++ndx)
+			writeToSocket (s, buffers[ndx].data, (int) buffers[ndx].size);
+#endif
+	}
+
+	bool sendFileToSocket (socket_type s, string_constref filePath, 
+		std::streamsize offset, std::streamsize size) throw (socket_error)
+	{
+#if defined (__GNUC__)
+		int fd = open (filePath.c_str(), O_RDONLY);
+		if (fd == -1)
+			return false;
+
+		try {
+			bool res = sendFileToSocket (s, fd, offset, size);
+			close (fd);
+			return res;
+
+		} catch (...) {
+			close (fd);
+			throw;
+		}
+#else
+		return false;
+#endif
+	}
+
+	bool sendFileToSocket (socket_type s, int fileDescriptor, 
+		std::streamsize offset, std::streamsize size) throw (socket_error)
+	{
+#if defined (__GNUC__)
+		// Linux sends at most 0x7ffff000 bytes per call
+		const std::streamsize maxBlockSize = 1 << 30;
+
+		off_t pos = (off_t) offset;
+		std::streamsize bytesLeft = size;
+
+		while (bytesLeft > 0) 
+		{
+			ssize_t sent = sendfile (s, fileDescriptor, &pos, (size_t) min2 (bytesLeft, maxBlockSize));
+			
+			if (sent == SOCKET_ERROR) {
+				if (errno == EINTR)
+					continue;
+
+				// file system does not support sendfile - use buffered writing
+				if (bytesLeft == size && (errno == EINVAL || errno == ENOSYS))
+					return false;
+
+				throw socket_error (s, "Sending file to socket");
+			}
+
+			if (0 == sent)
+				throw socket_error (s, "Sending file to socket: file was truncated");
+
+			bytesLeft -= sent;
+		}
+
+		return true;
+#else
+		return false;
+#endif
+	}
+
 	string readFromSocket (socket_type s, 
 		SocketStateCheck &stateCheck, 
 		bool throwOnConnectionReset,
 		const int buffSize) throw (socket_error)
 	{
 		string data;
-		data.reserve (buffSize);
-
-		boost::scoped_array<char_type> buff (new char_type [buffSize]);
-		// zeroMemory (buff.get(), buffSize);
 		int bytesRead = 0;
 		
 		stateCheck.prepare (s);
@@ -121,12 +250,22 @@ namespace aconnect {
 		if (!stateCheck.isDataAvailable (s))
 			return data;
 
-		while ( (bytesRead = recv (s, buff.get(), buffSize, 0)) > 0 ) 
+		// start from small block, most of requests are read at once
+		int readSize = min2 (network::SocketReadInitialBufferSize, buffSize);
+		std::vector<char_type> &buff = getReadBuffer (readSize);
+
+		while ( (bytesRead = recv (s, &buff[0], readSize, 0)) > 0 ) 
 		{
-			data.append (buff.get(), bytesRead);
+			data.append (&buff[0], bytesRead);
 
 			if (stateCheck.readCompleted (s, data))
 				break;
+
+			// block was filled completely - read larger blocks
+			if (bytesRead == readSize && readSize < buffSize) {
+				readSize = min2 (readSize * 2, buffSize);
+				getReadBuffer (readSize);
+			}
 		}
 
 		if (bytesRead == SOCKET_ERROR) 
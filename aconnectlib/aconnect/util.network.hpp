@@ -63,7 +63,8 @@ namespace aconnect
 	{
 		extern ip_addr_type DefaultLocalIpAddress;
 
-		const int SocketReadBufferSize = 512*1024; // bytes
+		const int SocketReadBufferSize = 512*1024; // bytes, max read block size
+		const int SocketReadInitialBufferSize = 4*1024; // bytes, first read block size
 #if defined (WIN32)
 		const err_type ConnectionAbortCode = WSAECONNABORTED;
 		const err_type ConnectionResetCode = WSAECONNRESET;
@@ -103,6 +104,39 @@ namespace aconnect
 		void writeToSocket (socket_type s, string_constptr buff, const int buffLen, bool closeAtError = false) throw (socket_error);
 		string readFromSocket (const socket_type s, SocketStateCheck &stateCheck, bool throwOnConnectionReset = true, 
 				const int buffSize = network::SocketReadBufferSize) throw (socket_error);
+
+		// data block for scatter/gather writing
+		struct WriteBuffer
+		{
+			string_constptr		data;
+			size_t				size;
+		};
+
+		/*
+		*	Write several data blocks to socket by one system call (sendmsg on Linux)
+		*	@param[in]	s			Opened client socket
+		*	@param[in]	buffers		Data blocks to write, empty blocks are skipped
+		*	@param[in]	count		Blocks count
+		*	@param[in]	hasMore		More data will be written immediately - 
+		*							socket should not push partial frame (MSG_MORE on Linux)
+		*/
+		void writeToSocket (socket_type s, const WriteBuffer *buffers, size_t count, 
+				bool hasMore = false) throw (socket_error);
+
+		/*
+		*	Send file part to socket without copying it to user space (sendfile on Linux)
+		*	@param[in]	s			Opened client socket
+		*	@param[in]	filePath	Path to file to send
+		*	@param[in]	offset		Start position in file
+		*	@param[in]	size		Bytes count to send
+		*	@return		false when zero-copy sending is not available, nothing is sent in this case
+		*/
+		bool sendFileToSocket (socket_type s, string_constref filePath, 
+				std::streamsize offset, std::streamsize size) throw (socket_error);
+		
+		// the same for already opened file, descriptor stays opened
+		bool sendFileToSocket (socket_type s, int fileDescriptor, 
+				std::streamsize offset, std::streamsize size) throw (socket_error);
 		
 		inline void readIpAddress (ip_addr_type ip, const in_addr &addr) {
 #ifdef WIN32
@@ -0,0 +1,439 @@
+/*
+This file is part of [aconnect] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "lib_file_begin.inl"
+
+#include <algorithm>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#	define ACONNECT_SCAN_SSE2
+#	define ACONNECT_SCAN_AVX2
+#	include <immintrin.h>
+#	define SCAN_TARGET(isa) __attribute__ ((target (isa)))
+#elif defined (_MSC_VER) && (defined (_M_X64) || (defined (_M_IX86_FP) && _M_IX86_FP >= 2))
+#	define ACONNECT_SCAN_SSE2
+#	include <emmintrin.h>
+#	include <intrin.h>
+#	define SCAN_TARGET(isa)
+#endif
+
+#include "util.scan.hpp"
+
+namespace aconnect
+{
+	namespace
+	{
+		typedef string_constptr (*find_line_end_proc) (string_constptr, string_constptr);
+		typedef string_constptr (*find_sequence_proc) (string_constptr, string_constptr, string_constptr, size_t);
+		typedef string_constptr (*find_any_of_proc) (string_constptr, string_constptr, string_constptr, size_t);
+		typedef string_constptr (*find_url_unsafe_proc) (string_constptr, string_constptr);
+
+		struct ScanKernels
+		{
+			find_line_end_proc		findLineEnd;
+			find_sequence_proc		findSequence;
+			find_any_of_proc		findAnyOf;
+			find_url_unsafe_proc	findUrlUnsafe;
+			string_constptr			name;
+		};
+
+		// max symbols count for vectorized findAnyOf
+		const size_t MaxVectorSymbols = 4;
+
+		inline bool isLineEnd (char_type ch) {
+			return ch == '\r' || ch == '\n';
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//
+		//		Scalar kernels
+
+		string_constptr findLineEndScalar (string_constptr begin, string_constptr end)
+		{
+			while (begin != end && !isLineEnd (*begin))
+				++begin;
+			return begin;
+		}
+
+		string_constptr findSequenceScalar (string_constptr begin, string_constptr end,
+			string_constptr seq, size_t seqLength)
+		{
+			return std::search (begin, end, seq, seq + seqLength);
+		}
+
+		string_constptr findAnyOfScalar (string_constptr begin, string_constptr end,
+			string_constptr symbols, size_t symbolsCount)
+		{
+			return std::find_first_of (begin, end, symbols, symbols + symbolsCount);
+		}
+
+		string_constptr findUrlUnsafeScalar (string_constptr begin, string_constptr end)
+		{
+			while (begin != end && util::isUrlSafe (*begin))
+				++begin;
+			return begin;
+		}
+
+#if defined (ACONNECT_SCAN_SSE2)
+
+		inline int lowestBit (unsigned int mask)
+		{
+#	if defined (_MSC_VER)
+			unsigned long ndx;
+			_BitScanForward (&ndx, mask);
+			return (int) ndx;
+#	else
+			return __builtin_ctz (mask);
+#	endif
+		}
+
+		// candidates are filtered by the first and the last sequence symbols,
+		// see W. Mula "SIMD-friendly algorithms for substring searching"
+		inline string_constptr checkCandidates (unsigned int mask, string_constptr pos,
+			string_constptr seq, size_t seqLength)
+		{
+			while (mask != 0) {
+				const int bit = lowestBit (mask);
+				if (memcmp (pos + bit + 1, seq + 1, seqLength - 2) == 0)
+					return pos + bit;
+				mask &= mask - 1;
+			}
+			return NULL;
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		//
+		//		SSE2 kernels
+
+		SCAN_TARGET ("sse2") 
+		string_constptr findLineEndSse2 (string_constptr begin, string_constptr end)
+		{
+			const __m128i cr = _mm_set1_epi8 ('\r'),
+				lf = _mm_set1_epi8 ('\n');
+
+			for (; end - begin >= 16; begin += 16) {
+				const __m128i block = _mm_loadu_si128 ((const __m128i*) begin);
+				const unsigned int mask = (unsigned int) _mm_movemask_epi8 (
+					_mm_or_si128 (_mm_cmpeq_epi8 (block, cr), _mm_cmpeq_epi8 (block, lf)));
+				
+				if (mask != 0)
+					return begin + lowestBit (mask);
+			}
+
+			return findLineEndScalar (begin, end);
+		}
+
+		SCAN_TARGET ("sse2") 
+		string_constptr findSequenceSse2 (string_constptr begin, string_constptr end,
+			string_constptr seq, size_t seqLength)
+		{
+			if (seqLength < 2 || (size_t) (end - begin) < seqLength)
+				return findSequenceScalar (begin, end, seq, seqLength);
+			
+			const __m128i first = _mm_set1_epi8 (seq[0]),
+				last = _mm_set1_epi8 (seq[seqLength - 1]);
+			
+			for (; (size_t) (end - begin) >= seqLength - 1 + 16; begin += 16) {
+				const __m128i blockFirst = _mm_loadu_si128 ((const __m128i*) begin);
+				const __m128i blockLast = _mm_loadu_si128 ((const __m128i*) (begin + seqLength - 1));
+				
+				const unsigned int mask = (unsigned int) _mm_movemask_epi8 (
+					_mm_and_si128 (_mm_cmpeq_epi8 (blockFirst, first), _mm_cmpeq_epi8 (blockLast, last)));
+				
+				string_constptr res = checkCandidates (mask, begin, seq, seqLength);
+				if (res)
+					return res;
+			}
+
+			return findSequenceScalar (begin, end, seq, seqLength);
+		}
+
+		SCAN_TARGET ("sse2") 
+		string_constptr findAnyOfSse2 (string_constptr begin, string_constptr end,
+			string_constptr symbols, size_t symbolsCount)
+		{
+			if (symbolsCount > MaxVectorSymbols)
+				return findAnyOfScalar (begin, end, symbols, symbolsCount);
+			
+			// missing symbols are replaced by the first one
+			__m128i sym[MaxVectorSymbols];
+			for (size_t ndx = 0; ndx < MaxVectorSymbols; ++ndx)
+				sym[ndx] = _mm_set1_epi8 (symbols[ndx < symbolsCount ? ndx : 0]);
+
+			for (; end - begin >= 16; begin += 16) {
+				const __m128i block = _mm_loadu_si128 ((const __m128i*) begin);
+				const unsigned int mask = (unsigned int) _mm_movemask_epi8 (_mm_or_si128 (
+					_mm_or_si128 (_mm_cmpeq_epi8 (block, sym[0]), _mm_cmpeq_epi8 (block, sym[1])),
+					_mm_or_si128 (_mm_cmpeq_epi8 (block, sym[2]), _mm_cmpeq_epi8 (block, sym[3]))));
+				
+				if (mask != 0)
+					return begin + lowestBit (mask);
+			}
+
+			return findAnyOfScalar (begin, end, symbols, symbolsCount);
+		}
+
+		// 'from' <= value <= 'to', signed compare rejects symbols >= 0x80
+		SCAN_TARGET ("sse2") 
+		inline __m128i inRangeSse2 (__m128i block, char_type from, char_type to)
+		{
+			return _mm_and_si128 (_mm_cmpgt_epi8 (block, _mm_set1_epi8 (from - 1)), 
+				_mm_cmpgt_epi8 (_mm_set1_epi8 (to + 1), block));
+		}
+
+		SCAN_TARGET ("sse2") 
+		string_constptr findUrlUnsafeSse2 (string_constptr begin, string_constptr end)
+		{
+			for (; end - begin >= 16; begin += 16) {
+				const __m128i block = _mm_loadu_si128 ((const __m128i*) begin);
+				
+				const __m128i safe = _mm_or_si128 (
+					_mm_or_si128 (inRangeSse2 (block, '0', '9'), 
+						_mm_or_si128 (inRangeSse2 (block, 'A', 'Z'), inRangeSse2 (block, 'a', 'z'))),
+					_mm_or_si128 (
+						_mm_or_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ('.')), _mm_cmpeq_epi8 (block, _mm_set1_epi8 ('-'))),
+						_mm_or_si128 (_mm_cmpeq_epi8 (block, _mm_set1_epi8 ('_')), _mm_cmpeq_epi8 (block, _mm_set1_epi8 ('\'')))));
+				
+				const unsigned int mask = (unsigned int) _mm_movemask_epi8 (safe) ^ 0xFFFF;
+				if (mask != 0)
+					return begin + lowestBit (mask);
+			}
+
+			return findUrlUnsafeScalar (begin, end);
+		}
+
+#endif // ACONNECT_SCAN_SSE2
+
+#if defined (ACONNECT_SCAN_AVX2)
+
+		//////////////////////////////////////////////////////////////////////////
+		//
+		//		AVX2 kernels
+
+		SCAN_TARGET ("avx2") 
+		string_constptr findLineEndAvx2 (string_constptr begin, string_constptr end)
+		{
+			const __m256i cr = _mm256_set1_epi8 ('\r'),
+				lf = _mm256_set1_epi8 ('\n');
+
+			for (; end - begin >= 32; begin += 32) {
+				const __m256i block = _mm256_loadu_si256 ((const __m256i*) begin);
+				const unsigned int mask = (unsigned int) _mm256_movemask_epi8 (
+					_mm256_or_si256 (_mm256_cmpeq_epi8 (block, cr), _mm256_cmpeq_epi8 (block, lf)));
+				
+				if (mask != 0)
+					return begin + lowestBit (mask);
+			}
+
+			return findLineEndSse2 (begin, end);
+		}
+
+		SCAN_TARGET ("avx2") 
+		string_constptr findSequenceAvx2 (string_constptr begin, string_constptr end,
+			string_constptr seq, size_t seqLength)
+		{
+			if (seqLength < 2 || (size_t) (end - begin) < seqLength)
+				return findSequenceScalar (begin, end, seq, seqLength);
+			
+			const __m256i first = _mm256_set1_epi8 (seq[0]),
+				last = _mm256_set1_epi8 (seq[seqLength - 1]);
+			
+			for (; (size_t) (end - begin) >= seqLength - 1 + 32; begin += 32) {
+				const __m256i blockFirst = _mm256_loadu_si256 ((const __m256i*) begin);
+				const __m256i blockLast = _mm256_loadu_si256 ((const __m256i*) (begin + seqLength - 1));
+				
+				const unsigned int mask = (unsigned int) _mm256_movemask_epi8 (
+					_mm256_and_si256 (_mm256_cmpeq_epi8 (blockFirst, first), _mm256_cmpeq_epi8 (blockLast, last)));
+				
+				string_constptr res = checkCandidates (mask, begin, seq, seqLength);
+				if (res)
+					return res;
+			}
+
+			return findSequenceSse2 (begin, end, seq, seqLength);
+		}
+
+		SCAN_TARGET ("avx2") 
+		string_constptr findAnyOfAvx2 (string_constptr begin, string_constptr end,
+			string_constptr symbols, size_t symbolsCount)
+		{
+			if (symbolsCount > MaxVectorSymbols)
+				return findAnyOfScalar (begin, end, symbols, symbolsCount);
+			
+			__m256i sym[MaxVectorSymbols];
+			for (size_t ndx = 0; ndx < MaxVectorSymbols; ++ndx)
+				sym[ndx] = _mm256_set1_epi8 (symbols[ndx < symbolsCount ? ndx : 0]);
+
+			for (; end - begin >= 32; begin += 32) {
+				const __m256i block = _mm256_loadu_si256 ((const __m256i*) begin);
+				const unsigned int mask = (unsigned int) _mm256_movemask_epi8 (_mm256_or_si256 (
+					_mm256_or_si256 (_mm256_cmpeq_epi8 (block, sym[0]), _mm256_cmpeq_epi8 (block, sym[1])),
+					_mm256_or_si256 (_mm256_cmpeq_epi8 (block, sym[2]), _mm256_cmpeq_epi8 (block, sym[3]))));
+				
+				if (mask != 0)
+					return begin + lowestBit (mask);
+			}
+
+			return findAnyOfSse2 (begin, end, symbols, symbolsCount);
+		}
+
+		SCAN_TARGET ("avx2") 
+		inline __m256i inRangeAvx2 (__m256i block, char_type from, char_type to)
+		{
+			return _mm256_and_si256 (_mm256_cmpgt_epi8 (block, _mm256_set1_epi8 (from - 1)), 
+				_mm256_cmpgt_epi8 (_mm256_set1_epi8 (to + 1), block));
+		}
+
+		SCAN_TARGET ("avx2") 
+		string_constptr findUrlUnsafeAvx2 (string_constptr begin, string_constptr end)
+		{
+			for (; end - begin >= 32; begin += 32) {
+				const __m256i block = _mm256_loadu_si256 ((const __m256i*) begin);
+				
+				const __m256i safe = _mm256_or_si256 (
+					_mm256_or_si256 (inRangeAvx2 (block, '0', '9'), 
+						_mm256_or_si256 (inRangeAvx2 (block, 'A', 'Z'), inRangeAvx2 (block, 'a', 'z'))),
+					_mm256_or_si256 (
+						_mm256_or_si256 (_mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ('.')), _mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ('-'))),
+						_mm256_or_si256 (_mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ('_')), _mm256_cmpeq_epi8 (block, _mm256_set1_epi8 ('\'')))));
+				
+				const unsigned int mask = ~ (unsigned int) _mm256_movemask_epi8 (safe);
+				if (mask != 0)
+					return begin + lowestBit (mask);
+			}
+
+			return findUrlUnsafeSse2 (begin, end);
+		}
+
+#endif // ACONNECT_SCAN_AVX2
+
+		// fill 'kernels' by 'name' instruction set, false if it is not supported
+		bool loadKernels (ScanKernels &kernels, string_constptr name)
+		{
+			if (strcmp (name, "scalar") == 0) {
+				ScanKernels scalar = { findLineEndScalar, findSequenceScalar, 
+					findAnyOfScalar, findUrlUnsafeScalar, "scalar" };
+				kernels = scalar;
+				return true;
+			}
+
+#if defined (ACONNECT_SCAN_AVX2)
+			__builtin_cpu_init ();
+			if (strcmp (name, "avx2") == 0) {
+				if (!__builtin_cpu_supports ("avx2"))
+					return false;
+
+				kernels.findLineEnd = findLineEndAvx2;
+				kernels.findSequence = findSequenceAvx2;
+				kernels.findAnyOf = findAnyOfAvx2;
+				kernels.findUrlUnsafe = findUrlUnsafeAvx2;
+				kernels.name = "avx2";
+				return true;
+			}
+			if (!__builtin_cpu_supports ("sse2"))
+				return false;
+#endif
+
+#if defined (ACONNECT_SCAN_SSE2)
+			if (strcmp (name, "sse2") == 0) {
+				kernels.findLineEnd = findLineEndSse2;
+				kernels.findSequence = findSequenceSse2;
+				kernels.findAnyOf = findAnyOfSse2;
+				kernels.findUrlUnsafe = findUrlUnsafeSse2;
+				kernels.name = "sse2";
+				return true;
+			}
+#endif
+			return false;
+		}
+
+		ScanKernels selectKernels ()
+		{
+			ScanKernels kernels;
+			if (!loadKernels (kernels, "avx2") && !loadKernels (kernels, "sse2"))
+				loadKernels (kernels, "scalar");
+			
+			return kernels;
+		}
+
+		// scalar kernels are constant-initialized: code running at static initialization of 
+		// other translation units can call scan functions before CPU features are checked
+		ScanKernels Kernels = { findLineEndScalar, findSequenceScalar, 
+			findAnyOfScalar, findUrlUnsafeScalar, "scalar" };
+
+		const bool KernelsSelected = (Kernels = selectKernels (), true);
+	}
+
+	namespace util
+	{
+		string_constptr findLineEnd (string_constptr begin, string_constptr end)
+		{
+			return Kernels.findLineEnd (begin, end);
+		}
+
+		string_constptr findSequence (string_constptr begin, string_constptr end,
+			string_constptr seq, size_t seqLength)
+		{
+			if (0 == seqLength)
+				return begin;
+			if (1 == seqLength)
+				return findSymbol (begin, end, seq[0]);
+
+			return Kernels.findSequence (begin, end, seq, seqLength);
+		}
+
+		string_constptr findAnyOf (string_constptr begin, string_constptr end, 
+			string_constptr symbols, size_t symbolsCount)
+		{
+			if (0 == symbolsCount)
+				return end;
+			if (1 == symbolsCount)
+				return findSymbol (begin, end, symbols[0]);
+
+			return Kernels.findAnyOf (begin, end, symbols, symbolsCount);
+		}
+
+		string_constptr findUrlUnsafe (string_constptr begin, string_constptr end)
+		{
+			return Kernels.findUrlUnsafe (begin, end);
+		}
+
+		string_constptr scanInstructionSet ()
+		{
+			return Kernels.name;
+		}
+
+		bool useInstructionSet (string_constptr name)
+		{
+			ScanKernels kernels;
+			if (!loadKernels (kernels, name))
+				return false;
+
+			Kernels = kernels;
+			return true;
+		}
+	}
+}
@@ -0,0 +1,94 @@
+/*
+This file is part of [aconnect] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef ACONNECT_SCAN_UTIL_H
+#define ACONNECT_SCAN_UTIL_H
+
+#include <cstring>
+#include "types.hpp"
+
+namespace aconnect 
+{
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Fast buffer scanning: SSE2/AVX2 kernels are selected at runtime
+	//	by CPU capabilities, scalar versions are used on other platforms.
+
+	namespace util 
+	{
+		// returns 'end' when symbol is not found
+		inline string_constptr findSymbol (string_constptr begin, string_constptr end, char_type symbol)
+		{
+			// C runtime implementation is already vectorized
+			string_constptr res = (string_constptr) memchr (begin, symbol, end - begin);
+			return res ? res : end;
+		}
+
+		// find first '\r' or '\n', returns 'end' when not found
+		string_constptr findLineEnd (string_constptr begin, string_constptr end);
+
+		// find sequence in [begin, end), returns 'end' when not found
+		string_constptr findSequence (string_constptr begin, string_constptr end,
+			string_constptr seq, size_t seqLength);
+
+		// std::string::find replacement
+		inline string::size_type findString (string_constref input, string_constref seq, 
+			string::size_type startPos = 0)
+		{
+			if (startPos > input.size())
+				return string::npos;
+
+			string_constptr begin = input.c_str(), 
+				end = begin + input.size();
+			string_constptr res = findSequence (begin + startPos, end, seq.c_str(), seq.size());
+			
+			return res == end && !seq.empty() ? string::npos : res - begin;
+		}
+
+		// find first of 'symbols' (up to 4 symbols are vectorized), returns 'end' when not found
+		string_constptr findAnyOf (string_constptr begin, string_constptr end, 
+			string_constptr symbols, size_t symbolsCount);
+
+		// symbol is not encoded in URL part: [0-9A-Za-z] and "'-._"
+		inline bool isUrlSafe (char_type ch) {
+			return (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') 
+				|| ch == '.' || ch == '-' || ch == '_' || ch == '\'';
+		}
+
+		// find first symbol that must be encoded in URL part: 
+		// all except [0-9A-Za-z] and "'-._", returns 'end' when not found
+		string_constptr findUrlUnsafe (string_constptr begin, string_constptr end);
+
+		// name of used instruction set: "avx2", "sse2" or "scalar"
+		string_constptr scanInstructionSet ();
+
+		// tests and benchmarks: use kernels of 'name' instruction set, it is not thread-safe,
+		// returns false when the set is not supported by CPU or build
+		bool useInstructionSet (string_constptr name);
+	}
+}
+
+#endif // ACONNECT_SCAN_UTIL_H
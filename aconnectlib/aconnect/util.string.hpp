@@ -35,6 +35,7 @@ distribution.
 #include "types.hpp"
 #include "complex_types.hpp"
 #include "error.hpp"
+#include "util.scan.hpp"
 
 namespace aconnect 
 {
@@ -67,6 +68,18 @@ namespace aconnect
 		string encodeUrlPart (string_constref str);
 		
 		string escapeHtml (string_constref str);
+
+		/**
+		* Single pass versions: result is appended to 'target', 
+		* parts without special symbols are copied by one append.
+		*/
+		void appendDecodedUrl (string& target, string_constptr data, size_t size);
+		void appendEncodedUrlPart (string& target, string_constptr data, size_t size);
+		void appendEscapedHtml (string& target, string_constptr data, size_t size);
+
+		// decode URL in place, returns decoded data size (not greater than 'size'),
+		// data is not changed when std::out_of_range is thrown
+		size_t decodeUrlInPlace (char_type *data, size_t size);
 		
 		inline string escapeHtml (string_constptr str) 
 		{
@@ -120,25 +133,21 @@ namespace aconnect
 			string_constptr delimiter = ";",
 			string_constptr valueTrimSymbols = "\"");
 
+		// finds sequence or its beginning at the end of input
 		inline string::size_type findSequence (string_constref input, string_constref seq)
 		{
 			assert (seq.size() && "Empty sequence to find");
 
-			string::size_type startPos = -1;
-			do {
-				startPos = input.find (seq[0], startPos + 1);
-				if (startPos == string::npos)
-					return string::npos;
-
-				string::const_iterator it, seqIt;
-				for ( it = input.begin() + startPos + 1, seqIt = seq.begin() + 1
-					; it != input.end() && seqIt != seq.end() && *it == *seqIt
-					; ++it, ++seqIt);
+			string::size_type startPos = findString (input, seq);
+			if (startPos != string::npos)
+				return startPos;
 
-				if (it == input.end() || seqIt == seq.end()) // found all symbols from sequence beginning
+			// check input tail - sequence can be split between read blocks
+			startPos = input.size() >= seq.size() ? input.size() - seq.size() + 1 : 0;
+			for (; startPos < input.size(); ++startPos) {
+				if (input.compare (startPos, string::npos, seq, 0, input.size() - startPos) == 0)
 					return startPos;
-
-			} while (startPos != string::npos);
+			}
 			
 			return string::npos;
 		}
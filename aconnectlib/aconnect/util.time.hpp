@@ -29,8 +29,10 @@ distribution.
 
 #if defined(WIN32)
 #	include <ctime>
+#	include <windows.h>
 #elif defined(__GNUC__)
 #	include <sys/time.h>
+#	include <time.h>
 #endif
 
 #include <boost/thread.hpp>
@@ -86,6 +88,18 @@ namespace aconnect
 			return xt;
 		}
 
+		// monotonic milliseconds counter, use difference of two values only
+		inline unsigned long getTickCount ()
+		{
+#ifdef WIN32
+			return ::GetTickCount ();
+#else
+			timespec now;
+			clock_gettime (CLOCK_MONOTONIC, &now);
+			return (unsigned long) now.tv_sec * 1000 + now.tv_nsec / 1000000;
+#endif
+		}
+
 	}
 }
 
@@ -36,6 +36,14 @@ distribution.
 
 #include <assert.h>
 
+#if defined (__GNUC__)
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <cerrno>
+#endif
+
 #include "aconnect/util.string.hpp"
 #include "aconnect/util.time.hpp"
 #include "aconnect/util.file.hpp"
@@ -43,6 +51,7 @@ distribution.
 #include "aconnect/error.hpp"
 
 #include "ahttplib.hpp"
+#include "ahttp/http_multipart.hpp"
 
 
 namespace fs = boost::filesystem;
@@ -132,14 +141,22 @@ namespace ahttp
 		GlobalSettings (globalSettings),
 		Log (log),
 		CurrentDirectoryInfo (NULL),
-		IsKeepAliveConnect (false)
+		IsKeepAliveConnect (false),
+		_postDataLoaded (false)
 	{
 		assert (clientInfo);
 		assert (globalSettings);
 		assert (log);
+
+		std::fill (_serverVariablesLoaded, _serverVariablesLoaded + ServerVariable::Count, false);
 	}
 
 	HttpContext::~HttpContext()
+	{
+		removeUploadedFiles ();
+	}
+
+	void HttpContext::removeUploadedFiles ()
 	{
 		std::map <string, UploadFileInfo>::const_iterator iter;
 		for (iter = UploadedFiles.begin(); iter != UploadedFiles.end(); ++iter)
@@ -151,6 +168,7 @@ namespace ahttp
 			}
 		}
 		
+		UploadedFiles.clear();
 	}
 
 	bool HttpContext::init (bool isKeepAliveConnect,
@@ -159,7 +177,17 @@ namespace ahttp
 		HttpHeaderReadCheck check (&RequestHeader, Client->server, 
 			isKeepAliveConnect, keepAliveTimeoutSec);
 
-		string requestBodyBegin = aconnect::util::readFromSocket (Client->sock, check, false);
+		string requestBodyBegin;
+		if (!Client->initialData.empty()) {
+			// request header is already read by reactor
+			requestBodyBegin.swap (Client->initialData);
+			check.prepare (Client->sock);
+			check.readCompleted (Client->sock, requestBodyBegin);
+		
+		} else {
+			requestBodyBegin = aconnect::util::readFromSocket (Client->sock, check, false);
+		}
+
 		if (check.connectionWasClosed() || requestBodyBegin.empty())
 			return false;
 
@@ -173,8 +201,11 @@ namespace ahttp
 		return true;
 	}
 
-	void HttpContext::reset () 
+	void HttpContext::reset (const aconnect::ClientInfo* clientInfo) 
 	{
+		if (clientInfo)
+			Client = clientInfo;
+
 		RequestHeader.clear();
 		RequestStream.clear();
 		Response.clear();
@@ -182,13 +213,33 @@ namespace ahttp
 		GetParameters.clear();
 		PostParameters.clear();
 		Cookies.clear();
+		Items.clear();
+		InternalItems.clear();
 		
-		UploadedFiles.clear();
+		removeUploadedFiles();
+		FileSystemInfo.reset();
 		
 		Method = HttpMethod::Unknown;
+		InitialVirtualPath.clear();
+		VirtualPath.clear();
+		QueryString.clear();
+		FileSystemPath = boost::filesystem::path();
+		UploadsDirPath = boost::filesystem::path();
 
 		CurrentDirectoryInfo  = NULL;
 		IsKeepAliveConnect = false;
+
+		// cached values strings are kept to reuse allocated memory
+		std::fill (_serverVariablesLoaded, _serverVariablesLoaded + ServerVariable::Count, false);
+
+		_queryParameters.reset();
+		_cookieParameters.reset();
+		_postParameters.reset();
+		_postDataLoaded = false;
+
+		_postData.clear();
+		if (_postData.capacity() > defaults::ReadBufferSize)
+			std::vector<aconnect::char_type>().swap (_postData);
 	}
 	
 	void HttpContext::setHtmlResponse() {
@@ -224,52 +275,98 @@ namespace ahttp
 		Client->close(closeSocket);
 	}
 
-	void HttpContext::parseQueryStringParams ()
+	void HttpContext::setQueryString (string_constptr data, size_t size)
 	{
-		using namespace aconnect;
-		if (QueryString.empty())
-			return;
+		// parameters keep offsets in the old value, same-length assignment
+		// can reuse its buffer, so isLoadedFrom() check does not catch it
+		QueryString.assign (data, size);
+		_queryParameters.reset();
+	}
 
-		str_vector pairs;
-		size_t pos;
-		algo::split (pairs, QueryString, boost::algorithm::is_any_of("&"), algo::token_compress_on);
+	const RequestParameters& HttpContext::queryParameters ()
+	{
+		if (!_queryParameters.isLoadedFrom (QueryString.data(), QueryString.size()))
+			_queryParameters.load (QueryString.data(), QueryString.size(), '&');
 
-		for (str_vector::iterator it = pairs.begin() ; it != pairs.end(); ++it) {
-			pos = it->find ('=');
-			if (pos == string::npos) {
-				GetParameters[util::decodeUrl(*it)] = "";
-			} else {
-				GetParameters[util::decodeUrl(it->substr (0, pos))] = util::decodeUrl(it->substr (pos + 1));
-			}
-		}
+		return _queryParameters;
 	}
 
-	void HttpContext::parseCookies () {
+	const RequestParameters& HttpContext::cookieParameters ()
+	{
 		// HTTP header: "Cookie: PART_NUMBER=RIDING_ROCKET_0023; PART_NUMBER=ROCKET_LAUNCHER_0001"
-		using namespace aconnect;
-		if ( !RequestHeader.hasHeader (strings::HeaderCookie) )
-			return;
+		if (!_cookieParameters.isLoaded()) {
+			string_constptr cookies = NULL;
+			size_t cookiesSize = 0;
+			
+			RequestHeader.getHeaderValue (RequestHeaderCookie, cookies, cookiesSize);
+			_cookieParameters.load (cookies, cookiesSize, ';', true);
+		}
 
-		string cookiesString = RequestHeader.getHeader(strings::HeaderCookie);
-		
-		str_vector pairs;
-		algo::split (pairs, cookiesString, boost::algorithm::is_any_of(";"), algo::token_compress_on);
+		return _cookieParameters;
+	}
 
-		for (str_vector::iterator it = pairs.begin() ; it != pairs.end(); ++it) {
-			string::size_type pos = it->find ('=');
-			if (pos == string::npos) {
-				Cookies [util::decodeUrl(*it)] = "";
-			} else {
-				Cookies [util::decodeUrl(it->substr (0, pos))] = util::decodeUrl(it->substr (pos + 1));
-			}
-		}
+	void HttpContext::parseQueryStringParams ()
+	{
+		queryParameters().copyTo (GetParameters);
+	}
+
+	void HttpContext::parseCookies () 
+	{
+		cookieParameters().copyTo (Cookies);
 	}
 
 	void HttpContext::loadPostParams() 
+	{
+		loadPostData ();
+		_postParameters.copyTo (PostParameters);
+	}
+
+	void HttpContext::skipPostData () 
+	{
+		const int SkipBufferSize = 8 * 1024;
+		aconnect::char_type buff[SkipBufferSize];
+
+		while (!RequestStream.isRead() && RequestStream.read (buff, SkipBufferSize) > 0)
+			;
+
+		_postDataLoaded = true;
+	}
+
+	bool HttpContext::findQueryParameter (string_constref name, string& value)
+	{
+		return queryParameters().find (name, value);
+	}
+
+	bool HttpContext::findCookie (string_constref name, string& value)
+	{
+		return cookieParameters().find (name, value);
+	}
+
+	bool HttpContext::findPostParameter (string_constref name, string& value)
+	{
+		loadPostData ();
+		
+		if (_postParameters.isLoaded())
+			return _postParameters.find (name, value);
+		
+		// multipart form fields are loaded to map
+		aconnect::str2str_map::const_iterator iter = PostParameters.find (name);
+		if (iter == PostParameters.end())
+			return false;
+
+		value = iter->second;
+		return true;
+	}
+
+	void HttpContext::loadPostData () 
 	{
 		using namespace aconnect;
 
-		string contentType = RequestHeader.getHeader(strings::HeaderContentType);
+		if (_postDataLoaded)
+			return;
+		_postDataLoaded = true;
+
+		string contentType = RequestHeader.getHeader (RequestHeaderContentType);
 		
 		if (algo::istarts_with (contentType, strings::ContentTypeMultipartFormData) ) {
 			
@@ -279,93 +376,248 @@ namespace ahttp
 			return loadMultipartFormData (boundary);
 		}
 		
-		if (RequestHeader.ContentLength == 0)
+		if (RequestHeader.ContentLength == 0 || RequestStream.isRead())
 			return;
 
-		const int buffSize = (int) util::min2 (Response.Stream.getBufferSize(), RequestHeader.ContentLength);
-		boost::scoped_array<char_type> buff (new char_type [buffSize]);
-		
-		//util::zeroMemory ( (void*) buff.get(), buffSize);
-		
-		int readBytes = 0, pos = 0;
+		// form data is indexed in place, buffer is kept until reset()
+		const size_t buffSize = RequestStream.ContentLength - RequestStream.getLoadedContentLength();
+		_postData.resize (buffSize);
+		char_type *buff = &_postData[0];
 		
-		string key, val;
-		char_type ch;
-		bool keyLoaded = false;
-		size_t loadedContentLength = 0;
+		size_t loadedSize = 0;
+		int readBytes = 0;
 		
-		val.reserve (buffSize);
+		while (loadedSize < buffSize
+			&& (readBytes = RequestStream.read (buff + loadedSize, (int) (buffSize - loadedSize))) > 0) {
+				loadedSize += readBytes;
+		}
 		
-		do 
+		// buffer is writable - parameters are decoded in place
+		_postParameters.loadWritable (buff, loadedSize, '&');
+	}
+
+	
+	namespace
+	{
+		// uploaded file written by direct descriptor writes (unbuffered stream on other platforms)
+		class UploadFile : private boost::noncopyable
+		{
+		public:
+#if defined (__GNUC__)
+			UploadFile () : _fd (-1) { }
+			
+			inline bool isOpen() const	{	return _fd != -1;	}
+
+			// 'path' must not exist
+			bool open (string_constref path) {
+				_fd = ::open (path.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 
+					S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+				return isOpen();
+			}
+
+			bool write (string_constptr data, size_t size) {
+				while (size > 0) {
+					ssize_t written = ::write (_fd, data, size);
+					if (written < 0 && errno == EINTR)
+						continue;
+					if (written <= 0)
+						return false;
+					
+					data += written;
+					size -= (size_t) written;
+				}
+				return true;
+			}
+
+			void close () {
+				if (_fd != -1)
+					::close (_fd);
+				_fd = -1;
+			}
+		protected:
+			int _fd;
+#else
+			UploadFile () : _file (NULL) { }
+			
+			inline bool isOpen() const	{	return _file != NULL;	}
+
+			bool open (string_constref path) {
+				if (aconnect::util::fileExists (path))
+					return false;
+				
+				_file = fopen (path.c_str(), "wb");
+				if (_file)
+					setvbuf (_file, NULL, _IONBF, 0);
+				return isOpen();
+			}
+
+			bool write (string_constptr data, size_t size) {
+				return fwrite (data, 1, size, _file) == size;
+			}
+
+			void close () {
+				if (_file)
+					fclose (_file);
+				_file = NULL;
+			}
+		protected:
+			FILE *_file;
+#endif
+		public:
+			~UploadFile () {
+				close ();
+			}
+		};
+
+		// stores multipart form fields to context, file parts are written to uploads directory
+		class MultipartFormLoader : public MultipartHandler
 		{
-			readBytes = RequestStream.read((string_ptr) buff.get(), buffSize);
-			loadedContentLength += readBytes;
+		public:
+			MultipartFormLoader (HttpContext &context) : 
+				_context (context),
+				_fieldValue (NULL),
+				_uploadedFile (NULL),
+				_aborted (false)
+			{
+				time_t curTime = time(NULL);
+				srand ( (unsigned) curTime);
+
+				_timestamp = boost::str(boost::format("%016.X") % curTime);
+			}
+
+			inline bool isAborted() const				{	return _aborted;		}
+			inline string_constref errorMessage() const	{	return _errorMessage;	}
 
-			if (readBytes > 0) 
+			virtual void onPartBegin (string_constref header) 
 			{
-				pos = 0;
+				_info.loadHeader (header);
+				_fieldName = aconnect::util::decodeUrl (_info.name);
+				_fieldValue = NULL;
+				_uploadedFile = NULL;
+
+				if ( !_info.isFileData ) {
+					if (canStore())
+						_fieldValue = &_context.PostParameters [_fieldName];
+					return;
+				}
+
+				// open file to store uploaded item
+				if (canStore() && !_info.fileName.empty() && !openFile()) 
+					return;
 
-				while (pos < readBytes) {
-					ch = buff[pos++];
+				_uploadedFile = &_context.UploadedFiles[_fieldName];
+				*_uploadedFile = _info;
+			}
+
+			virtual void onPartData (string_constptr data, size_t size)
+			{
+				if (_aborted || !canStore())
+					return;
+
+				if (_fieldValue) {
+					_fieldValue->append (data, size);
+				
+				} else if (_file.isOpen()) {
 					
-					if ( ch == '&' && !key.empty() ) {
-						PostParameters [util::decodeUrl(key)] = util::decodeUrl (val);
-						key.clear();
-						val.clear();
-						keyLoaded = false;
+					if (!_file.write (data, size)) {
+						_context.Log->error ("Upload file writing failed: %s", _info.uploadPath.c_str());
+						_errorMessage += "Cannot store upload file: " +  _info.shortFileName + "\r\n";
+						_file.close();
 					
-					} else if (ch == '=') {
-						keyLoaded = true;
+					} else if (_uploadedFile) {
+						_uploadedFile->fileSize += size;
+					}
+				}
+			}
+
+			virtual void onPartEnd ()
+			{
+				_file.close();
+				_fieldValue = NULL;
+				_uploadedFile = NULL;
+			}
+
+		protected:
+			inline bool canStore () {
+				return !_context.isClosed() && !_context.Response.isFinished();
+			}
+
+			bool openFile ()
+			{
+				try
+				{
+					if (_context.UploadsDirPath.empty()) 
+					{
+						if (!_context.GlobalSettings->globalUploadsDirectory().empty()) {
+							_context.UploadsDirPath = fs::path(_context.GlobalSettings->globalUploadsDirectory(), fs::native);
+
+						} else {
+							_context.Log->error ("Uploads folder is not set up, uploaded files will be skipped, target: %s", 
+								_context.VirtualPath.c_str());
+							return true;
+						}
+					}
+
+					// unique name is checked by exclusive file creation
+					string storedFileName = _timestamp;
+					fs::path uploadPath;
+					int tryCount = 0; 
+					const int maxTryCount = _context.GlobalSettings->uploadCreationTriesCount(); 
+
+					do {
+						uploadPath = _context.UploadsDirPath / storedFileName;
+						storedFileName = _timestamp + boost::str(boost::format("_%08.X") % rand());
+
+					} while (!_file.open (uploadPath.file_string()) && ++tryCount < maxTryCount);
+
+					if (!_file.isOpen()) {
+						_context.Log->error ("Cannot create upload file: %s", uploadPath.file_string().c_str());
+						_errorMessage += "Cannot store upload file: " +  _info.shortFileName + "\r\n";
+
+						_info.isFileData = false;
+						_info.uploadPath.clear ();
 					
-					} else if (keyLoaded) {
-						val.append(1, ch);
 					} else {
-						key.append(1, ch);
+						_info.uploadPath = uploadPath.normalize().file_string();
 					}
-				
-				};
-			
-			} else if (!key.empty() && loadedContentLength == RequestHeader.ContentLength) {
-				PostParameters [util::decodeUrl(key)] = util::decodeUrl (val);
+
+				} catch (...) {
+					_info.isFileData = false;
+					_info.uploadPath.clear ();
+					_aborted = true;
+
+					_context.processException("Uploaded file storing");
+					return false;
+				}
+
+				return true;
 			}
-		
-		} while (readBytes > 0);
-		
+
+		// fields
+		protected:
+			HttpContext &_context;
+			UploadFileInfo _info;
+			UploadFile _file;
+			string _fieldName;
+			string *_fieldValue;
+			UploadFileInfo *_uploadedFile;
+			string _timestamp;
+			string _errorMessage;
+			bool _aborted;
+		};
 	}
 
-	
 	void HttpContext::loadMultipartFormData (string_constref boundary) 
 	{
 		using namespace aconnect;
 
-		const int buffSize = (int) util::min2 (Response.Stream.getBufferSize(), RequestHeader.ContentLength);
-
-		boost::scoped_array<char_type> buff (new char_type [buffSize]);
+		MultipartParser parser (boundary, defaults::ReadBufferSize);
+		MultipartFormLoader loader (*this);
 
 		int readBytes = 0;
-		string record, fieldName;
-		size_t boundaryPos = 0, 
-			endPos = 0, 
-			readContentLength = 0;
-		fs::path uploadPath;
-		
-		const string boundaryBegin = strings::MultipartBoundaryPrefix + boundary;
-		const string boundaryBeginWithEndMark = string(strings::HeadersDelimiter) + strings::MultipartBoundaryPrefix + boundary;
-		const string boundaryEnd = strings::MultipartBoundaryPrefix + boundary + strings::MultipartBoundaryPrefix;
-
-		const size_t boundOffset = (boundaryBegin + strings::HeadersDelimiter).size();
-		const size_t endMarkLen = strlen (strings::HeadersEndMark);
-		const size_t headerEndMarkLen = strlen (strings::HeadersDelimiter);
-
-		UploadFileInfo uploadInfo;
-		std::ofstream currentFile;
-		string storedFileName,
-				errorMessage;
-
-		time_t curTime = time(NULL);
-		srand ( (unsigned) curTime);
-
-		string timestamp = boost::str(boost::format("%016.X") % curTime);
+		size_t readContentLength = 0,
+			freeSize = 0;
+		char_type *buff;
 
 		size_t maxRequestSize = defaults::MaxRequestSize;
 		if (CurrentDirectoryInfo)
@@ -373,7 +625,8 @@ namespace ahttp
 
 		do 
 		{
-			readBytes = RequestStream.read (buff.get(), buffSize);
+			buff = parser.buffer (freeSize);
+			readBytes = RequestStream.read (buff, (int) freeSize);
 			
 			readContentLength += readBytes;
 
@@ -382,179 +635,27 @@ namespace ahttp
 				throw request_too_large_error (readContentLength, 
 					maxRequestSize);
 		
-			record.append (buff.get(), readBytes);
-			boundaryPos = record.find (boundaryBegin);
-
-			
-			while (record.length()) 
-			{
-				// start reading
-				if (boundaryPos == 0 
-					&& (endPos = record.find (strings::HeadersEndMark, 0)) != string::npos) 
-				{
-					if (currentFile.is_open()) {
-						currentFile.flush();
-						currentFile.rdbuf()->close();
-					}
-
-					uploadInfo.loadHeader (record.substr(boundOffset, endPos - boundOffset));
-					fieldName = util::decodeUrl (uploadInfo.name);
-
-					record.erase(0, endPos + endMarkLen);
-					boundaryPos = util::findSequence (record, boundaryBeginWithEndMark);
-					
-					if ( !uploadInfo.isFileData ) {
-						if (!isClosed() && !Response.isFinished())
-							PostParameters [fieldName] += record.substr (0, boundaryPos);
+			parser.consume (readBytes, loader);
 			
-					} else {
-						
-						// open file stream to store uploaded item
-						if (!isClosed() && !Response.isFinished() && !uploadInfo.fileName.empty() ) 
-						{
-							storedFileName = timestamp;
-
-							try
-							{
-								if (UploadsDirPath.empty()) 
-								{
-									if (!GlobalSettings->globalUploadsDirectory().empty()) {
-										UploadsDirPath = fs::path(GlobalSettings->globalUploadsDirectory(), fs::native);
-
-									} else {
-										Log->error ("Uploads folder is not set up, uploaded files will be skipped, target: %s", 
-											VirtualPath.c_str());
-									}
-								}
-							
-								if (!UploadsDirPath.empty()) 
-								{
-									// fast upload name search
-									
-									do {
-										uploadPath = UploadsDirPath / storedFileName;
-										storedFileName = timestamp + boost::str(boost::format("_%08.X") % rand());
-									
-									} while (fs::exists (uploadPath));
-
-									// open file
-									int tryCount = 0; 
-									
-									const int maxTryCount = GlobalSettings->uploadCreationTriesCount(); 
-
-									do {
-										uploadPath = UploadsDirPath / storedFileName;
-										currentFile.open ( uploadPath.file_string().c_str(), std::ios::out | std::ios::binary );
-										storedFileName = timestamp + boost::str(boost::format("_%08.X") % rand());
-
-									} while ((currentFile.fail() || currentFile.bad()) && ++tryCount < maxTryCount);
-								
-									if (tryCount >= maxTryCount) {
-										Log->error ("Cannot create upload file: %s", uploadPath.file_string().c_str());
-										errorMessage = "Cannot store upload file: " +  uploadInfo.shortFileName + "\r\n";
-										
-										uploadInfo.isFileData = false;
-										uploadInfo.uploadPath.clear ();
-									}
-
-									if (currentFile.good())
-										uploadInfo.uploadPath = uploadPath.normalize().file_string();
-								}
-
-							} catch (...) {
-								uploadInfo.isFileData = false;
-								uploadInfo.uploadPath.clear ();
-
-								return processException("Uploaded file storing");
-							}
-							
-							if (currentFile.good() && record.size()) 
-								currentFile << record.substr (0, boundaryPos);
-							
-						}
-
-						UploadedFiles[fieldName] = uploadInfo;
-					}
-
-					record.erase(0, boundaryPos);
-					boundaryPos = 0;
-				
-				} else if (!fieldName.empty() && boundaryPos != 0 && boundaryPos != string::npos) {
-					
-					if (!isClosed() && !Response.isFinished())
-					{
-						if ( !uploadInfo.isFileData ) {
-							PostParameters [fieldName] += record.substr (0, boundaryPos - headerEndMarkLen);
-						} else if (currentFile.good()) {
-							currentFile << record.substr (0, boundaryPos - headerEndMarkLen);
-						}
-					}
-					
-					record.erase(0, boundaryPos);
-					boundaryPos = 0;
-
-				} else { 
-					
-					
-					if (!isClosed() 
-						&& !Response.isFinished()
-						&& uploadInfo.isFileData
-						&& currentFile.good()
-						&& currentFile.is_open()
-						&& util::findSequence (record, boundaryBeginWithEndMark) == string::npos
-						&& util::findSequence (record, boundaryBegin) == string::npos) 
-					{
-						currentFile << record;
-						record.clear();
-									
-					} else {
-						break;
-					}
-				}
-				
-				if (record.find (boundaryEnd) == 0) {
-					// eat request
-					while (!RequestStream.isRead() && readBytes > 0)
-						readBytes = RequestStream.read (buff.get(), buffSize);
-					
-					readBytes = 0;
-					break;
+			if (loader.isAborted())
+				return;
+
+			if (parser.isFinished()) {
+				// eat request
+				while (!RequestStream.isRead() && readBytes > 0) {
+					buff = parser.buffer (freeSize);
+					readBytes = RequestStream.read (buff, (int) freeSize);
 				}
+				break;
 			}
 			
 		} while (readBytes > 0);
 
-		if (currentFile.is_open()) {
-			currentFile.flush();
-			currentFile.rdbuf()->close();
-		}
-
-		if (!errorMessage.empty())
-			return HttpServer::processServerError(*this, HttpStatus::InternalServerError, errorMessage.c_str() );
-
-		if (isClosed())
-			return;
-				
-		// read files info
-		std::map <string, UploadFileInfo>::iterator iter;
-		for (iter = UploadedFiles.begin(); iter != UploadedFiles.end(); ++iter)
-		{
-			if (iter->second.uploadPath.empty())
-				continue;
+		loader.onPartEnd();
 
-			try	{
-				iter->second.fileSize = (size_t) 
-					fs::file_size (iter->second.uploadPath);
-			
-			} catch (...)  {
-				iter->second.isFileData = false;
-				iter->second.uploadPath.clear ();
-
-				return processException ("Uploaded file properties loading failed");
-			}
-		}
+		if (!loader.errorMessage().empty())
+			return HttpServer::processServerError(*this, HttpStatus::InternalServerError, loader.errorMessage().c_str() );
 	}
-
 	void HttpContext::processException (string_constptr message, bool sendResponse,  HttpStatus::HttpStatusType status)
 	{
 		if (Log)
@@ -668,76 +769,112 @@ namespace ahttp
 	string HttpContext::getServerVariable (string_constptr variableName)
 	{
 		using namespace aconnect;
-		using namespace strings::ServerVariables;
-		str2str_map::const_iterator iter;
 		
 		if (util::isNullOrEmpty(variableName))
 			throw request_processing_error ("Empty variable name to load, path: %s",
 				VirtualPath.c_str());
 
-		// non-cacheable vars
+		ServerVariable::ServerVariableType variableType = getServerVariableType (variableName);
+		if (variableType != ServerVariable::Unknown)
+			return getServerVariable (variableType);
+
+		// user-defined variable
+		str2str_map::const_iterator iter = Items.find(variableName);
+		if (iter != Items.end() )
+			return iter->second;
+
+		return string();
+	}
+
+	string HttpContext::getServerVariable (ServerVariable::ServerVariableType variableType)
+	{
+		using namespace aconnect;
 		
-		if (util::equals (variableName, APPL_PHYSICAL_PATH)) {
+		if (variableType < 0 || variableType >= ServerVariable::Count)
+			throw request_processing_error ("Invalid server variable type: %d, path: %s",
+				(int) variableType, VirtualPath.c_str());
+
+		// non-cacheable vars
+		switch (variableType)
+		{
+		case ServerVariable::ApplPhysicalPath:
 			return mapPath("/");
 		
-		} else if (util::equals (variableName, CONTENT_LENGTH)) {
+		case ServerVariable::ContentLength:
 			if (RequestHeader.isContentLengthRead())
 				return boost::lexical_cast<string> (RequestHeader.ContentLength);
+			break;
 		
-		} else if (util::equals (variableName, CONTENT_TYPE)) {
+		case ServerVariable::ContentType:
 			if (Response.Header.hasHeader (strings::HeaderContentType))
 				return Response.Header.Headers[strings::HeaderContentType];
+			break;
 	
-		} else if (util::equals (variableName, PATH_INFO) 
-			|| util::equals (variableName, SCRIPT_NAME)
-			|| util::equals (variableName, URL)) {
-			
-				if ((iter = Items.find(URL_ENCODED)) != Items.end()) {
-					if (util::equals (iter->second, VirtualPath))
-						return Items[URL];
-				}
-				
-				Items[URL_ENCODED] = VirtualPath;
-				Items[URL] =  util::decodeUrl(VirtualPath);
+		case ServerVariable::PathInfo:
+		case ServerVariable::ScriptName:
+		case ServerVariable::Url:
+			// decoded URL is cached while VirtualPath is not changed
+			if (!_serverVariablesLoaded[ServerVariable::Url] 
+				|| _serverVariables[ServerVariable::UrlEncoded] != VirtualPath) 
+			{
+				_serverVariables[ServerVariable::UrlEncoded] = VirtualPath;
+				_serverVariables[ServerVariable::Url].clear();
+				util::appendDecodedUrl (_serverVariables[ServerVariable::Url], VirtualPath.c_str(), VirtualPath.size());
+				_serverVariablesLoaded[ServerVariable::Url] = true;
+			}
+			return _serverVariables[ServerVariable::Url];
 
-				return Items[URL];
+		case ServerVariable::UrlEncoded:
+			return VirtualPath;
 
-		} else if (util::equals (variableName, PATH_INFO_RELATIVE)) {
+		case ServerVariable::PathInfoRelative:
 			return  (VirtualPath.size() && VirtualPath[0] == '/' ? VirtualPath.substr(1) : VirtualPath);
 					
-		} else if (util::equals (variableName, PATH_TRANSLATED)) {
-			string filePath = FileSystemPath.file_string();
+		case ServerVariable::PathTranslated:
+			{
+				string filePath = FileSystemPath.file_string();
 #ifdef WIN32
-			std::replace (filePath.begin(), filePath.end(), '/', '\\');
+				std::replace (filePath.begin(), filePath.end(), '/', '\\');
 #endif
-			return  filePath;
+				return  filePath;
+			}
 		
-		} else if (util::equals (variableName, QUERY_STRING)) {
+		case ServerVariable::QueryString:
 			return  QueryString;
 		
-		} else if (util::equals (variableName, REQUEST_METHOD)) {
+		case ServerVariable::RequestMethod:
 			return  RequestHeader.Method;
 
+		default:
+			break;
 		}
 
-		iter = Items.find(variableName);
-		if (iter != Items.end() )
-			return iter->second;
+		// values stored by modules
+		if (!Items.empty()) {
+			str2str_map::const_iterator iter = Items.find (getServerVariableName (variableType));
+			if (iter != Items.end() )
+				return iter->second;
+		}
+
+		if (_serverVariablesLoaded[variableType])
+			return _serverVariables[variableType];
 
 		// setup defauts
-		string var;
+		string &var = _serverVariables[variableType];
+		var.clear();
 
-		if (util::equals (variableName, ALL_RAW)) {
-			
-			var.reserve (RequestHeader.Headers.size() * 64);
-			aconnect::str2str_map_ci::const_iterator it = RequestHeader.Headers.begin();
+		switch (variableType)
+		{
+		case ServerVariable::AllRaw:
+			var.reserve (RequestHeader.headersCount() * 64);
 			
-			for (; it != RequestHeader.Headers.end(); ++it) {
-				var.append (it->first);
+			for (size_t ndx = 0; ndx < RequestHeader.headersCount(); ++ndx) {
+				var.append (RequestHeader.headerName (ndx));
 				var.append (": ");
-				var.append (it->second);
+				var.append (RequestHeader.headerValue (ndx));
 				var.append ("\r\n");
 			}
+			break;
 
 		/*
 			Should be stored by modules:
@@ -745,83 +882,106 @@ namespace ahttp
 				CERT_COOKIE, CERT_FLAGS, CERT_ISSUER, CERT_KEYSIZE, CERT_SECRETKEYSIZE, CERT_SERIALNUMBER, 
 				CERT_SERVER_ISSUER, CERT_SERVER_SUBJECT, CERT_SUBJECT, 
 		*/
-				
 		
-		} else if (util::equals (variableName, GATEWAY_INTERFACE)) {
+		case ServerVariable::GatewayInterface:
 			// Should be updated by handler module
+			break;
 					
-		} else if (util::equals (variableName, HTTPS)) {
+		case ServerVariable::Https:
 			var = strings::HttpsDisabledValue; 
 			// Can be updated by module
 			// with HTTPS_KEYSIZE, HTTPS_SECRETKEYSIZE, HTTPS_SERVER_ISSUER, HTTPS_SERVER_SUBJECT:
+			break;
 
-		} else if (util::equals (variableName, INSTANCE_ID)) {
+		case ServerVariable::InstanceId:
 			var = boost::lexical_cast<string> (GlobalSettings->InstanceId);
+			break;
 		
-		} else if (util::equals (variableName, LOCAL_ADDR)) {
+		case ServerVariable::LocalAddr:
 			if ( util::isLocalhostIpAddress(Client->server->settings().ip) )
 				var = util::formatIpAddr(aconnect::network::LocalhostAddress);
 			else
 				var = util::formatIpAddr(Client->server->settings().ip);
+			break;
 		
-		} else if (util::equals (variableName, REMOTE_ADDR) ||
-			util::equals (variableName, REMOTE_HOST)) {
-				var = util::formatIpAddr(Client->ip);
+		case ServerVariable::RemoteAddr:
+		case ServerVariable::RemoteHost:
+			var = util::formatIpAddr(Client->ip);
+			break;
 		
-		} else if (util::equals (variableName, SERVER_NAME)) {
+		case ServerVariable::ServerName:
 			if (Client->server->settings().resolvedHostName.empty() && 
 				util::isLocalhostIpAddress(Client->server->settings().ip))
 					var = aconnect::network::LocalhostName;
 			else
 				var = Client->server->settings().resolvedHostName;
+			break;
 
-		} else if (util::equals (variableName, SERVER_PORT)) {
+		case ServerVariable::ServerPort:
 			var = boost::lexical_cast<string> (Client->server->port());
+			break;
 
-		} else if (util::equals (variableName, SERVER_PORT_SECURE)) {
+		case ServerVariable::ServerPortSecure:
 			var = "0";
+			break;
 
-		} else if (util::equals (variableName, SERVER_PROTOCOL)) {
+		case ServerVariable::ServerProtocol:
 			var = strings::HttpVersion;
+			break;
 
-		} else if (util::equals (variableName, SERVER_SOFTWARE)) {
+		case ServerVariable::ServerSoftware:
 			var = GlobalSettings->serverVersion();
+			break;
 
-		} else if (util::equals (variableName, HTTP_ACCEPT)) {
-			var = RequestHeader.getHeader (strings::HeaderAccept);
+		case ServerVariable::HttpAccept:
+			var = RequestHeader.getHeader (RequestHeaderAccept);
+			break;
 		
-		} else if (util::equals (variableName, HTTP_ACCEPT_LANGUAGE)) {
-			var = RequestHeader.getHeader (strings::HeaderAcceptLanguage);
+		case ServerVariable::HttpAcceptLanguage:
+			var = RequestHeader.getHeader (RequestHeaderAcceptLanguage);
+			break;
 
-		} else if (util::equals (variableName, HTTP_COOKIE)) {
-			var = RequestHeader.getHeader (strings::HeaderCookie);
+		case ServerVariable::HttpCookie:
+			var = RequestHeader.getHeader (RequestHeaderCookie);
+			break;
 			
-		} else if (util::equals (variableName, HTTP_CONNECTION)) {
-			if (RequestHeader.hasHeader(strings::HeaderProxyConnection))
-				var = RequestHeader.getHeader (strings::HeaderProxyConnection);
+		case ServerVariable::HttpConnection:
+			if (RequestHeader.hasHeader (RequestHeaderProxyConnection))
+				var = RequestHeader.getHeader (RequestHeaderProxyConnection);
 			else
-				var = RequestHeader.getHeader (strings::HeaderConnection);
+				var = RequestHeader.getHeader (RequestHeaderConnection);
+			break;
 
-		} else if (util::equals (variableName, HTTP_HOST)) {
-			var = RequestHeader.getHeader (strings::HeaderHost);
+		case ServerVariable::HttpHost:
+			var = RequestHeader.getHeader (RequestHeaderHost);
+			break;
 		
-		} else if (util::equals (variableName, HTTP_REFERER)) {
-			var = RequestHeader.getHeader (strings::HeaderReferer);
+		case ServerVariable::HttpReferer:
+			var = RequestHeader.getHeader (RequestHeaderReferer);
+			break;
 		
-		} else if (util::equals (variableName, HTTP_USER_AGENT)) {
-			var = RequestHeader.getHeader (strings::HeaderUserAgent);
+		case ServerVariable::HttpUserAgent:
+			var = RequestHeader.getHeader (RequestHeaderUserAgent);
+			break;
 		
-		} else if (util::equals (variableName, HTTP_ACCEPT_ENCODING)) {
-			var = RequestHeader.getHeader (strings::HeaderAcceptEncoding);
-		} else if (util::equals (variableName, HTTP_ACCEPT_CHARSET)) {
-			var = RequestHeader.getHeader (strings::HeaderAcceptCharset);
-		} else if (util::equals (variableName, HTTP_KEEP_ALIVE)) {
-			var = RequestHeader.getHeader (strings::HeaderKeepAlive);
-	
+		case ServerVariable::HttpAcceptEncoding:
+			var = RequestHeader.getHeader (RequestHeaderAcceptEncoding);
+			break;
+		
+		case ServerVariable::HttpAcceptCharset:
+			var = RequestHeader.getHeader (RequestHeaderAcceptCharset);
+			break;
+		
+		case ServerVariable::HttpKeepAlive:
+			var = RequestHeader.getHeader (RequestHeaderKeepAlive);
+			break;
+
+		default:
+			break;
 		}
 	
 		// cache it
-		Items[variableName] = var;
+		_serverVariablesLoaded[variableType] = true;
 
 		return var;
 	}
@@ -829,39 +989,38 @@ namespace ahttp
 
 	bool HttpContext::runModules (ModuleCallbackType callbackType)
 	{
-		using namespace aconnect;
-
 		assert (Log && GlobalSettings && "HttpContext was not initializaed correctly");
 		
-		Log->debug ("Run modules for \"%s\", type: %d", 
+		// root dir is used before directory resolving
+		const DirectorySettings* dirInfo = (CurrentDirectoryInfo ? CurrentDirectoryInfo : GlobalSettings->rootDirectoryInfo());
+		assert (dirInfo);
+
+		const ModuleCallbacksTable& callbacks = dirInfo->moduleCallbacks;
+		if (callbacks.empty (callbackType))
+			return false;
+
+		if (Log->isDebugEnabled())
+			Log->debug ("Run modules for \"%s\", type: %d", 
 							RequestHeader.Path.c_str(),
 							callbackType);		
 		
-		
-		const directories_callback_map& modulesCallbacks = GlobalSettings->modulesCallbacks();
-		directories_callback_map::const_iterator callbacksIt = 
-			modulesCallbacks.find (CurrentDirectoryInfo ? CurrentDirectoryInfo->number : 0); 
-		// root dir has number == 0 
-
-		assert (callbacksIt != modulesCallbacks.end());
-		
-		const callback_map& callbackMap = callbacksIt->second;
-		callback_map::const_iterator it = callbackMap.find (callbackType);
-
-		// there are registered callbacks
-		if (it != callbackMap.end())
+		const ModuleCallbacksTable::Record *end = callbacks.end (callbackType);
+		for (const ModuleCallbacksTable::Record *record = callbacks.begin (callbackType); record != end; ++record)
 		{
-			std::list< std::pair <void*, int> >::const_iterator cbIter = it->second.begin();
-			for (; cbIter != it->second.end(); ++cbIter)
-			{
-				if (reinterpret_cast<module_callback_function> (cbIter->first) (*this, cbIter->second))
-					return true;
-			}
-		
+			if (reinterpret_cast<module_callback_function> (record->callback) (*this, record->pluginIndex))
+				return true;
 		}
 	
 		return false;
 	}
 
+	bool HttpContext::hasModules (ModuleCallbackType callbackType) const
+	{
+		assert (GlobalSettings && "HttpContext was not initializaed correctly");
+
+		const DirectorySettings* dirInfo = (CurrentDirectoryInfo ? CurrentDirectoryInfo : GlobalSettings->rootDirectoryInfo());
+		
+		return dirInfo && !dirInfo->moduleCallbacks.empty (callbackType);
+	}
 
 }
@@ -41,6 +41,8 @@ distribution.
 #include "ahttp/http_request.hpp"
 #include "ahttp/http_response_header.hpp"
 #include "ahttp/http_response.hpp"
+#include "ahttp/http_file_cache.hpp"
+#include "ahttp/http_parameters.hpp"
 
 namespace ahttp
 {
@@ -94,13 +96,39 @@ namespace ahttp
 
 		bool isClientConnected() const;
 		void closeConnection (bool closeSocket);
-		void reset ();
+		
+		/**
+		* Drop current request data (uploaded files are deleted), 
+		* allocated buffers are kept to be reused by the next request.
+		* @param[in]	clientInfo		Next request connection, NULL - connection is not changed
+		*/
+		void reset (const aconnect::ClientInfo* clientInfo = NULL);
 		void setHtmlResponse();
 
+		// fill GetParameters, Cookies, PostParameters maps
 		void parseQueryStringParams ();
 		void parseCookies ();
 		
 		void loadPostParams ();
+		
+		// read the rest of request body without parsing
+		void skipPostData ();
+
+		/**
+		* Lazy parameters access: source is indexed on first call, 
+		* only requested value is decoded, maps are not filled.
+		* @param[in]	name		Parameter name (decoded)
+		* @param[out]	value		Decoded parameter value
+		* @return	false when parameter is not found
+		*/
+		bool findQueryParameter (string_constref name, string& value);
+		bool findCookie (string_constref name, string& value);
+		// request body is read on first call
+		bool findPostParameter (string_constref name, string& value);
+
+		// QueryString must be changed by this call: lazy query parameters are indexed again
+		void setQueryString (string_constptr data, size_t size);
+
 		string mapPath (string_constptr virtualPath, bool& fileExists) const throw (std::runtime_error);
 		
 		inline string mapPath (string_constptr virtualPath) const throw (std::runtime_error) {
@@ -120,8 +148,10 @@ namespace ahttp
 		void processException (string_constptr message, bool sendResponse = true, HttpStatus::HttpStatusType status = HttpStatus::InternalServerError);
 		
 		string getServerVariable (string_constptr variableName);
+		string getServerVariable (ServerVariable::ServerVariableType variableType);
 
 		bool runModules (ModuleCallbackType callbackType);
+		bool hasModules (ModuleCallbackType callbackType) const;
 
 		inline void setInternalItem (string_constref key, void* val) {
 			InternalItems.insert( std::make_pair (key, val) );
@@ -134,6 +164,11 @@ namespace ahttp
 
 	protected:
 		void loadMultipartFormData (string_constref boundary);
+		void removeUploadedFiles ();
+		void loadPostData ();
+		
+		const RequestParameters& queryParameters ();
+		const RequestParameters& cookieParameters ();
 		
 		// properties
 	public:
@@ -146,8 +181,9 @@ namespace ahttp
 		HttpMethod::HttpMethodType				Method;
 		string									InitialVirtualPath;
 		string									VirtualPath;
-		string									QueryString;
+		string									QueryString;		// change by setQueryString()
 		boost::filesystem::path					FileSystemPath;
+		file_info_ptr							FileSystemInfo;		// cached FileSystemPath metadata
 		
 		HttpServerSettings*						GlobalSettings;
 		aconnect::Logger*						Log;	
@@ -165,6 +201,20 @@ namespace ahttp
 		std::map <string, UploadFileInfo>		UploadedFiles;
 		const DirectorySettings*				CurrentDirectoryInfo;
 		bool									IsKeepAliveConnect;
+
+	protected:
+		// calculated server variables, indexed by ServerVariable::ServerVariableType
+		string									_serverVariables[ServerVariable::Count];
+		bool									_serverVariablesLoaded[ServerVariable::Count];
+
+		// lazy parameters: ranges in QueryString, Cookie header and request body
+		RequestParameters						_queryParameters;
+		RequestParameters						_cookieParameters;
+		RequestParameters						_postParameters;
+		bool									_postDataLoaded;
+		// url-encoded request body, indexed by _postParameters,
+		// capacity up to defaults::ReadBufferSize is kept for the next request
+		std::vector<aconnect::char_type>		_postData;
 		
 	};
 }
@@ -0,0 +1,522 @@
+/*
+This file is part of [ahttp] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "aconnect/lib_file_begin.inl"
+
+#include <fstream>
+
+#if defined (__GNUC__)
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#	include <sys/inotify.h>
+#endif
+
+#include "aconnect/util.hpp"
+#include "aconnect/util.file.hpp"
+
+#include "ahttp/http_server_settings.hpp"
+#include "ahttp/http_file_cache.hpp"
+
+namespace fs = boost::filesystem;
+
+namespace ahttp
+{
+	namespace
+	{
+		inline size_t getKeyHash (string_constref key)
+		{
+			// FNV-1a
+			size_t hash = 2166136261U;
+			for (string::const_iterator it = key.begin(); it != key.end(); ++it) {
+				hash ^= (unsigned char) *it;
+				hash *= 16777619U;
+			}
+
+			return hash;
+		}
+	}
+
+	FileInfo::FileInfo () :
+		exists (false),
+		isDirectory (false),
+		isReadable (false),
+		modifyTime (0),
+		size (0),
+		fd (-1),
+		loadTime (0)
+	{
+	}
+
+	FileInfo::~FileInfo ()
+	{
+#if defined (__GNUC__)
+		if (fd != -1)
+			close (fd);
+#endif
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		FileInfoCache
+	//
+
+	FileInfoCache::FileInfoCache () :
+		_settings (NULL),
+		_maxShardItemsCount (0),
+		_ttl (0)
+	{
+	}
+
+	void FileInfoCache::init (const HttpServerSettings* settings, size_t maxItemsCount, int ttl)
+	{
+		clear ();
+
+		_settings = settings;
+		_ttl = ttl;
+		_maxShardItemsCount = maxItemsCount > 0 ? 
+			aconnect::util::max2 (maxItemsCount / ShardsCount, (size_t) 1) : 0;
+	}
+
+	void FileInfoCache::clear ()
+	{
+		for (int ndx = 0; ndx < ShardsCount; ++ndx) {
+			boost::mutex::scoped_lock lock (_shards[ndx].mutex);
+			_shards[ndx].items.clear();
+			_shards[ndx].index.clear();
+		}
+	}
+
+	file_info_ptr FileInfoCache::get (const fs::path &path)
+	{
+		if (!isEnabled())
+			return load (path);
+		
+		const string key = path.file_string();
+		Shard &shard = _shards[getKeyHash (key) % ShardsCount];
+		
+		{
+			boost::mutex::scoped_lock lock (shard.mutex);
+			file_info_map::iterator it = shard.index.find (key);
+			
+			if (it != shard.index.end() && std::time (NULL) - (*it->second)->loadTime < _ttl) {
+				// move to the list head - most recently used
+				shard.items.splice (shard.items.begin(), shard.items, it->second);
+				return *it->second;
+			}
+		}
+
+		// load without lock - file system access can be slow
+		file_info_ptr info = load (path);
+		store (shard, info);
+		
+		return info;
+	}
+
+	void FileInfoCache::store (Shard &shard, file_info_ptr info)
+	{
+		boost::mutex::scoped_lock lock (shard.mutex);
+
+		file_info_map::iterator it = shard.index.find (info->path);
+		if (it != shard.index.end()) {
+			*it->second = info;
+			shard.items.splice (shard.items.begin(), shard.items, it->second);
+			return;
+		}
+
+		if (shard.index.size() >= _maxShardItemsCount) {
+			// drop least recently used entry
+			shard.index.erase (shard.items.back()->path);
+			shard.items.pop_back();
+		}
+
+		shard.items.push_front (info);
+		shard.index.insert (std::make_pair (info->path, shard.items.begin()));
+	}
+
+	file_info_ptr FileInfoCache::load (const fs::path &path) const
+	{
+		using namespace aconnect;
+
+		FileInfo *info = new FileInfo ();
+		file_info_ptr res (info);
+		
+		info->path = path.file_string();
+		info->loadTime = std::time (NULL);
+
+#if defined (__GNUC__)
+		// single stat call instead of several boost::filesystem requests
+		struct stat fileStat;
+		if (stat (info->path.c_str(), &fileStat) != 0)
+			return res;
+
+		info->exists = true;
+		info->isDirectory = S_ISDIR (fileStat.st_mode);
+		info->modifyTime = fileStat.st_mtime;
+		info->size = (std::streamsize) fileStat.st_size;
+
+		if (!info->isDirectory) {
+			// cached descriptor must not leak to processes started by handlers
+			info->fd = open (info->path.c_str(), O_RDONLY | O_CLOEXEC);
+			info->isReadable = (info->fd != -1);
+		}
+#else
+		if (!fs::exists (path))
+			return res;
+
+		info->exists = true;
+		info->isDirectory = fs::is_directory (path);
+
+		if (!info->isDirectory) {
+			info->modifyTime = fs::last_write_time (path);
+			info->size = (std::streamsize) fs::file_size (path);
+			
+			std::ifstream file (info->path.c_str());
+			info->isReadable = !file.fail();
+		}
+#endif
+
+		if (!info->isDirectory) {
+			info->etag = util::calculateFileCrc (info->modifyTime, (size_t) info->size);
+			if (_settings)
+				info->mimeType = _settings->getMimeType (fs::extension (path));
+		}
+
+		return res;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		ResolvedTargetCache
+	//
+
+	ResolvedTarget::ResolvedTarget () :
+		isMapped (false),
+		hasQueryString (false),
+		linkedDirectory (NULL)
+	{
+	}
+
+	ResolvedTargetCache::ResolvedTargetCache () :
+		_maxShardItemsCount (0),
+		_hitsCount (0),
+		_missesCount (0)
+	{
+	}
+
+	void ResolvedTargetCache::init (size_t maxItemsCount)
+	{
+		clear ();
+
+		_maxShardItemsCount = maxItemsCount > 0 ? 
+			aconnect::util::max2 (maxItemsCount / ShardsCount, (size_t) 1) : 0;
+	}
+
+	void ResolvedTargetCache::clear ()
+	{
+		for (int ndx = 0; ndx < ShardsCount; ++ndx) {
+			boost::mutex::scoped_lock lock (_shards[ndx].mutex);
+			_shards[ndx].items.clear();
+			_shards[ndx].index.clear();
+		}
+	}
+
+	resolved_target_ptr ResolvedTargetCache::get (string_constref key)
+	{
+		if (!isEnabled())
+			return resolved_target_ptr();
+
+		Shard &shard = _shards[getKeyHash (key) % ShardsCount];
+		{
+			boost::mutex::scoped_lock lock (shard.mutex);
+			targets_map::iterator it = shard.index.find (key);
+			
+			if (it != shard.index.end()) {
+				// move to the list head - most recently used
+				shard.items.splice (shard.items.begin(), shard.items, it->second);
+				++_hitsCount;
+				return it->second->second;
+			}
+		}
+		
+		++_missesCount;
+		return resolved_target_ptr();
+	}
+
+	void ResolvedTargetCache::store (string_constref key, resolved_target_ptr target)
+	{
+		if (!isEnabled())
+			return;
+
+		Shard &shard = _shards[getKeyHash (key) % ShardsCount];
+		boost::mutex::scoped_lock lock (shard.mutex);
+
+		targets_map::iterator it = shard.index.find (key);
+		if (it != shard.index.end()) {
+			it->second->second = target;
+			shard.items.splice (shard.items.begin(), shard.items, it->second);
+			return;
+		}
+
+		if (shard.index.size() >= _maxShardItemsCount) {
+			// drop least recently used entry
+			shard.index.erase (shard.items.back().first);
+			shard.items.pop_back();
+		}
+
+		shard.items.push_front (std::make_pair (key, target));
+		shard.index.insert (std::make_pair (key, shard.items.begin()));
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		DirectoryListingCache
+	//
+
+#if defined (__GNUC__)
+	namespace
+	{
+		// any change of directory items list or items attributes
+		const uint32_t DirectoryChangesMask = IN_CREATE | IN_DELETE | IN_MODIFY | IN_ATTRIB 
+			| IN_MOVED_FROM | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF;
+	}
+#endif
+
+	DirectoryListingCache::DirectoryListingCache () :
+		_maxItemsCount (0),
+		_ttl (0),
+		_notifyFd (-1),
+		_generation (0)
+	{
+	}
+
+	DirectoryListingCache::~DirectoryListingCache ()
+	{
+#if defined (__GNUC__)
+		if (_notifyFd != -1)
+			close (_notifyFd);
+#endif
+	}
+
+	void DirectoryListingCache::init (size_t maxItemsCount, int ttl)
+	{
+		boost::mutex::scoped_lock lock (_mutex);
+		
+		_maxItemsCount = maxItemsCount;
+		_ttl = ttl;
+		reset ();
+	}
+
+	void DirectoryListingCache::clear ()
+	{
+		boost::mutex::scoped_lock lock (_mutex);
+		reset ();
+	}
+
+	void DirectoryListingCache::reset ()
+	{
+		_items.clear();
+		_watches.clear();
+		++_generation;
+
+#if defined (__GNUC__)
+		// closing of inotify instance removes all its watches
+		if (_notifyFd != -1)
+			close (_notifyFd);
+		_notifyFd = isEnabled() ? inotify_init1 (IN_NONBLOCK | IN_CLOEXEC) : -1;
+#endif
+	}
+
+	directory_listing_ptr DirectoryListingCache::get (string_constref key)
+	{
+		if (!isEnabled())
+			return directory_listing_ptr();
+
+		boost::mutex::scoped_lock lock (_mutex);
+		processNotifications ();
+		
+		listings_map::iterator it = _items.find (key);
+		if (it == _items.end())
+			return directory_listing_ptr();
+		
+		if (it->second.watch == -1 && std::time (NULL) - it->second.listing->loadTime >= _ttl) {
+			remove (it);
+			return directory_listing_ptr();
+		}
+
+		return it->second.listing;
+	}
+
+	DirectoryWatch DirectoryListingCache::watch (string_constref dirPath)
+	{
+		DirectoryWatch res;
+		if (!isEnabled())
+			return res;
+
+		boost::mutex::scoped_lock lock (_mutex);
+		processNotifications ();
+		
+		res.generation = _generation;
+#if defined (__GNUC__)
+		if (_notifyFd != -1) {
+			res.descriptor = inotify_add_watch (_notifyFd, dirPath.c_str(), DirectoryChangesMask);
+			if (res.descriptor != -1)
+				_watches.insert (res.descriptor);
+		}
+#endif
+		return res;
+	}
+
+	void DirectoryListingCache::store (string_constref key, const DirectoryWatch& dirWatch, 
+		directory_listing_ptr listing)
+	{
+		if (!isEnabled())
+			return;
+
+		boost::mutex::scoped_lock lock (_mutex);
+		processNotifications ();
+
+		// directory was changed while listing was rendered
+		if (dirWatch.generation != _generation ||
+			(dirWatch.descriptor != -1 && _watches.find (dirWatch.descriptor) == _watches.end()))
+			return;
+
+		// entry is added before eviction - its watch is not released with other listings of directory
+		listings_map::iterator it = _items.find (key);
+		if (it != _items.end()) {
+			const int replacedWatch = it->second.watch;
+			it->second.listing = listing;
+			it->second.watch = dirWatch.descriptor;
+			
+			releaseWatch (replacedWatch);
+			return;
+		}
+
+		Entry entry;
+		entry.listing = listing;
+		entry.watch = dirWatch.descriptor;
+		
+		const listings_map::iterator added = _items.insert (std::make_pair (key, entry)).first;
+		
+		if (_items.size() > _maxItemsCount) 
+		{
+			listings_map::iterator oldest = _items.end();
+			for (it = _items.begin(); it != _items.end(); ++it) {
+				if (it != added && (oldest == _items.end() || 
+						it->second.listing->loadTime < oldest->second.listing->loadTime))
+					oldest = it;
+			}
+			if (oldest != _items.end())
+				remove (oldest);
+		}
+	}
+
+	void DirectoryListingCache::release (const DirectoryWatch& dirWatch)
+	{
+		if (!isEnabled() || dirWatch.descriptor == -1)
+			return;
+
+		boost::mutex::scoped_lock lock (_mutex);
+		processNotifications ();
+
+		// watches of previous generation are closed with inotify instance
+		if (dirWatch.generation == _generation && _watches.find (dirWatch.descriptor) != _watches.end())
+			releaseWatch (dirWatch.descriptor);
+	}
+
+	void DirectoryListingCache::remove (listings_map::iterator it)
+	{
+		const int watch = it->second.watch;
+		_items.erase (it);
+
+		releaseWatch (watch);
+	}
+
+	void DirectoryListingCache::releaseWatch (int watch)
+	{
+		if (watch == -1)
+			return;
+
+		// watch is released when there are no more listings of watched directory
+		for (listings_map::const_iterator it = _items.begin(); it != _items.end(); ++it) {
+			if (it->second.watch == watch)
+				return;
+		}
+
+#if defined (__GNUC__)
+		inotify_rm_watch (_notifyFd, watch);
+#endif
+		_watches.erase (watch);
+	}
+
+	void DirectoryListingCache::dropWatched (int watch, bool removeWatch)
+	{
+		for (listings_map::iterator it = _items.begin(); it != _items.end(); ) {
+			if (it->second.watch == watch)
+				_items.erase (it++);
+			else
+				++it;
+		}
+
+		if (_watches.erase (watch) > 0 && removeWatch) {
+#if defined (__GNUC__)
+			inotify_rm_watch (_notifyFd, watch);
+#endif
+		}
+	}
+
+	void DirectoryListingCache::processNotifications ()
+	{
+#if defined (__GNUC__)
+		if (_notifyFd == -1)
+			return;
+
+		char buff[4096] __attribute__ ((aligned (__alignof__ (struct inotify_event))));
+		ssize_t len;
+		bool overflow = false;
+
+		while ( (len = read (_notifyFd, buff, sizeof (buff))) > 0 )
+		{
+			for (char *ptr = buff; ptr < buff + len; ) 
+			{
+				const struct inotify_event *event = (const struct inotify_event *) ptr;
+				
+				if (event->mask & IN_Q_OVERFLOW)
+					overflow = true;
+				else
+					dropWatched (event->wd, 0 == (event->mask & IN_IGNORED));
+
+				ptr += sizeof (struct inotify_event) + event->len;
+			}
+		}
+
+		// notifications are lost - nothing can be trusted
+		if (overflow)
+			reset ();
+#endif
+	}
+}
@@ -0,0 +1,270 @@
+/*
+This file is part of [ahttp] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef AHTTP_FILE_CACHE_H
+#define AHTTP_FILE_CACHE_H
+#pragma once
+
+#include <ctime>
+#include <map>
+#include <set>
+#include <list>
+#include <vector>
+#include <boost/filesystem.hpp>
+#include <boost/noncopyable.hpp>
+#include <boost/shared_ptr.hpp>
+#include <boost/thread.hpp>
+#include <boost/detail/atomic_count.hpp>
+
+#include "aconnect/types.hpp"
+
+namespace ahttp
+{
+	class HttpServerSettings;
+	struct DirectorySettings;
+	struct PluginRegistrationInfo;
+
+	// metadata of requested file system target
+	struct FileInfo : private boost::noncopyable
+	{
+		FileInfo ();
+		~FileInfo ();
+
+		string			path;
+		bool			exists;
+		bool			isDirectory;
+		bool			isReadable;
+		std::time_t		modifyTime;
+		std::streamsize	size;
+		string			etag;
+		string			mimeType;
+		int				fd;			// opened file (Linux only), -1 if not opened
+		std::time_t		loadTime;
+	};
+
+	typedef boost::shared_ptr<const FileInfo> file_info_ptr;
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Bounded LRU cache of file metadata and opened descriptors:
+	//	entries are distributed between independently locked shards by path hash,
+	//	entry is reloaded when its TTL is expired.
+	
+	class FileInfoCache : private boost::noncopyable
+	{
+	public:
+		FileInfoCache ();
+
+		/**
+		* Setup cache, all loaded entries are dropped
+		* @param[in]	settings		Server settings, used to resolve MIME types
+		* @param[in]	maxItemsCount	Max cached entries count, 0 - caching is disabled
+		* @param[in]	ttl				Entry life time (sec)
+		*/
+		void init (const HttpServerSettings* settings, size_t maxItemsCount, int ttl);
+		void clear ();
+
+		// get cached info or load it from file system
+		file_info_ptr get (const boost::filesystem::path &path);
+
+		inline bool isEnabled() const		{	return _maxShardItemsCount > 0;	}
+
+		static const int ShardsCount = 16;
+
+	protected:
+		typedef std::list<file_info_ptr> file_info_list;
+		typedef std::map<string, file_info_list::iterator> file_info_map;
+
+		struct Shard
+		{
+			boost::mutex	mutex;
+			file_info_list	items;		// most recently used first
+			file_info_map	index;		// by file path
+		};
+
+		file_info_ptr load (const boost::filesystem::path &path) const;
+		void store (Shard &shard, file_info_ptr info);
+		
+	// fields
+	protected:
+		const HttpServerSettings*	_settings;
+		size_t						_maxShardItemsCount;
+		int							_ttl;
+		Shard						_shards[ShardsCount];
+	};
+
+	// routing decision of HttpServer::findTarget, depends on settings only -
+	// file system state is taken from FileInfoCache
+	struct ResolvedTarget : private boost::noncopyable
+	{
+		ResolvedTarget ();
+
+		bool						isMapped;		// 'path', 'virtualPath' and 'queryString' are set by mapping
+		bool						hasQueryString;
+		string						path;
+		string						virtualPath;
+		string						queryString;
+		boost::filesystem::path		fileSystemPath;
+
+		// handlers applicable to target, in registration order
+		std::vector<const PluginRegistrationInfo*>	handlers;
+		// linked virtual directory - redirect target
+		const DirectorySettings*	linkedDirectory;
+	};
+
+	typedef boost::shared_ptr<const ResolvedTarget> resolved_target_ptr;
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Bounded LRU cache of resolved request targets,
+	//	sharded in the same way as FileInfoCache, dropped on settings reload.
+	
+	class ResolvedTargetCache : private boost::noncopyable
+	{
+	public:
+		ResolvedTargetCache ();
+
+		/**
+		* Setup cache, all stored entries are dropped
+		* @param[in]	maxItemsCount	Max cached entries count, 0 - caching is disabled
+		*/
+		void init (size_t maxItemsCount);
+		void clear ();
+
+		// returns empty pointer if target is not cached
+		resolved_target_ptr get (string_constref key);
+		void store (string_constref key, resolved_target_ptr target);
+
+		inline bool isEnabled() const		{	return _maxShardItemsCount > 0;	}
+		inline long hitsCount() const		{	return _hitsCount;				}
+		inline long missesCount() const		{	return _missesCount;			}
+
+		static const int ShardsCount = 16;
+
+	protected:
+		typedef std::list<std::pair<string, resolved_target_ptr> > targets_list;
+		typedef std::map<string, targets_list::iterator> targets_map;
+
+		struct Shard
+		{
+			boost::mutex	mutex;
+			targets_list	items;		// most recently used first
+			targets_map		index;
+		};
+
+	// fields
+	protected:
+		size_t						_maxShardItemsCount;
+		Shard						_shards[ShardsCount];
+		boost::detail::atomic_count	_hitsCount;
+		boost::detail::atomic_count	_missesCount;
+	};
+
+	// rendered directory listing
+	struct DirectoryListing : private boost::noncopyable
+	{
+		DirectoryListing () : loadTime (0) { }
+
+		string			content;	// complete HTML page
+		std::time_t		loadTime;
+	};
+
+	typedef boost::shared_ptr<const DirectoryListing> directory_listing_ptr;
+
+	// directory changes tracking state, taken before directory reading
+	struct DirectoryWatch
+	{
+		DirectoryWatch () : descriptor (-1), generation (0) { }
+
+		int				descriptor;		// inotify watch, -1 if directory is not watched
+		unsigned long	generation;		// cache reset counter
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Cache of rendered directory listings: on Linux entry is dropped 
+	//	by inotify notification about directory content change, 
+	//	not watched entries are reloaded when TTL is expired.
+	
+	class DirectoryListingCache : private boost::noncopyable
+	{
+	public:
+		DirectoryListingCache ();
+		~DirectoryListingCache ();
+
+		/**
+		* Setup cache, all stored entries are dropped
+		* @param[in]	maxItemsCount	Max cached listings count, 0 - caching is disabled
+		* @param[in]	ttl				Life time of entry without directory watch (sec)
+		*/
+		void init (size_t maxItemsCount, int ttl);
+		void clear ();
+
+		// returns empty pointer if listing is not cached
+		directory_listing_ptr get (string_constref key);
+
+		// start directory changes tracking - must be called before directory reading
+		DirectoryWatch watch (string_constref dirPath);
+
+		// listing is not stored if directory was changed after watch() call
+		void store (string_constref key, const DirectoryWatch& dirWatch, 
+			directory_listing_ptr listing);
+
+		// listing is not stored - watch is removed if no cached listing uses it
+		void release (const DirectoryWatch& dirWatch);
+
+		inline bool isEnabled() const		{	return _maxItemsCount > 0;	}
+
+	protected:
+		struct Entry
+		{
+			directory_listing_ptr	listing;
+			int						watch;
+		};
+
+		typedef std::map<string, Entry> listings_map;
+		// active watch descriptors, watch is removed on first notification
+		typedef std::set<int> watches_set;
+
+		void processNotifications ();
+		void dropWatched (int watch, bool removeWatch);
+		void remove (listings_map::iterator it);
+		void releaseWatch (int watch);
+		void reset ();
+
+	// fields
+	protected:
+		boost::mutex	_mutex;
+		listings_map	_items;
+		watches_set		_watches;
+		size_t			_maxItemsCount;
+		int				_ttl;
+		int				_notifyFd;
+		unsigned long	_generation;
+	};
+}
+
+#endif // AHTTP_FILE_CACHE_H
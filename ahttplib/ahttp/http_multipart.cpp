@@ -0,0 +1,180 @@
+/*
+This file is part of [ahttp] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "aconnect/lib_file_begin.inl"
+
+#include <cstring>
+
+#include "aconnect/util.hpp"
+#include "ahttp/http_support.hpp"
+#include "ahttp/http_multipart.hpp"
+
+namespace ahttp
+{
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		BoundaryMatcher
+	//
+	BoundaryMatcher::BoundaryMatcher (string_constref pattern) :
+		_pattern (pattern)
+	{
+		assert (!_pattern.empty());
+
+		const size_t len = _pattern.size();
+		for (size_t ndx = 0; ndx < 256; ++ndx)
+			_shifts[ndx] = len;
+		
+		for (size_t ndx = 0; ndx < len - 1; ++ndx)
+			_shifts[(unsigned char) _pattern[ndx]] = len - 1 - ndx;
+	}
+
+	size_t BoundaryMatcher::find (string_constptr text, size_t size) const
+	{
+		const size_t len = _pattern.size();
+		if (size < len)
+			return string::npos;
+
+		string_constptr pattern = _pattern.c_str();
+		const unsigned char last = (unsigned char) pattern[len - 1];
+		size_t pos = 0;
+
+		while (pos <= size - len)
+		{
+			const unsigned char ch = (unsigned char) text[pos + len - 1];
+			
+			if (ch == last && memcmp (text + pos, pattern, len - 1) == 0)
+				return pos;
+
+			pos += _shifts[ch];
+		}
+
+		return string::npos;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		MultipartParser
+	//
+	MultipartParser::MultipartParser (string_constref boundary, size_t bufferSize) :
+		_delimiter (string (strings::HeadersDelimiter) + strings::MultipartBoundaryPrefix + boundary),
+		_bufferSize (aconnect::util::max2 (bufferSize, 2 * _delimiter.size() + MaxPartHeaderSize / 8)),
+		_buffer (new aconnect::char_type[_bufferSize]),
+		_filled (0),
+		_state (Preamble)
+	{
+		// first boundary can be placed at content start - without line break
+		const size_t prefixSize = strlen (strings::HeadersDelimiter);
+		memcpy (_buffer.get(), strings::HeadersDelimiter, prefixSize);
+		_filled = prefixSize;
+	}
+
+	void MultipartParser::consume (size_t dataSize, MultipartHandler &handler) 
+		throw (aconnect::request_processing_error)
+	{
+		using namespace aconnect;
+
+		assert (_filled + dataSize <= _bufferSize);
+
+		string_constptr data = _buffer.get();
+		const size_t end = _filled + dataSize;
+		const size_t delimiterSize = _delimiter.size();
+		size_t pos = 0;
+
+		while (pos < end && _state != Epilogue)
+		{
+			if (_state == Preamble || _state == PartBody) 
+			{
+				const size_t found = _delimiter.find (data + pos, end - pos);
+				
+				if (found == string::npos) {
+					// tail can be the delimiter start - keep it
+					const size_t keep = util::min2 (delimiterSize - 1, end - pos);
+					if (_state == PartBody && end - pos > keep)
+						handler.onPartData (data + pos, end - pos - keep);
+					
+					pos = end - keep;
+					break;
+				}
+
+				if (_state == PartBody) {
+					if (found > 0)
+						handler.onPartData (data + pos, found);
+					handler.onPartEnd ();
+				}
+
+				pos += found + delimiterSize;
+				_state = Delimiter;
+
+			} else if (_state == Delimiter) {
+				
+				if (end - pos < 2)
+					break;
+
+				if (data[pos] == '-' && data[pos + 1] == '-') {
+					_state = Epilogue;
+					
+				} else {
+					// line break after boundary is header end mark start for part without headers
+					_header.clear();
+					_state = PartHeader;
+				}
+
+			} else if (_state == PartHeader) {
+				
+				const size_t endMarkSize = strlen (strings::HeadersEndMark);
+				
+				while (pos < end) 
+				{
+					_header += data[pos++];
+
+					if (_header.size() >= endMarkSize 
+						&& _header.compare (_header.size() - endMarkSize, endMarkSize, strings::HeadersEndMark) == 0) 
+					{
+						const size_t lineBreakSize = strlen (strings::HeadersDelimiter);
+
+						handler.onPartBegin (_header.size() == endMarkSize ? string() :
+							_header.substr (lineBreakSize, _header.size() - lineBreakSize - endMarkSize));
+						_state = PartBody;
+						break;
+					}
+
+					if (_header.size() > MaxPartHeaderSize)
+						throw request_processing_error ("Too large multipart part header");
+				}
+			}
+		}
+
+		if (_state == Epilogue) {
+			_filled = 0;
+			return;
+		}
+
+		// move unprocessed data to buffer start
+		_filled = end - pos;
+		if (_filled > 0 && pos > 0)
+			memmove (_buffer.get(), data + pos, _filled);
+	}
+}
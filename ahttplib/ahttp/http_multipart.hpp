@@ -0,0 +1,129 @@
+/*
+This file is part of [ahttp] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef AHTTP_MULTIPART_H
+#define AHTTP_MULTIPART_H
+#pragma once
+
+#include <boost/noncopyable.hpp>
+#include <boost/scoped_array.hpp>
+
+#include "aconnect/types.hpp"
+#include "aconnect/error.hpp"
+#include "ahttp/aconnect_types.hpp"
+
+namespace ahttp
+{
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Boyer-Moore-Horspool matcher with precomputed shifts table
+
+	class BoundaryMatcher : private boost::noncopyable
+	{
+	public:
+		explicit BoundaryMatcher (string_constref pattern);
+
+		// returns pattern position in 'text' or string::npos
+		size_t find (string_constptr text, size_t size) const;
+
+		inline size_t size() const				{	return _pattern.size();	}
+
+	protected:
+		string _pattern;
+		size_t _shifts[256];
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Multipart parser events receiver
+
+	class MultipartHandler
+	{
+	public:
+		virtual ~MultipartHandler () { }
+
+		// 'header' - part header lines without final empty line
+		virtual void onPartBegin (string_constref header) = 0;
+		virtual void onPartData (string_constptr data, size_t size) = 0;
+		virtual void onPartEnd () = 0;
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Incremental multipart/form-data parser: data is read directly to
+	//	parser buffer of fixed size, part content is passed to handler 
+	//	without copying, only possible boundary start is kept between reads.
+
+	class MultipartParser : private boost::noncopyable
+	{
+	public:
+		MultipartParser (string_constref boundary, size_t bufferSize);
+
+		/**
+		* Get free buffer space to read next data block
+		* @param[out]	freeSize		Free space size
+		*/
+		inline aconnect::char_type* buffer (size_t &freeSize) {
+			freeSize = _bufferSize - _filled;
+			return _buffer.get() + _filled;
+		}
+
+		/**
+		* Process data block read to buffer()
+		* @param[in]	dataSize		Read bytes count
+		*/
+		void consume (size_t dataSize, MultipartHandler &handler) throw (aconnect::request_processing_error);
+
+		// closing boundary is found
+		inline bool isFinished() const		{	return _state == Epilogue;	}
+
+		static const size_t MaxPartHeaderSize = 8 * 1024;	// bytes
+
+	protected:
+		enum ParserState
+		{
+			Preamble,
+			Delimiter,		// boundary found, next 2 bytes show part or closing boundary
+			PartHeader,
+			PartBody,
+			Epilogue
+		};
+
+	// fields
+	protected:
+		BoundaryMatcher _delimiter;		// "\r\n--" + boundary
+		const size_t _bufferSize;
+		boost::scoped_array<aconnect::char_type> _buffer;
+		size_t _filled;
+		ParserState _state;
+		string _header;
+	};
+
+	//
+	//////////////////////////////////////////////////////////////////////////
+}
+
+#endif // AHTTP_MULTIPART_H
@@ -0,0 +1,198 @@
+/*
+This file is part of [ahttp] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "aconnect/lib_file_begin.inl"
+
+#include <cstring>
+#include <algorithm>
+
+#include "aconnect/util.string.hpp"
+#include "ahttp/http_parameters.hpp"
+
+namespace ahttp
+{
+	namespace
+	{
+		const aconnect::char_type UrlEncodedSymbols[] = { '%', '+' };
+		
+		inline bool isUrlEncoded (string_constptr begin, string_constptr end) {
+			return aconnect::util::findAnyOf (begin, end, UrlEncodedSymbols, ARRAY_SIZE (UrlEncodedSymbols)) != end;
+		}
+
+		inline void decodePart (string& target, string_constptr data, size_t size) {
+			target.clear();
+			aconnect::util::appendDecodedUrl (target, data, size);
+		}
+	}
+
+	void RequestParameters::load (string_constptr data, size_t size, 
+		aconnect::char_type separator, bool trimNames)
+	{
+		reset ();
+
+		_data = data;
+		_size = size;
+		_separator = separator;
+		_trimNames = trimNames;
+		_loaded = true;
+	}
+
+	void RequestParameters::loadWritable (aconnect::char_type *data, size_t size, 
+		aconnect::char_type separator, bool trimNames)
+	{
+		load (data, size, separator, trimNames);
+		_decodeInPlace = true;
+	}
+
+	void RequestParameters::reset ()
+	{
+		_data = NULL;
+		_size = 0;
+		_loaded = false;
+		_decodeInPlace = false;
+		_indexed = false;
+		_pairs.clear();
+	}
+
+	void RequestParameters::decodeInPlace (string_constptr data, size_t &size, bool &encoded) const
+	{
+		if (encoded && _decodeInPlace) {
+			// source is writable - see loadWritable()
+			size = aconnect::util::decodeUrlInPlace (const_cast<aconnect::char_type*> (data), size);
+			encoded = false;
+		}
+	}
+
+	void RequestParameters::readPart (string& target, string_constptr data, size_t &size, bool &encoded) const
+	{
+		decodeInPlace (data, size, encoded);
+
+		if (encoded)
+			decodePart (target, data, size);
+		else
+			target.assign (data, size);
+	}
+
+	void RequestParameters::buildIndex () const
+	{
+		_indexed = true;
+		if (0 == _size)
+			return;
+
+		string_constptr pos = _data,
+			end = _data + _size,
+			partEnd, sep;
+
+		while (pos != end)
+		{
+			partEnd = std::find (pos, end, _separator);
+			
+			if (_trimNames) {
+				while (pos != partEnd && (*pos == ' ' || *pos == '\t'))
+					++pos;
+			}
+
+			// empty parts are skipped
+			if (partEnd != pos) {
+				PairRecord record;
+				sep = std::find (pos, partEnd, '=');
+				
+				record.name = pos;
+				record.nameLength = sep - pos;
+				record.nameEncoded = isUrlEncoded (pos, sep);
+				
+				if (sep == partEnd) {
+					record.value = partEnd;
+					record.valueLength = 0;
+				} else {
+					record.value = sep + 1;
+					record.valueLength = partEnd - sep - 1;
+				}
+				record.valueEncoded = isUrlEncoded (record.value, partEnd);
+
+				_pairs.push_back (record);
+			}
+
+			if (partEnd == end)
+				break;
+			pos = partEnd + 1;
+		}
+	}
+
+	int RequestParameters::findPair (string_constref name) const
+	{
+		index ();
+		
+		string decodedName;
+
+		// the last one wins - like map loading
+		for (int ndx = (int) _pairs.size() - 1; ndx >= 0; --ndx) 
+		{
+			PairRecord &record = _pairs[ndx];
+			
+			decodeInPlace (record.name, record.nameLength, record.nameEncoded);
+
+			if (record.nameEncoded) {
+				decodePart (decodedName, record.name, record.nameLength);
+				if (decodedName == name)
+					return ndx;
+			
+			} else if (record.nameLength == name.size() 
+				&& 0 == memcmp (record.name, name.c_str(), record.nameLength)) {
+					return ndx;
+			}
+		}
+
+		return -1;
+	}
+
+	bool RequestParameters::has (string_constref name) const
+	{
+		return findPair (name) != -1;
+	}
+
+	bool RequestParameters::find (string_constref name, string& value) const
+	{
+		const int ndx = findPair (name);
+		if (ndx == -1)
+			return false;
+
+		PairRecord &record = _pairs[ndx];
+		readPart (value, record.value, record.valueLength, record.valueEncoded);
+		return true;
+	}
+
+	void RequestParameters::copyTo (aconnect::str2str_map& target) const
+	{
+		index ();
+		
+		string name;
+		for (std::vector<PairRecord>::iterator it = _pairs.begin(); it != _pairs.end(); ++it) {
+			readPart (name, it->name, it->nameLength, it->nameEncoded);
+			readPart (target[name], it->value, it->valueLength, it->valueEncoded);
+		}
+	}
+}
@@ -0,0 +1,136 @@
+/*
+This file is part of [ahttp] library. 
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#ifndef AHTTP_PARAMETERS_H
+#define AHTTP_PARAMETERS_H
+#pragma once
+
+#include <vector>
+#include <boost/noncopyable.hpp>
+
+#include "aconnect/types.hpp"
+#include "aconnect/complex_types.hpp"
+#include "ahttp/aconnect_types.hpp"
+
+namespace ahttp
+{
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Lazy "name=value" pairs collection (query string, cookies, form data):
+	//	source is split on first access, names and values are stored as ranges 
+	//	in source buffer and are URL-decoded only when they are read.
+	//	Parts of writable source are decoded in place once.
+
+	class RequestParameters : private boost::noncopyable
+	{
+	public:
+		RequestParameters () : 
+			_data (NULL), 
+			_size (0), 
+			_separator ('&'), 
+			_trimNames (false), 
+			_loaded (false), 
+			_decodeInPlace (false), 
+			_indexed (false) 
+		{ 
+			_pairs.reserve (InitialPairsCapacity);
+		}
+
+		/**
+		* Set parameters source, it is not parsed until first access.
+		* @param[in]	data		Source buffer, must be valid until reset() call
+		* @param[in]	size		Source buffer size
+		* @param[in]	separator	Pairs separator
+		* @param[in]	trimNames	Skip leading whitespaces in names (cookies)
+		*/
+		void load (string_constptr data, size_t size, 
+			aconnect::char_type separator, bool trimNames = false);
+		
+		// writable source (request body buffer of HttpContext): parts are decoded in place on first read
+		void loadWritable (aconnect::char_type *data, size_t size, 
+			aconnect::char_type separator, bool trimNames = false);
+		
+		void reset ();
+
+		inline bool isLoaded() const	{	return _loaded;		}
+		inline bool isLoadedFrom (string_constptr data, size_t size) const {
+			return _loaded && _data == data && _size == size;
+		}
+		inline size_t size() const		{	index(); return _pairs.size();		}
+
+		bool has (string_constref name) const;
+		
+		// decoded value of the last parameter with 'name', false if not found
+		bool find (string_constref name, string& value) const;
+		
+		inline string get (string_constref name, string_constref defaultValue = "") const {
+			string value;
+			return find (name, value) ? value : defaultValue;
+		}
+
+		// decode all parameters to map (later duplicates replace earlier ones)
+		void copyTo (aconnect::str2str_map& target) const;
+
+		static const size_t InitialPairsCapacity = 16;
+
+	protected:
+		struct PairRecord
+		{
+			string_constptr name;
+			size_t nameLength;
+			string_constptr value;
+			size_t valueLength;
+			bool nameEncoded;
+			bool valueEncoded;
+		};
+
+		inline void index () const {
+			if (!_indexed)
+				buildIndex ();
+		}
+		void buildIndex () const;
+		int findPair (string_constref name) const;
+		void decodeInPlace (string_constptr data, size_t &size, bool &encoded) const;
+		void readPart (string& target, string_constptr data, size_t &size, bool &encoded) const;
+
+	// fields
+	protected:
+		string_constptr			_data;
+		size_t					_size;
+		aconnect::char_type		_separator;
+		bool					_trimNames;
+		bool					_loaded;
+		bool					_decodeInPlace;
+		
+		mutable bool						_indexed;
+		mutable std::vector<PairRecord>		_pairs;
+	};
+
+	//
+	//////////////////////////////////////////////////////////////////////////
+}
+
+#endif // AHTTP_PARAMETERS_H
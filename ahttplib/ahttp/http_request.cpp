@@ -27,23 +27,115 @@ distribution.
 #include "aconnect/lib_file_begin.inl"
 
 #include <assert.h>
-#include <boost/algorithm/string.hpp>
-#include <boost/lexical_cast.hpp>
+#include <ctype.h>
+#include <string.h>
 
 #include "aconnect/util.hpp"
 #include "aconnect/util.string.hpp"
+#include "aconnect/util.scan.hpp"
 #include "aconnect/util.network.hpp"
 
 #include "ahttp/http_support.hpp"
 #include "ahttp/http_request.hpp"
 
-namespace algo = boost::algorithm;
-
 namespace ahttp
 {
+	namespace
+	{
+		struct KnownHeaderInfo
+		{
+			string_constptr name;
+			size_t length;
+		};
+
+		// order must match RequestHeaderType
+		const KnownHeaderInfo KnownHeaders[RequestHeaderTypesCount] = 
+		{
+			{ strings::HeaderAccept,			sizeof (strings::HeaderAccept) - 1 },
+			{ strings::HeaderAcceptCharset,		sizeof (strings::HeaderAcceptCharset) - 1 },
+			{ strings::HeaderAcceptEncoding,	sizeof (strings::HeaderAcceptEncoding) - 1 },
+			{ strings::HeaderAcceptLanguage,	sizeof (strings::HeaderAcceptLanguage) - 1 },
+			{ strings::HeaderAuthorization,		sizeof (strings::HeaderAuthorization) - 1 },
+			{ strings::HeaderConnection,		sizeof (strings::HeaderConnection) - 1 },
+			{ strings::HeaderContentLength,		sizeof (strings::HeaderContentLength) - 1 },
+			{ strings::HeaderContentType,		sizeof (strings::HeaderContentType) - 1 },
+			{ strings::HeaderCookie,			sizeof (strings::HeaderCookie) - 1 },
+			{ strings::HeaderHost,				sizeof (strings::HeaderHost) - 1 },
+			{ strings::HeaderIfMatch,			sizeof (strings::HeaderIfMatch) - 1 },
+			{ strings::HeaderIfModifiedSince,	sizeof (strings::HeaderIfModifiedSince) - 1 },
+			{ strings::HeaderIfNoneMatch,		sizeof (strings::HeaderIfNoneMatch) - 1 },
+			{ strings::HeaderIfRange,			sizeof (strings::HeaderIfRange) - 1 },
+			{ strings::HeaderIfUnmodifiedSince,	sizeof (strings::HeaderIfUnmodifiedSince) - 1 },
+			{ strings::HeaderKeepAlive,			sizeof (strings::HeaderKeepAlive) - 1 },
+			{ strings::HeaderProxyConnection,	sizeof (strings::HeaderProxyConnection) - 1 },
+			{ strings::HeaderRange,				sizeof (strings::HeaderRange) - 1 },
+			{ strings::HeaderReferer,			sizeof (strings::HeaderReferer) - 1 },
+			{ strings::HeaderUserAgent,			sizeof (strings::HeaderUserAgent) - 1 }
+		};
+
+		inline bool equalsNoCase (string_constptr first, string_constptr second, size_t length)
+		{
+			for (size_t ndx = 0; ndx < length; ++ndx) {
+				if (first[ndx] != second[ndx] && 
+					tolower ((unsigned char) first[ndx]) != tolower ((unsigned char) second[ndx]))
+					return false;
+			}
+			return true;
+		}
+
+		inline bool isSpace (aconnect::char_type ch) {
+			return ch == ' ' || ch == '\t';
+		}
+
+		// parse unsigned decimal number from [begin, end)
+		inline bool parseNumber (string_constptr begin, string_constptr end, size_t &value)
+		{
+			if (begin == end)
+				return false;
+
+			value = 0;
+			for (; begin != end; ++begin) {
+				if (*begin < '0' || *begin > '9')
+					return false;
+				
+				const size_t digit = (size_t) (*begin - '0');
+				if (value > ((size_t) -1 - digit) / 10)
+					return false;	// overflow
+
+				value = value * 10 + digit;
+			}
+			return true;
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		HttpRequestHeadersView
+	//
+	//////////////////////////////////////////////////////////////////////////
+
+	const aconnect::str2str_map_ci& HttpRequestHeadersView::map () const
+	{
+		if (!_loaded) {
+			_map = _owner->getHeaders();
+			_loaded = true;
+		}
+		return _map;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		HttpRequestHeader
+	//
+	//////////////////////////////////////////////////////////////////////////
+
 	void HttpRequestHeader::clear()
 	{
-		Headers.clear ();
+		// buffers capacity is kept for the next request
+		_buffer.clear ();
+		_headers.clear ();
+		resetKnownHeaders ();
+		Headers.reset ();
 
 		VersionHigh = VersionLow = 0;
 		ContentLength = 0;
@@ -59,79 +151,186 @@ namespace ahttp
 		assert ( headerBody.length() );
 
 		using namespace aconnect;
-				
-		SimpleTokenizer tokens(headerBody, "\r\n");
+		
+		// header is copied: the read buffer also holds the beginning of the request body,
+		// HttpContext::init cuts the header off and moves the rest into RequestStream,
+		// but header records point into the text for the whole request;
+		// _buffer capacity survives clear(), so a pooled context copies without allocation
+		_buffer.assign (headerBody);
+		_headers.clear ();
+		resetKnownHeaders ();
+		Headers.reset ();
+
+		string_constptr data = _buffer.c_str();
+		string_constptr dataEnd = data + _buffer.size();
+		const size_t size = _buffer.size();
 		
 		int lineNdx = 0;
-		string::size_type pos = string::npos, 
-			prevPos = string::npos;
+		size_t lineBegin = 0;
 
-		for (SimpleTokenizer::iterator tok_iter = tokens.begin(); 
-				tok_iter != tokens.end(); 
-				++tok_iter)
+		while (lineBegin < size)
 		{
-			string_constref line = tok_iter.current_token();
-			if (line.empty())
-				continue;
-
-			// first line: "GET /preloadingpages HTTP/1.1"
-			if (0 == lineNdx) {
-				pos = line.find (' ');
-				if (pos == string::npos) 
-					throw request_processing_error ("Incorrect request string: %s", line.c_str());
-				
-				Method = line.substr (0, pos);
-				prevPos = pos + 1;
-
-				pos = line.find (' ', pos + 1);
+			const size_t lineEnd = util::findLineEnd (data + lineBegin, dataEnd) - data;
+
+			if (lineEnd != lineBegin) {
+				// first line: "GET /preloadingpages HTTP/1.1"
+				if (0 == lineNdx)
+					loadRequestLine (lineBegin, lineEnd);
+				else
+					loadHeader (lineBegin, lineEnd);
 				
-				if (pos != string::npos) {
-					Path = line.substr (prevPos, pos - prevPos);
-					prevPos = pos + 1;
+				++lineNdx;
+			}
 
-					const size_t offset = strlen ("HTTP/");
+			lineBegin = lineEnd + 1;
+		}
+		
+		// INVESTIGATE: check correctness, maybe DEBUG, OPTIONS... will be supported
+		if (util::equals (Method, strings::HttpMethodGet))
+			_contentLengthLoaded = true;
 
-					if ((pos = line.find ('.', prevPos + offset)) != string::npos) {
-						VersionHigh = boost::lexical_cast<int> (line.substr (prevPos + offset, pos - offset - prevPos));
-						VersionLow = boost::lexical_cast<int> (line.substr (pos + 1));
+	}
 
-					} else {
-						VersionHigh = boost::lexical_cast<int> (line.substr (prevPos + offset));
-						VersionLow = 0;
-					}
+	void HttpRequestHeader::loadRequestLine (size_t begin, size_t end) 
+		throw (request_processing_error)
+	{
+		using namespace aconnect;
 
-				} else {
-					Path = line.substr (prevPos);
-				}
+		string_constptr data = _buffer.c_str();
+		string_constptr lineEnd = data + end;
+		
+		string_constptr methodEnd = util::findSymbol (data + begin, lineEnd, ' ');
+		if (methodEnd == lineEnd) 
+			throw request_processing_error ("Incorrect request string: %s", 
+				_buffer.substr (begin, end - begin).c_str());
+		
+		Method.assign (data + begin, methodEnd);
 
-			} else {
-				pos = line.find (':');
-				if (pos == string::npos) 
-					throw request_processing_error ("Incorrect request header: %s", line.c_str());
-				
-				loadHeader (line.substr (0, pos), algo::trim_copy(line.substr (pos + 1)));
-			}
+		string_constptr pathBegin = methodEnd + 1;
+		string_constptr pathEnd = util::findSymbol (pathBegin, lineEnd, ' ');
 
-			++lineNdx;
+		if (pathEnd == lineEnd) {
+			Path.assign (pathBegin, lineEnd);
+			return;
 		}
+		
+		Path.assign (pathBegin, pathEnd);
 
+		const size_t prefixLength = strlen ("HTTP/");
+		string_constptr versionBegin = pathEnd + 1 + prefixLength;
+		if (versionBegin > lineEnd)
+			throw request_processing_error ("Incorrect HTTP version: %s", 
+				_buffer.substr (begin, end - begin).c_str());
 		
-		// INVESTIGATE: check correctness, maybe DEBUG, OPTIONS... will be supported
-		if (util::equals (Method, strings::HttpMethodGet))
-			_contentLengthLoaded = true;
+		string_constptr dot = util::findSymbol (versionBegin, lineEnd, '.');
+		size_t versionHigh = 0, versionLow = 0;
+		
+		bool parsed = (dot != lineEnd) ? 
+			parseNumber (versionBegin, dot, versionHigh) && parseNumber (dot + 1, lineEnd, versionLow) :
+			parseNumber (versionBegin, lineEnd, versionHigh);
+
+		if (!parsed)
+			throw request_processing_error ("Incorrect HTTP version: %s", 
+				_buffer.substr (begin, end - begin).c_str());
 
+		VersionHigh = (int) versionHigh;
+		VersionLow = (int) versionLow;
 	}
 
-	void HttpRequestHeader::loadHeader (string_constref name, string_constref value) 
+	void HttpRequestHeader::loadHeader (size_t begin, size_t end) 
+		throw (request_processing_error)
 	{
 		using namespace aconnect;
+
+		string_constptr data = _buffer.c_str();
+		
+		string_constptr colon = util::findSymbol (data + begin, data + end, ':');
+		if (colon == data + end) 
+			throw request_processing_error ("Incorrect request header: %s", 
+				_buffer.substr (begin, end - begin).c_str());
+		
+		HeaderRecord record;
+		record.nameOffset = begin;
+		record.nameLength = colon - (data + begin);
+		
+		// trim value
+		size_t valueBegin = (colon - data) + 1;
+		while (valueBegin < end && isSpace (data[valueBegin]))
+			++valueBegin;
+		while (end > valueBegin && isSpace (data[end - 1]))
+			--end;
 		
-		if ( util::equals (name, strings::HeaderContentLength) ) {
-			ContentLength = boost::lexical_cast<size_t> (value);
+		record.valueOffset = valueBegin;
+		record.valueLength = end - valueBegin;
+		record.type = getHeaderType (data + begin, record.nameLength);
+
+		if (record.type == RequestHeaderContentLength) {
+			if (!parseNumber (data + record.valueOffset, data + end, ContentLength))
+				throw request_processing_error ("Incorrect Content-Length value: %s",
+					_buffer.substr (record.valueOffset, record.valueLength).c_str());
 			_contentLengthLoaded = true;
 		}
 		
-		Headers.insert(std::make_pair (name, value));
+		// the first header with the same name is accessible by name
+		if (record.type != RequestHeaderUnknown && _knownHeaders[record.type] == -1)
+			_knownHeaders[record.type] = (int) _headers.size();
+
+		_headers.push_back (record);
+	}
+
+	RequestHeaderType HttpRequestHeader::getHeaderType (string_constptr name, size_t nameLength)
+	{
+		for (int ndx = 0; ndx < RequestHeaderTypesCount; ++ndx) {
+			if (KnownHeaders[ndx].length == nameLength && 
+				equalsNoCase (KnownHeaders[ndx].name, name, nameLength))
+				return (RequestHeaderType) ndx;
+		}
+
+		return RequestHeaderUnknown;
+	}
+
+	int HttpRequestHeader::findHeader (string_constref headerName) const
+	{
+		RequestHeaderType type = getHeaderType (headerName.c_str(), headerName.size());
+		if (type != RequestHeaderUnknown)
+			return _knownHeaders[type];
+
+		string_constptr data = _buffer.c_str();
+		for (size_t ndx = 0; ndx < _headers.size(); ++ndx) {
+			if (_headers[ndx].nameLength == headerName.size() && 
+				equalsNoCase (data + _headers[ndx].nameOffset, headerName.c_str(), headerName.size()))
+				return (int) ndx;
+		}
+
+		return -1;
+	}
+
+	bool HttpRequestHeader::removeHeader (string_constref headerName) 
+	{
+		const int ndx = findHeader (headerName);
+		if (ndx == -1)
+			return false;
+
+		_headers.erase (_headers.begin() + ndx);
+		Headers.reset ();
+
+		// update known headers positions
+		resetKnownHeaders ();
+		for (size_t pos = 0; pos < _headers.size(); ++pos) {
+			if (_headers[pos].type != RequestHeaderUnknown && _knownHeaders[_headers[pos].type] == -1)
+				_knownHeaders[_headers[pos].type] = (int) pos;
+		}
+		
+		return true;
+	}
+
+	aconnect::str2str_map_ci HttpRequestHeader::getHeaders () const
+	{
+		aconnect::str2str_map_ci headers;
+		for (size_t ndx = 0; ndx < _headers.size(); ++ndx)
+			headers.insert (std::make_pair (headerName (ndx), headerValue (ndx)));
+		
+		return headers;
 	}
 
 	//////////////////////////////////////////////////////////////////////////
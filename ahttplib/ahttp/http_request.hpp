@@ -29,55 +29,149 @@ distribution.
 #pragma once
 
 #include <boost/utility.hpp>
+#include <assert.h>
+#include <vector>
 
 #include "aconnect/types.hpp"
 #include "aconnect/complex_types.hpp"
 
 namespace ahttp
 {
-	class HttpRequestHeader : private boost::noncopyable
+	// well-known request headers, stored values are accessible by index
+	enum RequestHeaderType
 	{
+		RequestHeaderUnknown = -1,
+		RequestHeaderAccept = 0,
+		RequestHeaderAcceptCharset,
+		RequestHeaderAcceptEncoding,
+		RequestHeaderAcceptLanguage,
+		RequestHeaderAuthorization,
+		RequestHeaderConnection,
+		RequestHeaderContentLength,
+		RequestHeaderContentType,
+		RequestHeaderCookie,
+		RequestHeaderHost,
+		RequestHeaderIfMatch,
+		RequestHeaderIfModifiedSince,
+		RequestHeaderIfNoneMatch,
+		RequestHeaderIfRange,
+		RequestHeaderIfUnmodifiedSince,
+		RequestHeaderKeepAlive,
+		RequestHeaderProxyConnection,
+		RequestHeaderRange,
+		RequestHeaderReferer,
+		RequestHeaderUserAgent
+	};
+
+	const int RequestHeaderTypesCount = 20;
+
+	class HttpRequestHeader;
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Read-only map view of request headers, kept for plugins written
+	//	against former 'HttpRequestHeader::Headers' map: copy is created
+	//	on the first access and dropped when headers are changed.
 
+	class HttpRequestHeadersView : private boost::noncopyable
+	{
 	public:
-		aconnect::str2str_map_ci Headers;
+		typedef aconnect::str2str_map_ci::const_iterator const_iterator;
+
+		explicit HttpRequestHeadersView (const HttpRequestHeader *owner) : 
+			_owner (owner), _loaded (false) { }
+
+		inline size_t size () const								{	return map().size();			}
+		inline bool empty () const								{	return map().empty();			}
+		inline const_iterator begin () const					{	return map().begin();			}
+		inline const_iterator end () const						{	return map().end();				}
+		inline const_iterator find (string_constref name) const	{	return map().find (name);		}
+		inline size_t count (string_constref name) const		{	return map().count (name);		}
+
+		inline void reset () {
+			if (_loaded) {
+				_map.clear();
+				_loaded = false;
+			}
+		}
 
+	protected:
+		const aconnect::str2str_map_ci& map () const;
+
+		const HttpRequestHeader *_owner;
+		mutable aconnect::str2str_map_ci _map;
+		mutable bool _loaded;
+	};
+
+	
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Request header is parsed in place: loaded headers are stored as
+	//	offsets in own copy of raw header, strings are created only on access.
+
+	class HttpRequestHeader : private boost::noncopyable
+	{
+
+	public:
 		int VersionHigh, VersionLow;
 		size_t ContentLength;				// Content-Length for POST
 
 		string Method;
 		string Path;		// path to source - with query string...
 
+		static const size_t InitialHeadersCapacity = 32;
+
+		// deprecated: copy of headers, use headersCount()/headerName()/headerValue()
+		HttpRequestHeadersView Headers;
+
 	public:
 		HttpRequestHeader () : 
 				VersionHigh(0), 
 				VersionLow(0), 
 				ContentLength (0), 
+				Headers (this),
 				_contentLengthLoaded (false)
-		{}
+		{
+			_headers.reserve (InitialHeadersCapacity);
+			resetKnownHeaders ();
+		}
 
 		void load (string_constref headerBody) throw (request_processing_error);
 		void clear ();
 		
 		inline bool hasHeader (string_constref headerName) const {
-			aconnect::str2str_map_ci::const_iterator iter = Headers.find (headerName);
-			return (iter != Headers.end());
+			return findHeader (headerName) != -1;
+		}
+		inline bool hasHeader (RequestHeaderType type) const {
+			return knownHeaderIndex (type) != -1;
 		}
+
 		inline string getHeader (string_constref headerName) const {
-			aconnect::str2str_map_ci::const_iterator iter = Headers.find (headerName);
-			if (iter == Headers.end())
+			const int ndx = findHeader (headerName);
+			if (ndx == -1)
+				return "";
+			return headerValue (ndx);
+		}
+		inline string getHeader (RequestHeaderType type) const {
+			const int ndx = knownHeaderIndex (type);
+			if (ndx == -1)
 				return "";
-			return iter->second;
+			return headerValue (ndx);
 		}
 
-		inline bool removeHeader (string_constref headerName)  {
-			aconnect::str2str_map_ci::iterator iter = Headers.find (headerName);
-			if (iter == Headers.end())
+		// raw value in header buffer, it is valid until clear() call
+		inline bool getHeaderValue (RequestHeaderType type, string_constptr &value, size_t &valueLength) const {
+			const int ndx = knownHeaderIndex (type);
+			if (ndx == -1)
 				return false;
-
-			Headers.erase (iter);
+			const HeaderRecord &record = _headers[ndx];
+			value = _buffer.data() + record.valueOffset;
+			valueLength = record.valueLength;
 			return true;
 		}
 
+		bool removeHeader (string_constref headerName);
+
 		inline string operator[] (string_constref headerName) const {
 			return getHeader (headerName);
 		}
@@ -85,11 +179,53 @@ namespace ahttp
 		inline bool isContentLengthRead() const  {
 			return _contentLengthLoaded;
 		}
+
+		// loaded headers enumeration (in request order)
+		inline size_t headersCount() const		{	return _headers.size();	}
+		
+		inline string headerName (size_t ndx) const {
+			assert (ndx < _headers.size());
+			return _buffer.substr (_headers[ndx].nameOffset, _headers[ndx].nameLength);
+		}
+		inline string headerValue (size_t ndx) const {
+			assert (ndx < _headers.size());
+			return _buffer.substr (_headers[ndx].valueOffset, _headers[ndx].valueLength);
+		}
+
+		// copy of all headers - for plugins which work with map
+		aconnect::str2str_map_ci getHeaders () const;
+
+		static RequestHeaderType getHeaderType (string_constptr name, size_t nameLength);
         
 	protected:
-		void loadHeader (string_constref name, string_constref value);
+		struct HeaderRecord
+		{
+			size_t nameOffset, nameLength;
+			size_t valueOffset, valueLength;
+			RequestHeaderType type;
+		};
+
+		void loadRequestLine (size_t begin, size_t end) throw (request_processing_error);
+		void loadHeader (size_t begin, size_t end) throw (request_processing_error);
+		int findHeader (string_constref headerName) const;
+		
+		// RequestHeaderUnknown and out of range types are not stored
+		inline int knownHeaderIndex (RequestHeaderType type) const {
+			if (type < 0 || type >= RequestHeaderTypesCount)
+				return -1;
+			return _knownHeaders[type];
+		}
+
+		inline void resetKnownHeaders () {
+			for (int ndx = 0; ndx < RequestHeaderTypesCount; ++ndx)
+				_knownHeaders[ndx] = -1;
+		}
 
 		bool _contentLengthLoaded;
+
+		string _buffer;							// raw header copy, record offsets point into it
+		std::vector<HeaderRecord> _headers;
+		int _knownHeaders[RequestHeaderTypesCount];	// index in _headers or -1
 	};
 
 
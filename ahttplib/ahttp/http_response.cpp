@@ -34,6 +34,7 @@ distribution.
 #include "aconnect/aconnect.hpp"
 #include "aconnect/util.hpp"
 #include "aconnect/util.time.hpp"
+#include "aconnect/util.network.hpp"
 
 // #include "ahttp/http_support.hpp"
 // #include "ahttp/http_server_settings.hpp"
@@ -50,12 +51,6 @@ namespace ahttp
 
 	void HttpResponse::fillCommonResponseHeaders () 
 	{
-		if (!Header.hasHeader (strings::HeaderServer) && !_serverName.empty() )
-			Header.Headers [strings::HeaderServer] = _serverName;
-		
-		if (!Header.hasHeader (strings::HeaderDate))
-			Header.Headers [strings::HeaderDate] = formatDate_RFC1123 (aconnect::util::getDateTimeUtc ());
-
 		if ( Header.Status == HttpStatus::OK && !Header.hasHeader (strings::HeaderContentType) )
 			Header.setContentType (strings::ContentTypeTextHtml);
 
@@ -72,9 +67,19 @@ namespace ahttp
 		
 		applyContentEncoding();
 		fillCommonResponseHeaders();
+		Stream.setLengthKnown (!Stream.isChunked());
 		
-		aconnect::util::writeToSocket (_clientInfo->sock, 
-			Header.getContent(), true);
+		// headers buffer is exchanged with stream one - memory is reused
+		_headersContent.clear();
+		Header.appendContent (_headersContent);
+
+		if (!Header.hasHeader (strings::HeaderServer))
+			_headersContent += _serverHeader;
+		if (!Header.hasHeader (strings::HeaderDate))
+			appendDateHeader (_headersContent);
+
+		_headersContent += strings::HeadersDelimiter;
+		Stream.setHeaders (_headersContent);
 		
 		_headersSent = true;
 
@@ -122,24 +127,75 @@ namespace ahttp
 			throw std::runtime_error ("Response already sent");
 
 		
+		// drop buffered content before headers are queued - clear() resets pending headers too
+		Stream.clear();
+
 		Header.setContentLength ( response.size ());
 		sendHeaders();
 	
-		Stream.clear();
 		Stream.writeDirectly (response);
 		
 		_finished = true;
 	}
 
 
-	void HttpResponse::write (string_constptr buff, size_t dataSize) 
+	bool HttpResponse::writeFile (string_constref filePath, std::streamsize offset, std::streamsize size) 
+		throw (std::runtime_error)
+	{
+		if (!prepareFileWriting ())
+			return false;
+
+		if (!canSendContent())
+			return true;
+
+		return aconnect::util::sendFileToSocket (Stream.socket(), filePath, offset, size);
+	}
+
+	bool HttpResponse::writeFile (int fileDescriptor, std::streamsize offset, std::streamsize size) 
+		throw (std::runtime_error)
+	{
+		if (!prepareFileWriting ())
+			return false;
+
+		if (!canSendContent())
+			return true;
+
+		return aconnect::util::sendFileToSocket (Stream.socket(), fileDescriptor, offset, size);
+	}
+
+	bool HttpResponse::prepareFileWriting () throw (std::runtime_error)
 	{
 		if (_finished)
 			throw std::runtime_error ("Response already sent");
 
-		if (!_headersSent && Stream.willBeFlushed ( dataSize ))
+		// content can be changed by modules - use buffered path
+		if (_context->hasModules (ModuleCallbackOnResponsePreSendContent)
+			|| !Header.hasHeader (strings::HeaderContentLength))
+			return false;
+
+		if (!_headersSent)
 			sendHeaders();
 
+		if (_finished || Stream.isChunked())
+			return false;
+
+		// file content follows headers immediately
+		Stream.flush (canSendContent());
+		return true;
+	}
+
+	void HttpResponse::write (string_constptr buff, size_t dataSize) 
+	{
+		if (_finished)
+			throw std::runtime_error ("Response already sent");
+
+		if (!_headersSent) {
+			Stream.setLengthKnown (Header.hasHeader (strings::HeaderContentLength));
+			
+			if (Stream.willBeFlushed ( dataSize ))
+				sendHeaders();
+		}
+
 		Stream.write (buff, dataSize);
 	}
 
@@ -171,7 +227,10 @@ namespace ahttp
 		if (!_headersSent && !Header.hasHeader (strings::HeaderContentLength)) 
 			Header.setContentLength ( Stream.getBufferContentSize() );
 		
-		flush();
+		if (!_headersSent)
+			sendHeaders();
+		
+		// headers, rest of content and last chunk are sent together
 		Stream.end();
 
 		_context->runModules (ModuleCallbackOnResponseEnd); 
@@ -209,84 +268,200 @@ namespace ahttp
 	//////////////////////////////////////////////////////////////////////////
 
 
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		ResponseMemoryBudget
+	//
+	bool ResponseMemoryBudget::acquire (size_t size)
+	{
+		using namespace aconnect;
+
+		const atomic_type limit = util::atomicLoad (&_limit);
+		const atomic_type used = util::atomicAdd (&_usedSize, (atomic_type) size);
+
+		if (limit > 0 && used > limit) {
+			util::atomicAdd (&_usedSize, -(atomic_type) size);
+			return false;
+		}
+
+		updateMax (&_highWaterMark, used);
+		return true;
+	}
+
+	void ResponseMemoryBudget::release (size_t size)
+	{
+		aconnect::util::atomicAdd (&_usedSize, -(aconnect::atomic_type) size);
+	}
+
+	void ResponseMemoryBudget::registerBufferSize (size_t size)
+	{
+		updateMax (&_maxBufferSize, (aconnect::atomic_type) size);
+	}
+
+	void ResponseMemoryBudget::updateMax (volatile aconnect::atomic_type *mark, aconnect::atomic_type value)
+	{
+		using namespace aconnect;
+		
+		atomic_type current = util::atomicLoad (mark);
+		while (value > current && !util::atomicCompareExchange (mark, current, value))
+			current = util::atomicLoad (mark);
+	}
+
 	//////////////////////////////////////////////////////////////////////////
 	//
 	//		HttpResponseStream
 	//
+	ResponseMemoryBudget HttpResponseStream::MemoryBudget;
+
+	bool HttpResponseStream::reserve (size_t size)
+	{
+		using namespace aconnect;
+
+		if (size <= _reservedSize)
+			return true;
+
+		const size_t limit = growthLimit ();
+		if (size > limit)
+			return false;
+
+		size_t newSize = util::max2 (InitialBufferSize, _reservedSize * 2);
+		while (newSize < size)
+			newSize *= 2;
+		newSize = util::min2 (newSize, limit);
+
+		if (!MemoryBudget.acquire (newSize - _reservedSize))
+			return false;
+
+		_buffer.reserve (newSize);
+		_reservedSize = newSize;
+		MemoryBudget.registerBufferSize (newSize);
+		
+		return true;
+	}
+
+	void HttpResponseStream::releaseBuffer ()
+	{
+		string().swap (_buffer);
+		MemoryBudget.release (_reservedSize);
+		_reservedSize = 0;
+	}
+
 	void HttpResponseStream::write (string_constref content) 
 	{	
-		_buffer.append (content);
-		if (_buffer.size() >= _maxBuffSize)
-			flush ();
+		write (content.c_str(), content.size());
 	};
 
 	void HttpResponseStream::write (string_constptr buff, size_t dataSize)
 	{	
-		_buffer.append (buff, dataSize);
-		if (_buffer.size() >= _maxBuffSize)
+		if (!reserve (_buffer.size() + dataSize)) 
+		{
+			if (_buffer.size() + dataSize <= growthLimit())
+				MemoryBudget.registerEarlyFlush ();
+			
 			flush ();
+
+			// content is too large for buffer or budget is exhausted - send it without copying
+			if (!reserve (dataSize)) {
+				send (buff, dataSize, false, false);
+				return;
+			}
+		}
+
+		_buffer.append (buff, dataSize);
 	};
 
 	void HttpResponseStream::writeDirectly (string_constref content) throw (aconnect::socket_error)
 	{
 		assert (!_chunked && "writeDirectly must not be called in 'chunked' mode");
-		if (_sendContent)
-			aconnect::util::writeToSocket (_socket, content, true);
+		
+		aconnect::util::WriteBuffer blocks[2] = { 
+			{ _headers.c_str(), _headers.size() }, 
+			{ content.c_str(), _sendContent ? content.size() : 0 } 
+		};
+		aconnect::util::writeToSocket (_socket, blocks, 2);
+		
+		_headers.clear();
 	}
 
-	void HttpResponseStream::flush () throw (aconnect::socket_error)
+	void HttpResponseStream::flush (bool hasMore) throw (aconnect::socket_error)
 	{	
+		send (_buffer.c_str(), _buffer.size(), false, hasMore);
+	};
+
+	void HttpResponseStream::end () throw (aconnect::socket_error)
+	{	
+		send (_buffer.c_str(), _buffer.size(), true, false);
+	};
+
+	void HttpResponseStream::send (string_constptr data, size_t dataSize, 
+		bool lastChunk, bool hasMore) throw (aconnect::socket_error)
+	{
 		using namespace aconnect;
 
-		if (_buffer.empty())
-			return;
+		// headers, up to 20 chunks (size, data, end mark) and last chunk mark
+		const size_t MaxBlocksCount = 64;
+		const int ChunkHeaderSize = 12;
 		
-		if (!_sendContent)
-			return;
+		util::WriteBuffer blocks[MaxBlocksCount];
+		char_type chunkHeaders[MaxBlocksCount / 3][ChunkHeaderSize];
+		size_t blocksCount = 0;
 
-		if (_chunked) {
-			const size_t bufferLen = _buffer.size();
-			size_t curPos = 0, chunkSize = bufferLen;
-			
-			const int chunkLenBufferSize = 8;
-			char_type chunkLenBuffer[chunkLenBufferSize] = {0};
-			int formatted = 0;
-
-			if (chunkSize > _maxChunkSize)
-				chunkSize = _maxChunkSize;
-			do 
-			{
-				// write chunk size
-				formatted = snprintf (chunkLenBuffer, chunkLenBufferSize, strings::ChunkHeaderFormat, chunkSize);
-				assert (formatted > 0 && "Error formatting chunk size");
-				util::writeToSocket (_socket, chunkLenBuffer, formatted);
-				
-				// write data
-				util::writeToSocket (_socket, _buffer.c_str() + curPos, 
-					(int) chunkSize);
-				
-				// write chunk end mark
-				util::writeToSocket (_socket, strings::ChunkEndMark);
+		if (!_headers.empty()) {
+			blocks[blocksCount].data = _headers.c_str();
+			blocks[blocksCount++].size = _headers.size();
+		}
 
-				curPos += chunkSize;
-				chunkSize = util::min2 (_maxChunkSize, bufferLen- curPos);
+		if (_sendContent && dataSize > 0)
+		{
+			if (_chunked) {
+				const size_t bufferLen = dataSize;
+				size_t curPos = 0, chunkSize = 0;
+				int chunkNdx = 0;
+
+				do 
+				{
+					// keep place for current chunk and last chunk mark
+					if (blocksCount + 4 > MaxBlocksCount) {
+						util::writeToSocket (_socket, blocks, blocksCount, true);
+						blocksCount = 0;
+						chunkNdx = 0;
+					}
+
+					chunkSize = util::min2 (_maxChunkSize, bufferLen - curPos);
+					
+					int formatted = snprintf (chunkHeaders[chunkNdx], ChunkHeaderSize, strings::ChunkHeaderFormat, (unsigned long) chunkSize);
+					assert (formatted > 0 && "Error formatting chunk size");
+					
+					blocks[blocksCount].data = chunkHeaders[chunkNdx++];
+					blocks[blocksCount++].size = formatted;
+					
+					blocks[blocksCount].data = data + curPos;
+					blocks[blocksCount++].size = chunkSize;
+					
+					blocks[blocksCount].data = strings::ChunkEndMark;
+					blocks[blocksCount++].size = strlen (strings::ChunkEndMark);
+
+					curPos += chunkSize;
+
+				} while (curPos < bufferLen);
+				
+			} else {
+				blocks[blocksCount].data = data;
+				blocks[blocksCount++].size = dataSize;
+			}
+		}
 
-			} while (curPos < bufferLen);
-			
-		} else {
-			util::writeToSocket (_socket, _buffer);
+		if (lastChunk && _chunked && _sendContent) {
+			blocks[blocksCount].data = strings::LastChunkFormat;
+			blocks[blocksCount++].size = strlen (strings::LastChunkFormat);
 		}
 
-		_buffer.clear();
-	};
+		if (blocksCount > 0)
+			util::writeToSocket (_socket, blocks, blocksCount, hasMore);
 
-	void HttpResponseStream::end () throw (aconnect::socket_error)
-	{	
-		if (_chunked && _sendContent) {
-			// write last chunk
-			aconnect::util::writeToSocket (_socket, string (strings::LastChunkFormat) );
-		}
-	};
+		_headers.clear();
+		_buffer.clear();
+	}
 }
 //
 //
@@ -31,6 +31,8 @@ distribution.
 
 #include "aconnect/types.hpp"
 #include "aconnect/complex_types.hpp"
+#include "aconnect/util.hpp"
+#include "aconnect/util.atomic.hpp"
 
 #include "http_support.hpp"
 
@@ -40,20 +42,80 @@ namespace ahttp
 	class HttpResponseStream;
 	class HttpResponse;
 
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Global limit of memory used by response buffers, 
+	//	buffers are grown only when memory is acquired from budget.
+
+	class ResponseMemoryBudget : private boost::noncopyable
+	{
+	public:
+		ResponseMemoryBudget () : 
+			_limit (0), 
+			_usedSize (0), 
+			_highWaterMark (0),
+			_maxBufferSize (0),
+			_earlyFlushesCount (0) 
+		{ }
+
+		// 'limit' - max buffers memory size (bytes), 0 - unlimited
+		inline void init (size_t limit) {
+			aconnect::util::atomicStore (&_limit, (aconnect::atomic_type) limit);
+		}
+
+		// returns false when budget is exhausted
+		bool acquire (size_t size);
+		void release (size_t size);
+		void registerBufferSize (size_t size);
+		
+		inline void registerEarlyFlush () {
+			aconnect::util::atomicAdd (&_earlyFlushesCount, 1);
+		}
+
+		inline long limit() const				{	return aconnect::util::atomicLoad (&_limit);				}
+		inline long usedSize() const			{	return aconnect::util::atomicLoad (&_usedSize);			}
+		inline long highWaterMark() const		{	return aconnect::util::atomicLoad (&_highWaterMark);		}
+		inline long maxBufferSize() const		{	return aconnect::util::atomicLoad (&_maxBufferSize);		}
+		inline long earlyFlushesCount() const	{	return aconnect::util::atomicLoad (&_earlyFlushesCount);	}
+
+	protected:
+		static void updateMax (volatile aconnect::atomic_type *mark, aconnect::atomic_type value);
+
+	// fields
+	protected:
+		volatile aconnect::atomic_type _limit;
+		volatile aconnect::atomic_type _usedSize;
+		volatile aconnect::atomic_type _highWaterMark;		// max total buffers size
+		volatile aconnect::atomic_type _maxBufferSize;		// max single response buffer size
+		volatile aconnect::atomic_type _earlyFlushesCount;	// flushes caused by exhausted budget
+	};
+
 	class HttpResponseStream : private boost::noncopyable
 	{
 	public:
 		HttpResponseStream  (size_t buffSize, size_t chunkSize) :
 			_maxBuffSize (buffSize),
 			_maxChunkSize (chunkSize),
+			_reservedSize (0),
 			_socket(INVALID_SOCKET),
 			_chunked (false),
-			_sendContent (true)
+			_sendContent (true),
+			_lengthKnown (false)
 		  {};
 
+		  ~HttpResponseStream () {
+			  releaseBuffer();
+		  }
+
 		  inline void clear ()  {
 			  _buffer.clear();
+			  _headers.clear();
 			  _chunked = false;
+			  _lengthKnown = false;
+			  
+			  // grown buffer is returned to budget, initial one is kept for the next response
+			  if (_reservedSize > InitialBufferSize)
+				  releaseBuffer();
 		  }
 
 		  inline void destroy ()  {
@@ -64,8 +126,10 @@ namespace ahttp
 		  inline void init (aconnect::socket_type sock) {	
 			  _socket = sock;
 		  };
-		  inline bool willBeFlushed (size_t contentSize) const {
-			  return ( (_buffer.size() + contentSize) >= _maxBuffSize );
+		  
+		  // check that buffer can be grown to store content (memory is reserved then)
+		  inline bool willBeFlushed (size_t contentSize) {
+			  return !reserve (_buffer.size() + contentSize);
 		  }
 		  inline size_t getBufferSize() const {
 			  return _maxBuffSize;
@@ -79,6 +143,9 @@ namespace ahttp
 
 		  friend class HttpResponse;
 
+		  static ResponseMemoryBudget MemoryBudget;
+		  static const size_t InitialBufferSize = 16 * 1024;	// bytes
+
 	private:
 		inline void setChunkedMode () {
 			_chunked = true;
@@ -91,21 +158,54 @@ namespace ahttp
 			_sendContent = writeContent;
 		}
 
+		// content of known length is not collected - buffer is not grown above initial size
+		inline void setLengthKnown (bool lengthKnown) {
+			_lengthKnown = lengthKnown;
+		}
+
+		// headers are sent together with the first content block
+		inline void setHeaders (string &headers) {
+			_headers.swap (headers);
+		}
+
+		/**
+		* Grow buffer to store 'size' bytes, memory is acquired from global budget
+		* @return	false when buffer size limit is reached or budget is exhausted
+		*/
+		bool reserve (size_t size);
+		void releaseBuffer ();
+
+		inline size_t growthLimit () const {
+			return _lengthKnown ? aconnect::util::min2 (InitialBufferSize, _maxBuffSize) : _maxBuffSize;
+		}
+
 		void write (string_constref content);
 		void write (string_constptr buff, size_t dataSize);
-		void flush () throw (aconnect::socket_error);
+		void flush (bool hasMore = false) throw (aconnect::socket_error);
 		void end () throw (aconnect::socket_error);
 		void writeDirectly (string_constref content) throw (aconnect::socket_error);
 		
+		/**
+		* Send pending headers and content (with chunks framing) by one socket write
+		* @param[in]	data		Content to send (buffer or not buffered content)
+		* @param[in]	dataSize	Content size
+		* @param[in]	lastChunk	Add last chunk mark in 'chunked' mode
+		* @param[in]	hasMore		Socket data will be continued immediately
+		*/
+		void send (string_constptr data, size_t dataSize, 
+			bool lastChunk, bool hasMore) throw (aconnect::socket_error);
 
 	protected:
 		size_t _maxBuffSize;
 		size_t _maxChunkSize;
+		size_t _reservedSize;	// buffer memory acquired from budget
 
 		string _buffer;
+		string _headers;	// pending headers
 		aconnect::socket_type _socket;
 		bool _chunked;
 		bool _sendContent;
+		bool _lengthKnown;
 	};
 
 	class HttpResponse : private boost::noncopyable
@@ -131,7 +231,7 @@ namespace ahttp
 			Stream.destroy();
 			_clientInfo = NULL;
 			_finished = _headersSent = false;
-			_serverName.clear();
+			setHttpMethod (ahttp::HttpMethod::Unknown);
 		}
 
 		inline void init (class HttpContext* context, const aconnect::ClientInfo* clientInfo) 
@@ -152,6 +252,14 @@ namespace ahttp
 		void flush () throw (aconnect::socket_error);
 		void writeCompleteResponse (string_constref response) throw (std::runtime_error);
 		void writeCompleteHtmlResponse (string_constref response) throw (std::runtime_error);
+		
+		/**
+		* Send file part directly from file descriptor (zero-copy), Content-Length must be set.
+		* @return	false when file content must be sent by write() calls:
+		*	response content is processed by modules or zero-copy sending is not supported
+		*/
+		bool writeFile (string_constref filePath, std::streamsize offset, std::streamsize size) throw (std::runtime_error);
+		bool writeFile (int fileDescriptor, std::streamsize offset, std::streamsize size) throw (std::runtime_error);
 
 		void end () throw (aconnect::socket_error);
 
@@ -160,8 +268,18 @@ namespace ahttp
 		inline bool isHeadersSent ()		{ return _headersSent;	};
 		inline bool canSendContent()		{ return _httpMethod != HttpMethod::Head;	};
 		
+		// 'Server' header line is prepared once for the same server name
 		inline void setServerName (string_constref serverName) {
+			if (serverName == _serverName)
+				return;
+			
 			_serverName = serverName;
+			_serverHeader.clear();
+			
+			if (!_serverName.empty()) {
+				_serverHeader.append (strings::HeaderServer).append (strings::HeaderValueDelimiter)
+					.append (_serverName).append (strings::HeadersDelimiter);
+			}
 		}
 		
 		// used to decide how to write content, for HEAD for example
@@ -177,6 +295,7 @@ namespace ahttp
 
 	protected:
 		void fillCommonResponseHeaders ();
+		bool prepareFileWriting () throw (std::runtime_error);
 		void applyContentEncoding ();
 
 	// properties
@@ -190,6 +309,8 @@ namespace ahttp
 		bool _headersSent;
 		bool _finished;	
 		string _serverName;
+		string _serverHeader;		// prepared 'Server' header line
+		string _headersContent;		// headers serialization buffer
 		ahttp::HttpMethod::HttpMethodType _httpMethod;
 	};
 
@@ -43,20 +43,28 @@ namespace ahttp
 {
 
 	string HttpResponseHeader::getContent ()
+	{
+		string content;
+		
+		appendContent (content);
+		content += strings::HeadersDelimiter;
+		
+		return content;
+	}
+
+	void HttpResponseHeader::appendContent (string& content) const
 	{
 		using namespace aconnect;
-		aconnect::str_stream content;
 
-		content << HttpResponseHeader::getResponseStatusString (Status, _customStatusString);
+		appendStatusString (content, Status, _customStatusString);
 
-		for (str2str_map_ci::iterator it = Headers.begin(); it != Headers.end(); it++)
+		for (str2str_map_ci::const_iterator it = Headers.begin(); it != Headers.end(); it++)
 		{
-			content << it->first << strings::HeaderValueDelimiter <<
-				it->second << strings::HeadersDelimiter;
+			content += it->first;
+			content += strings::HeaderValueDelimiter;
+			content += it->second;
+			content += strings::HeadersDelimiter;
 		}
-
-		content << strings::HeadersDelimiter;
-		return content.str();
 	}
 
 	void HttpResponseHeader::setContentLength (size_t length) 
@@ -72,12 +80,27 @@ namespace ahttp
 
 	string HttpResponseHeader::getResponseStatusString (int status, string_constref customStatusMsg)
 	{
-		aconnect::str_stream ret;
+		string ret;
+		appendStatusString (ret, status, customStatusMsg);
+		return ret;
+	}
+
+	void HttpResponseHeader::appendStatusString (string& content, int status, string_constref customStatusMsg)
+	{
+		string_constptr statusLine = NULL;
+		
+		if (customStatusMsg.empty() && NULL != (statusLine = strings::httpStatusLine (status))) {
+			content += statusLine;
+			return;
+		}
 
-		ret << strings::HttpVersion << " " << status
-			<< " " << (customStatusMsg.empty() ? strings::httpStatusDesc(status) : customStatusMsg) << strings::HeadersDelimiter;
+		aconnect::char_type buff[16];
+		snprintf (buff, sizeof (buff), " %d ", status);
 
-		return ret.str();
+		content += strings::HttpVersion;
+		content += buff;
+		content += (customStatusMsg.empty() ? strings::httpStatusDesc(status) : customStatusMsg);
+		content += strings::HeadersDelimiter;
 	}
 
 	void HttpResponseHeader::load (string_constptr statusString, string_constptr headerBody) 
@@ -56,11 +56,15 @@ namespace ahttp
 		}
 
 		string getContent ();
+		
+		// append status line and headers (without final delimiter) to 'content'
+		void appendContent (string& content) const;
 		void setContentLength (size_t length);
 		void setContentType (string_constref contentType, string_constref charset = "");
 		void load (string_constptr statusString, string_constptr headerBody) throw (request_processing_error);
 
 		static string getResponseStatusString (int status, string_constref customStatusMsg = "");
+		static void appendStatusString (string& content, int status, string_constref customStatusMsg = "");
 
 		// inlines
 		inline bool hasHeader (string_constref headerName) const {
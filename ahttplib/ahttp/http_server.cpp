@@ -31,6 +31,8 @@ distribution.
 #include <boost/algorithm/string.hpp>
 #include <boost/lexical_cast.hpp>
 #include <boost/regex.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/tss.hpp>
 
 #include <assert.h>
 
@@ -50,6 +52,37 @@ namespace ahttp
 {
 	HttpServerSettings* HttpServer::_globalSettings = NULL;
 	boost::detail::atomic_count HttpServer::RequestsCount (0);
+	FileInfoCache HttpServer::FileCache;
+	ResolvedTargetCache HttpServer::TargetCache;
+	DirectoryListingCache HttpServer::ListingCache;
+	string HttpServer::_serviceUnavailableResponse;
+	int HttpServer::_settingsGeneration = 0;
+
+	namespace
+	{
+		// HttpContext reused by worker thread for all processed requests
+		struct ThreadContext
+		{
+			ThreadContext () : settingsGeneration (0) { }
+
+			boost::scoped_ptr<HttpContext>	context;
+			int								settingsGeneration;
+		};
+
+		boost::thread_specific_ptr<ThreadContext> threadContext;
+
+		// drops request data when connection processing is completed
+		class ContextResetGuard : private boost::noncopyable
+		{
+		public:
+			ContextResetGuard (HttpContext &context) : _context (context) { }
+			~ContextResetGuard () {
+				_context.reset ();
+			}
+		private:
+			HttpContext &_context;
+		};
+	}
 
 	//////////////////////////////////////////////////////////////////////////
 	//
@@ -57,6 +90,14 @@ namespace ahttp
 	//
 	//
 	void HttpServer::processWorkerCreationError (const aconnect::socket_type clientSock) 
+	{
+		if (_serviceUnavailableResponse.empty()) // init was not called
+			aconnect::util::writeToSocket (clientSock, createServiceUnavailableResponse(), true);
+		else
+			aconnect::util::writeToSocket (clientSock, _serviceUnavailableResponse, true);
+	}
+
+	string HttpServer::createServiceUnavailableResponse ()
 	{
 		using namespace aconnect;
 		
@@ -71,8 +112,11 @@ namespace ahttp
 		response << strings::HeaderContentType << strings::HeaderValueDelimiter << strings::ContentTypeTextHtml << strings::HeadersDelimiter;
 		response << strings::HeaderContentLength << strings::HeaderValueDelimiter << content.length() << strings::HeadersDelimiter;
 		response << strings::HeaderServer << strings::HeaderValueDelimiter << GlobalSettings()->serverVersion() << strings::HeadersDelimiter;
+		response << strings::HeaderConnection << strings::HeaderValueDelimiter << strings::ConnectionClose << strings::HeadersDelimiter;
+		response << strings::HeadersDelimiter;
+		response << content;
 
-		aconnect::util::writeToSocket (clientSock, response.str(), true);
+		return response.str();
 	}
 
 	// check HTTP method availability - sent 501 on fail
@@ -248,6 +292,28 @@ namespace ahttp
 	//		HTTP request processing procedure
 	//////////////////////////////////////////////////////////////////////////
 
+	HttpContext& HttpServer::getThreadContext (const aconnect::ClientInfo& client)
+	{
+		ThreadContext *threadData = threadContext.get();
+		if (NULL == threadData) {
+			threadData = new ThreadContext ();
+			threadContext.reset (threadData);
+		}
+
+		// response buffers are sized by settings - recreate context after reload
+		if (!threadData->context || threadData->settingsGeneration != _settingsGeneration) {
+			threadData->context.reset (new HttpContext (&client, 
+				GlobalSettings(),
+				GlobalSettings()->logger()));
+			threadData->settingsGeneration = _settingsGeneration;
+		
+		} else {
+			threadData->context->reset (&client);
+		}
+
+		return *threadData->context;
+	}
+
 	void HttpServer::processConnection (const aconnect::ClientInfo& client)
 	{
 		using namespace aconnect;
@@ -255,14 +321,16 @@ namespace ahttp
 		try
 		{
 			bool isKeepAliveConnect = false;
+			
+			HttpContext *context = &getThreadContext (client);
+			ContextResetGuard guard (*context);
 
 			do {
 				requestString.clear();
-
-				std::auto_ptr<HttpContext> context( new HttpContext (
-					&client, 
-					HttpServer::GlobalSettings(),
-					HttpServer::GlobalSettings()->logger()));
+				
+				// keep-alive request - drop previous request data
+				if (isKeepAliveConnect)
+					context->reset ();
 
 				bool loaded = context->init (isKeepAliveConnect, 
 					GlobalSettings()->keepAliveTimeout());
@@ -278,16 +346,21 @@ namespace ahttp
 				if (context->isClosed())
 					break;
 
-				if (!GlobalSettings()->isKeepAliveEnabled())
+				if (!GlobalSettings()->isKeepAliveEnabled() || client.isReadClosed)
 					break;
 
-				connectionHeader = context->getServerVariable (strings::ServerVariables::HTTP_CONNECTION);
+				connectionHeader = context->getServerVariable (ServerVariable::HttpConnection);
 				
 				if (util::equals (context->Response.Header.Headers[strings::HeaderConnection], 
 						strings::ConnectionClose))
 					isKeepAliveConnect = false;
 				else
 					isKeepAliveConnect = util::equals (connectionHeader, strings::ConnectionKeepAlive);
+				
+				// reactor mode: wait for next request without worker locking
+				if (isKeepAliveConnect && 
+						client.server->resumeClient (client, GlobalSettings()->keepAliveTimeout()))
+					break;
 			
 			// process subsequent "Keep-Alive" requests
 			} while ( isKeepAliveConnect );
@@ -330,7 +403,8 @@ namespace ahttp
 			context.InitialVirtualPath = context.RequestHeader.Path.substr(0, context.RequestHeader.Path.find("?"));
 
 		if (context.RequestHeader.Path.length() > context.VirtualPath.length())
-			context.QueryString = context.RequestHeader.Path.substr (context.InitialVirtualPath.size() + 1);
+			context.setQueryString (context.RequestHeader.Path.c_str() + context.InitialVirtualPath.size() + 1,
+				context.RequestHeader.Path.size() - context.InitialVirtualPath.size() - 1);
 
 		bool stopKeepAlive = false;
         
@@ -366,7 +440,8 @@ namespace ahttp
 		
 		// check request state - it must be read at this point
 		} else if ( !context.RequestStream.isRead()) {
-			context.loadPostParams();
+			// body is not needed for error response - it is just drained
+			context.skipPostData();
 
 			processServerError(context, 
 				ahttp::HttpStatus::InternalServerError,
@@ -400,62 +475,119 @@ namespace ahttp
 		return stopKeepAlive;
 	}
 
-	void HttpServer::applyMappings (HttpContext& context, 
+	bool HttpServer::applyMappings (HttpContext& context, 
 		const struct DirectorySettings& dirSettings)
 	{
 		using namespace aconnect;
+		bool mapped = false;
 
 		if (!dirSettings.mappings.empty ()) {
 			
 			string virtualPath = context.InitialVirtualPath.substr (dirSettings.virtualPath.length());
             boost::smatch matches;
-			string val;
                 
 			for (mappings_vector::const_iterator iter = dirSettings.mappings.begin();
 					iter != dirSettings.mappings.end();
 					++iter) 
 			{
-				if (boost::regex_match (virtualPath, matches, boost::regex(iter->first) )) {
-					
-					string target = iter->second;
+				if (boost::regex_match (virtualPath, matches, iter->regex)) {
 					
-					for (int ndx = 1; ndx< (int) matches.size(); ++ndx) 
-					{
-						if (matches[ndx].matched) 
-							val = matches.str(ndx);
-                        else
-                            val.clear();
-						
-                        // skip "{{" and "}}"
-						boost::regex re ( "(^|[^\\{])\\{" + boost::lexical_cast<string> (ndx - 1) + "\\}([^\\}]|$)"); 
-						target = boost::regex_replace (target, re, "($1)" + matches.str(ndx) + "($2)", 
-							boost::match_default | boost::format_all );
-
-						// More simple variant:
-						// boost::regex re ( "\\{" + boost::lexical_cast<string> (ndx - 1) + "\\}"); 
-						// target = boost::regex_replace (target, re, matches.str(ndx));
-					}
+					const string target = iter->rewrite (matches);
 
 					// update path and query string
 					context.RequestHeader.Path = dirSettings.virtualPath + target;
 					context.VirtualPath = context.RequestHeader.Path.substr(0, context.RequestHeader.Path.find("?"));
 					if (context.RequestHeader.Path.length() > context.VirtualPath.length())
-						context.QueryString = context.RequestHeader.Path.substr (context.VirtualPath.size() + 1);
+						context.setQueryString (context.RequestHeader.Path.c_str() + context.VirtualPath.size() + 1,
+							context.RequestHeader.Path.size() - context.VirtualPath.size() - 1);
+					mapped = true;
 				}
 			}
 		}
 
+		return mapped;
+	}
+
+	resolved_target_ptr HttpServer::resolveTarget (HttpContext& context, 
+		const struct DirectorySettings& dirSettings)
+	{
+		using namespace aconnect;
+
+		// key: method class (GET/HEAD or other) + initial path,
+		// path rewritten by OnRequestResolve modules is added - file system path is built from it
+		string key;
+		if (TargetCache.isEnabled()) {
+			const bool rewritten = context.VirtualPath != context.InitialVirtualPath;
+
+			key.reserve (context.InitialVirtualPath.size() + 1 + 
+				(rewritten ? context.VirtualPath.size() + 1 : 0));
+			key += (context.Method == HttpMethod::Get || context.Method == HttpMethod::Head) ? 'G' : 'P';
+			key += context.InitialVirtualPath;
+
+			// line end cannot be a part of request path
+			if (rewritten) {
+				key += '\n';
+				key += context.VirtualPath;
+			}
+
+			resolved_target_ptr cached = TargetCache.get (key);
+			if (cached) {
+				if (cached->isMapped) {
+					context.RequestHeader.Path = cached->path;
+					context.VirtualPath = cached->virtualPath;
+					if (cached->hasQueryString)
+						context.setQueryString (cached->queryString.c_str(), cached->queryString.size());
+				}
+				context.FileSystemPath = cached->fileSystemPath;
+				
+				return cached;
+			}
+		}
+
+		ResolvedTarget *target = new ResolvedTarget ();
+		resolved_target_ptr res (target);
+
+		// apply mappings
+		if (applyMappings (context, dirSettings)) {
+			target->isMapped = true;
+			target->path = context.RequestHeader.Path;
+			target->virtualPath = context.VirtualPath;
+			target->hasQueryString = context.RequestHeader.Path.length() > context.VirtualPath.length();
+			if (target->hasQueryString)
+				target->queryString = context.QueryString;
+		}
+
+		// find real path
+		if (context.VirtualPath == dirSettings.virtualPath) {
+			context.FileSystemPath = fs::path (dirSettings.realPath, fs::native);
+		} else {
+			context.FileSystemPath = fs::complete (
+					fs::path (util::decodeUrl (context.VirtualPath.substr (
+						dirSettings.virtualPath.length())), fs::portable_name), 
+					fs::path (dirSettings.realPath, fs::native)
+				);
+		}
+		target->fileSystemPath = context.FileSystemPath;
+
+		findHandlers (target->handlers, dirSettings, fs::extension (context.FileSystemPath));
+		target->linkedDirectory = GlobalSettings()->router().findLinkedDirectory (context.InitialVirtualPath);
 
+		if (TargetCache.isEnabled())
+			TargetCache.store (key, res);
+
+		return res;
 	}
 
 
 	bool HttpServer::findTarget (HttpContext& context) 
 	{
 		using namespace aconnect;
-		const directories_map &directories = GlobalSettings()->Directories();
-		directories_map::const_iterator rootRecord = directories.find (strings::Slash);
+		const DirectoryRouter &router = GlobalSettings()->router();
+		
+		// find registered directory
+		const DirectorySettings* parentDirSettings = router.find (context.InitialVirtualPath);
  
-		if (rootRecord == directories.end()) 
+		if (NULL == parentDirSettings) 
 		{
 			Log()->error("Root web directory (\"/\") is not registered");
 
@@ -463,27 +595,8 @@ namespace ahttp
 			return false;
 		}
 
-		DirectorySettings parentDirSettings = rootRecord->second;
-
-		// find registered directory
-		if ( !util::equals (context.InitialVirtualPath, strings::Slash) ) 
-		{
-			string::size_type slashPos = 0;
-			directories_map::const_iterator dirIter;
-			string parentDir;
-			
-			while ((slashPos = context.InitialVirtualPath.find(strings::Slash, slashPos + 1)) != string::npos) {
-				parentDir = context.InitialVirtualPath.substr(0, slashPos + 1);
-				
-				if ( (dirIter = directories.find (parentDir)) != directories.end())
-					parentDirSettings = dirIter->second;
-				else
-					break;
-			} 
-		}
-
 		aconnect::ScopedMemberPointerGuard<HttpContext, const DirectorySettings*> 
-			guard (&context, &HttpContext::CurrentDirectoryInfo, &parentDirSettings);
+			guard (&context, &HttpContext::CurrentDirectoryInfo, parentDirSettings);
 
 		if ( context.runModules(ModuleCallbackOnRequestResolve) )
 			return false;
@@ -491,31 +604,19 @@ namespace ahttp
 
 		// check request size
 		if (context.RequestHeader.isContentLengthRead() 
-			&& context.RequestHeader.ContentLength > parentDirSettings.maxRequestSize) 
+			&& context.RequestHeader.ContentLength > parentDirSettings->maxRequestSize) 
 				throw request_too_large_error (context.RequestHeader.ContentLength, 
-					parentDirSettings.maxRequestSize);
-
-		// apply mappings
-		applyMappings (context, parentDirSettings);
-		
+					parentDirSettings->maxRequestSize);
 
-		// find real path
-		if (context.VirtualPath == parentDirSettings.virtualPath) {
-			context.FileSystemPath = fs::path (parentDirSettings.realPath, fs::native);
-		} else {
-			context.FileSystemPath = fs::complete (
-					fs::path (util::decodeUrl (context.VirtualPath.substr (
-						parentDirSettings.virtualPath.length())), fs::portable_name), 
-					fs::path (parentDirSettings.realPath, fs::native)
-				);
-		}
-		
+		resolved_target_ptr target = resolveTarget (context, *parentDirSettings);
 	
-		if ( runHandlers(context, parentDirSettings) )
+		if ( runHandlers(context, target->handlers) )
 			return false; // processed by handler
 
 		
-		if (fs::is_directory(context.FileSystemPath) ) 
+		context.FileSystemInfo = FileCache.get (context.FileSystemPath);
+
+		if (context.FileSystemInfo->isDirectory) 
 		{
 			if (context.InitialVirtualPath == context.VirtualPath
 				&& !algo::ends_with (context.InitialVirtualPath, strings::Slash)) {
@@ -523,29 +624,21 @@ namespace ahttp
 				redirectRequest (context, context.InitialVirtualPath + strings::Slash); // redirect
 			} else {
 				
-				processDirectoryRequest (context, parentDirSettings);
+				processDirectoryRequest (context, *parentDirSettings);
 			}
 
 			return false;
 		}
 
-		// find virtual dir, if found - redirect
-		directories_map::const_iterator virtDirIter = directories.begin();
-		const string virtDirPath = context.InitialVirtualPath + strings::Slash;
-		
-		while (virtDirIter != directories.end()) {
-			if (virtDirIter->second.isLinkedDirectory 
-				&& virtDirPath == virtDirIter->second.virtualPath) 
-			{
-				redirectRequest (context, virtDirPath); // redirect
-				return false;
-			}
-			virtDirIter++;
-		} 
+		// linked virtual dir found - redirect
+		if (target->linkedDirectory) {
+			redirectRequest (context, target->linkedDirectory->virtualPath); // redirect
+			return false;
+		}
 
 
 		// only real file can be there
-		if ( !fs::exists( context.FileSystemPath ) ) {
+		if ( !context.FileSystemInfo->exists ) {
 			// 404 error
 			processError404 (context);
 			return false;
@@ -555,31 +648,47 @@ namespace ahttp
 	}
 
 	bool HttpServer::runHandlers (HttpContext& context, const struct DirectorySettings& dirSettings)
+	{
+		std::vector<const PluginRegistrationInfo*> handlers;
+		findHandlers (handlers, dirSettings, fs::extension(context.FileSystemPath));
+
+		return runHandlers (context, handlers);
+	}
+
+	bool HttpServer::runHandlers (HttpContext& context, 
+		const std::vector<const PluginRegistrationInfo*>& handlers)
 	{
 		using namespace aconnect;
 
-		const string extension = fs::extension(context.FileSystemPath);
-		directory_plugins_list::const_iterator it;
-		
 		Log()->debug ("Run handler for \"%s\", directory settings: \"%s\"", 
 							context.FileSystemPath.string().c_str(),
-							dirSettings.name.c_str());		
+							context.CurrentDirectoryInfo->name.c_str());		
 
-		for (it = dirSettings.handlers.begin(); it != dirSettings.handlers.end(); ++it)
+		for (std::vector<const PluginRegistrationInfo*>::const_iterator it = handlers.begin(); 
+			it != handlers.end(); ++it)
 		{
-			if (it->isRequestApplicable(extension))
-			{
-				if ( context.runModules(ModuleCallbackOnRequestMapHandler) )
-					return true;
+			if ( context.runModules(ModuleCallbackOnRequestMapHandler) )
+				return true;
 
-				if (reinterpret_cast<process_request_function> (it->processFunc) (context, it->pluginIndex))
-					return true;
-			}
+			if (reinterpret_cast<process_request_function> ((*it)->processFunc) (context, (*it)->pluginIndex))
+				return true;
 		}
 
 		return false;
 	}
 
+	void HttpServer::findHandlers (std::vector<const PluginRegistrationInfo*>& handlers,
+		const struct DirectorySettings& dirSettings, string_constref extension)
+	{
+		directory_plugins_list::const_iterator it;
+		
+		for (it = dirSettings.handlers.begin(); it != dirSettings.handlers.end(); ++it)
+		{
+			if (it->isRequestApplicable(extension))
+				handlers.push_back (&(*it));
+		}
+	}
+
 		void HttpServer::processDirectoryRequest ( HttpContext& context, 
 											const DirectorySettings& dirSettings)
 	{
@@ -620,19 +729,17 @@ namespace ahttp
 			&& context.Method != HttpMethod::Head) 
 			return processError405 (context, "GET, HEAD");
 		
-		if ( !fs::exists( context.FileSystemPath ) ) {
+		if ( !context.FileSystemInfo->exists ) {
 			// 404 error
 			return processError404 (context);
 		}
 
-		string record;
-		
-		if ( fs::is_directory( context.FileSystemPath ) )
+		if ( context.FileSystemInfo->isDirectory )
 		{
 			// check "Accept-Charset" header
-			if (context.RequestHeader.hasHeader(strings::HeaderAcceptCharset)) 
+			if (context.RequestHeader.hasHeader (RequestHeaderAcceptCharset)) 
 			{
-				string acceptedCharsets = context.RequestHeader[strings::HeaderAcceptCharset];
+				string acceptedCharsets = context.RequestHeader.getHeader (RequestHeaderAcceptCharset);
 				
 				if ( !algo::contains (acceptedCharsets, strings::AnyContentCharsetMark) &&
 					!algo::icontains (acceptedCharsets, dirSettings.charset) &&
@@ -648,90 +755,44 @@ namespace ahttp
 
 			}
 
-			// start response
-			context.Response.Header.Status = 200;
-			context.Response.Header.setContentType (strings::ContentTypeTextHtml, dirSettings.charset);
-
-			// format header
-			context.Response.write (formatHeaderRecord (dirSettings, context.InitialVirtualPath));
-
-			if ( !util::equals (context.InitialVirtualPath, strings::Slash)) {
-				string parentDir = context.InitialVirtualPath.substr (0, context.InitialVirtualPath.rfind (strings::SlashCh, context.InitialVirtualPath.size() - 2) + 1);
-				context.Response.write (formatParentDirRecord (dirSettings, parentDir ));
-			}
+			// listing depends on requested path (links) and directory content
+			string listingKey;
+			directory_listing_ptr listing;
 			
-			std::vector<WebDirectoryItem> directoryItems;
-
-			// write virtual directories
-			const directories_map &directories = GlobalSettings()->Directories();
-			directories_map::const_iterator virtDirIter = directories.begin();
-
-			while (virtDirIter != directories.end()) {
-				if (virtDirIter->second.isLinkedDirectory &&
-						virtDirIter->second.parentName == dirSettings.name &&
-						context.InitialVirtualPath == dirSettings.virtualPath) 
-				{
-					WebDirectoryItem item;
-					item.url = virtDirIter->second.virtualPath;
-					item.name = virtDirIter->second.relativePath;
-					item.type = WdVirtualDirectory;
-					item.lastWriteTime = fs::last_write_time (virtDirIter->second.realPath);
-
-					directoryItems.push_back (item);
-				}
-
-				virtDirIter++;
-			} 
-
-			size_t fileCount = 0, dirCount = 0, errCount = 0;
+			if (ListingCache.isEnabled()) {
+				listingKey = context.InitialVirtualPath + strings::SlashCh + context.FileSystemInfo->path;
+				listing = ListingCache.get (listingKey);
+			}
 
-			// get filesystem items
-			readDirectoryContent (context.FileSystemPath.string(), 
-					context.InitialVirtualPath,
-					directoryItems,
-					*Log(),
-					errCount,
-					context.Client->server,
-					WdSortByTypeAndName);
-			
-			// write content
-			
-			for ( std::vector<WebDirectoryItem>::const_iterator itemIter = directoryItems.begin();
-				itemIter != directoryItems.end();
-				++itemIter )
+			if (!listing) 
 			{
+				const DirectoryWatch dirWatch = ListingCache.watch (context.FileSystemInfo->path);
 				
-				if (itemIter->type == WdVirtualDirectory) {
-					record = formatItemRecord (dirSettings.virtualDirectoryTemplate,
-						itemIter->url,
-						itemIter->name, 
-						(size_t) itemIter->size,
-						itemIter->lastWriteTime);
-				
-				} else if (itemIter->type == WdDirectory) {
-					record = formatItemRecord (dirSettings.directoryTemplate,
-						itemIter->url,
-						itemIter->name, 
-						(size_t)itemIter->size,
-						itemIter->lastWriteTime);
-					
-					++dirCount;
-
-				} else {
-					record = formatItemRecord (dirSettings.fileTemplate,
-							itemIter->url,
-							itemIter->name,
-							(size_t)itemIter->size,
-							itemIter->lastWriteTime);
-					++fileCount;
+				DirectoryListing *created = new DirectoryListing ();
+				listing.reset (created);
+				created->loadTime = std::time (NULL);
+
+				size_t errCount = 0;
+				try {
+					formatDirectoryListing (context, dirSettings, created->content, errCount);
+				} catch (...) {
+					ListingCache.release (dirWatch);
+					throw;
 				}
-
-				context.Response.write (record);
+				
+				// partially loaded listing is not cached
+				if (0 == errCount && !context.Client->server->isStopped())
+					ListingCache.store (listingKey, dirWatch, listing);
+				else
+					ListingCache.release (dirWatch);
 			}
 
-			// format footer
-			context.Response.write (formatFooterRecord (dirSettings, context.InitialVirtualPath,
-				fileCount, dirCount, errCount));
+			// send prepared content with known length
+			context.Response.Header.Status = 200;
+			context.Response.Header.setContentType (strings::ContentTypeTextHtml, dirSettings.charset);
+			context.Response.Header.setContentLength (listing->content.size());
+			
+			context.Response.write (listing->content);
 			context.Response.end();
 
 		} else {
@@ -743,6 +804,92 @@ namespace ahttp
 		}
 	}
 
+	void HttpServer::formatDirectoryListing (HttpContext& context, 
+		const DirectorySettings& dirSettings, 
+		string& content, size_t& errCount)
+	{
+		using namespace aconnect;
+		
+		ListingTemplate::Values values;
+		values.pageUrl = &context.InitialVirtualPath;
+
+		// format header
+		dirSettings.headerRecord.render (content, values);
+
+		if ( !util::equals (context.InitialVirtualPath, strings::Slash)) {
+			string parentDir = context.InitialVirtualPath.substr (0, context.InitialVirtualPath.rfind (strings::SlashCh, context.InitialVirtualPath.size() - 2) + 1);
+			
+			ListingTemplate::Values parentValues;
+			parentValues.parentUrl = &parentDir;
+			dirSettings.parentDirectoryRecord.render (content, parentValues);
+		}
+		
+		std::vector<WebDirectoryItem> directoryItems;
+
+		// write virtual directories
+		const directories_map &directories = GlobalSettings()->Directories();
+		directories_map::const_iterator virtDirIter = directories.begin();
+
+		while (virtDirIter != directories.end()) {
+			if (virtDirIter->second.isLinkedDirectory &&
+					virtDirIter->second.parentName == dirSettings.name &&
+					context.InitialVirtualPath == dirSettings.virtualPath) 
+			{
+				WebDirectoryItem item;
+				item.url = virtDirIter->second.virtualPath;
+				item.name = virtDirIter->second.relativePath;
+				item.type = WdVirtualDirectory;
+				item.lastWriteTime = fs::last_write_time (virtDirIter->second.realPath);
+
+				directoryItems.push_back (item);
+			}
+
+			virtDirIter++;
+		} 
+
+		size_t fileCount = 0, dirCount = 0;
+
+		// get filesystem items
+		readDirectoryContent (context.FileSystemPath.string(), 
+				context.InitialVirtualPath,
+				directoryItems,
+				*Log(),
+				errCount,
+				context.Client->server,
+				WdSortByTypeAndName);
+		
+		// write content
+		ListingTemplate::Values itemValues;
+		
+		for ( std::vector<WebDirectoryItem>::const_iterator itemIter = directoryItems.begin();
+			itemIter != directoryItems.end();
+			++itemIter )
+		{
+			itemValues.name = &itemIter->name;
+			itemValues.url = &itemIter->url;
+			itemValues.size = itemIter->size;
+			itemValues.time = itemIter->lastWriteTime;
+
+			if (itemIter->type == WdVirtualDirectory) {
+				dirSettings.virtualDirectoryRecord.render (content, itemValues);
+			
+			} else if (itemIter->type == WdDirectory) {
+				dirSettings.directoryRecord.render (content, itemValues);
+				++dirCount;
+
+			} else {
+				dirSettings.fileRecord.render (content, itemValues);
+				++fileCount;
+			}
+		}
+
+		// format footer
+		values.filesCount = fileCount;
+		values.directoriesCount = dirCount;
+		values.errorsCount = errCount;
+		dirSettings.footerRecord.render (content, values);
+	}
+
 	void HttpServer::processDirectFileRequest (HttpContext& context) 
 	{
 		using namespace aconnect;
@@ -756,30 +903,30 @@ namespace ahttp
 			&& context.Method != HttpMethod::Head) 
 			return processError405 (context, "GET, HEAD");
 
-		const string filePath = context.FileSystemPath.file_string();
+		if (!context.FileSystemInfo || context.FileSystemInfo->path != context.FileSystemPath.file_string())
+			context.FileSystemInfo = FileCache.get (context.FileSystemPath);
 
-		std::ifstream file (filePath.c_str());
-		if ( file.fail() ) 
+		const FileInfo& fileInfo = *context.FileSystemInfo;
+
+		if ( !fileInfo.isReadable ) 
 		{
 			// Access denied (404 checked previously)
 			processError403(context, getMessage("Error403_AccessDenied").c_str());
 			return;
 		}
-		file.close();
 		
-		std::time_t modifyTime = fs::last_write_time ( context.FileSystemPath);
-		std::streamsize fileSize = (std::streamsize) fs::file_size (context.FileSystemPath);
+		const std::time_t modifyTime = fileInfo.modifyTime;
 		bool loadRange = true; // process 'Range: XXX-YYY' if exists
 
-		string etag = util::calculateFileCrc (modifyTime, fileSize);
+		string_constref etag = fileInfo.etag;
 		
 		// add ETag
 		context.Response.Header.Headers[strings::HeaderETag] = etag;
 		
 		// process "If-Modified-Since" header
-		if (context.RequestHeader.hasHeader (strings::HeaderIfModifiedSince) ) 
+		if (context.RequestHeader.hasHeader (RequestHeaderIfModifiedSince) ) 
 		{
-			std::time_t inputModifyTime = getDateFrom_RFC1123 (context.RequestHeader.getHeader(strings::HeaderIfModifiedSince));
+			std::time_t inputModifyTime = getDateFrom_RFC1123 (context.RequestHeader.getHeader (RequestHeaderIfModifiedSince));
 			if (modifyTime <= inputModifyTime)
 			{
 				context.Response.Header.Status = 304;
@@ -788,56 +935,56 @@ namespace ahttp
 			}
 		}
 		// process "If-None-Match"
-		else if (context.RequestHeader.hasHeader (strings::HeaderIfNoneMatch) ) 
+		else if (context.RequestHeader.hasHeader (RequestHeaderIfNoneMatch) ) 
 		{
-			if (etag == context.RequestHeader.Headers[strings::HeaderIfNoneMatch])
+			if (etag == context.RequestHeader.getHeader (RequestHeaderIfNoneMatch))
 			{
 				context.Response.Header.Status = 304;
 				context.Response.Header.setContentLength ( 0 );
 				return;
 			}
 		}
-		else if (context.RequestHeader.hasHeader (strings::HeaderIfRange) ) 
+		else if (context.RequestHeader.hasHeader (RequestHeaderIfRange) ) 
 		{
-			if (!util::equals (context.RequestHeader.getHeader (strings::HeaderIfRange), etag) )
+			if (!util::equals (context.RequestHeader.getHeader (RequestHeaderIfRange), etag) )
 				loadRange = false;
 		}
-		else if (context.RequestHeader.hasHeader (strings::HeaderIfUnmodifiedSince) ) 
+		else if (context.RequestHeader.hasHeader (RequestHeaderIfUnmodifiedSince) ) 
 		{
-			std::time_t inputModifyTime = getDateFrom_RFC1123 (context.RequestHeader.getHeader(strings::HeaderIfUnmodifiedSince));
+			std::time_t inputModifyTime = getDateFrom_RFC1123 (context.RequestHeader.getHeader (RequestHeaderIfUnmodifiedSince));
 			if (modifyTime > inputModifyTime)
 				loadRange = false;
 		}
-		else if (context.RequestHeader.hasHeader (strings::HeaderIfMatch) ) 
+		else if (context.RequestHeader.hasHeader (RequestHeaderIfMatch) ) 
 		{
 			// RFC 2616: 14.24 If-Match - send 412 (Precondition Failed) if entity is not the same
-			if (!util::equals (context.RequestHeader.getHeader (strings::HeaderIfMatch), etag) ) 
+			if (!util::equals (context.RequestHeader.getHeader (RequestHeaderIfMatch), etag) ) 
 			{
 				context.Response.Header.Status = HttpStatus::PreconditionFailed;
 				return;
 			}
 		}
 
-		Log()->debug ("Send file: %s", filePath.c_str());
+		Log()->debug ("Send file: %s", fileInfo.path.c_str());
 		
-		sendFileToClient (context, fileSize, filePath, modifyTime, loadRange);
+		sendFileToClient (context, fileInfo, loadRange);
 	}
 
 
 	void HttpServer::sendFileToClient (HttpContext& context, 
-			std::streamsize fileSize, 
-			string_constref filePath, 
-			std::time_t modifyTime,
+			const FileInfo& fileInfo,
 			bool loadRange) 
 	{
 		using namespace aconnect;
 
+		const std::streamsize fileSize = fileInfo.size;
+		string_constref filePath = fileInfo.path;
+
 		// prepare response
 		context.Response.Header.Status = HttpStatus::OK;
 		context.Response.Header.setContentLength ( fileSize );
-		context.Response.Header.setContentType ( context.GlobalSettings->getMimeType (
-			fs::extension (context.FileSystemPath) ).c_str() );
-		context.Response.Header.Headers[strings::HeaderLastModified] = formatDate_RFC1123 (util::getDateTimeUtc (modifyTime));
+		context.Response.Header.setContentType ( fileInfo.mimeType.c_str() );
+		context.Response.Header.Headers[strings::HeaderLastModified] = formatDate_RFC1123 (util::getDateTimeUtc (fileInfo.modifyTime));
 		context.Response.Header.Headers[strings::HeaderAcceptRanges] = strings::AcceptRangesBytes;
 		
 		// send file
@@ -846,10 +993,10 @@ namespace ahttp
 			std::streamsize fileOffset = 0,
 				requestedAmount = fileSize;
 			
-			if (loadRange && context.RequestHeader.hasHeader (strings::HeaderRange)) 
+			if (loadRange && context.RequestHeader.hasHeader (RequestHeaderRange)) 
 			{
 				bool rangeValid = true;
-				string range = context.RequestHeader.getHeader (strings::HeaderRange);
+				string range = context.RequestHeader.getHeader (RequestHeaderRange);
 				
 				range = range.substr (strlen(strings::AcceptRangesBytes) + 1); // "bytes="
 				
@@ -904,15 +1051,21 @@ namespace ahttp
 
 				context.Response.Header.Status = HttpStatus::PartialContent;
 				context.Response.Header.Headers[strings::HeaderContentRange] = contentRange.str();
+				context.Response.Header.setContentLength ( requestedAmount );
 			}
 
 			if (context.Method == HttpMethod::Head) 
 				// IMPORTANT: all headers collected, in case empty file correct
 				// response will be sent
 				return;
+
+			// zero-copy sending, buffered path is used when content is processed by modules
+			if (fileInfo.fd != -1 ? context.Response.writeFile (fileInfo.fd, fileOffset, requestedAmount) 
+					: context.Response.writeFile (filePath, fileOffset, requestedAmount))
+				return;
 	
 			const std::streamsize buffSize = (std::streamsize) util::min2( requestedAmount, 
-				(std::streamsize) context.Response.Stream.getBufferSize());
+				(std::streamsize) defaults::ReadBufferSize);
 			boost::scoped_array<char_type> buff (new char_type [buffSize]);
 			
 			std::ifstream file (filePath.c_str(), std::ios::binary);
@@ -926,80 +1079,18 @@ namespace ahttp
 			{
 				assert (file.good());
 
-				file.read (buff.get(), buffSize);
+				file.read (buff.get(), util::min2 (buffSize, requestedAmount - totalRead));
 
 				readBytes = file.gcount();
 				totalRead += readBytes;
 
 				context.Response.write (buff.get(), readBytes);
 
-			} while (totalRead < requestedAmount);
+			} while (totalRead < requestedAmount && readBytes > 0);
 
 			file.close();
 		}
 	}
-
-
-	string HttpServer::formatHeaderRecord (const DirectorySettings& dirSettings, 
-													   string_constref virtualPath) 
-	{
-		string record = algo::replace_all_copy (dirSettings.headerTemplate,
-		   SettingsTags::PageUrlMark, virtualPath);
-		return record;
-	}
-
-	string HttpServer::formatParentDirRecord (const DirectorySettings& dirSettings, 
-													   string_constref parentPath) 
-	{
-		string record = algo::replace_all_copy (dirSettings.parentDirectoryTemplate,
-			SettingsTags::ParentUrlMark, parentPath);
-		return record;
-	}
-
-	string HttpServer::formatItemRecord (string_constref itemTemplate,
-		string_constref itemUrl,
-		string_constref itemName,
-		const size_t itemSize,
-		std::time_t lastWriteTime) 
-	{
-		string record = algo::replace_all_copy (itemTemplate,
-			SettingsTags::UrlMark, itemUrl);
-		algo::replace_all (record, SettingsTags::NameMark, itemName);
-
-		if (itemSize != (size_t)-1) 
-		{
-			string size = boost::lexical_cast<string> (itemSize);
-			const size_t minWidth = 16;
-
-			if (size.size() < minWidth)
-				size.insert(0, minWidth - size.size(), ' ');
-
-			algo::replace_all (record, SettingsTags::SizeMark, size);
-		}
-
-		if (lastWriteTime != (std::time_t) -1)
-			algo::replace_all (record, SettingsTags::TimeMark,
-			formatDateTime ( aconnect::util::getDateTimeUtc(lastWriteTime) ) );
-
-		return record;
-	}
-
-	string HttpServer::formatFooterRecord (const DirectorySettings& dirSettings, 
-													   string_constref virtualPath,
-													   const size_t fileCount, const size_t dirCount, const size_t errCount) 
-	{
-		string record = algo::replace_all_copy (dirSettings.footerTemplate,
-			SettingsTags::PageUrlMark, virtualPath);
-
-		algo::replace_all (record, SettingsTags::FilesCountMark, 
-			boost::lexical_cast<string> (fileCount) );
-		algo::replace_all (record, SettingsTags::DirectoriesCountMark, 
-			boost::lexical_cast<string> (dirCount) );
-		algo::replace_all (record, SettingsTags::ErrorsCountMark, 
-			boost::lexical_cast<string> (errCount) );
-
-		return record;
-	}
 }
 
 
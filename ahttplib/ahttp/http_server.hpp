@@ -43,6 +43,8 @@ namespace ahttp
 	{
 	private:
 		static HttpServerSettings* _globalSettings;
+		static string _serviceUnavailableResponse;	// complete 503 response, prepared in init
+		static int _settingsGeneration;				// incremented on each settings (re)load
 		
 	public:
 		static HttpServerSettings* GlobalSettings() throw (std::runtime_error) {
@@ -65,9 +67,23 @@ namespace ahttp
 
 		static void init (HttpServerSettings* settings) {
 			_globalSettings = settings;
+			++_settingsGeneration;
+			
+			if (_globalSettings) {
+				_serviceUnavailableResponse = createServiceUnavailableResponse ();
+				FileCache.init (_globalSettings, (size_t) aconnect::util::max2 (_globalSettings->fileCacheSize(), 0), 
+					_globalSettings->fileCacheTtl());
+				TargetCache.init ((size_t) aconnect::util::max2 (_globalSettings->targetCacheSize(), 0));
+				ListingCache.init ((size_t) aconnect::util::max2 (_globalSettings->listingCacheSize(), 0), 
+					_globalSettings->fileCacheTtl());
+				HttpResponseStream::MemoryBudget.init (_globalSettings->responseMemoryLimit());
+			}
 		}
 
 		static boost::detail::atomic_count RequestsCount;
+		static FileInfoCache FileCache;
+		static ResolvedTargetCache TargetCache;
+		static DirectoryListingCache ListingCache;
 
 		/**
 		* Process HTTP request (and following keep-alive requests on opened socket)
@@ -118,59 +134,55 @@ namespace ahttp
 		
 	private:
 		
+		static string createServiceUnavailableResponse ();
+
+		// get worker thread HttpContext prepared to process connection
+		static HttpContext& getThreadContext (const aconnect::ClientInfo& client);
+
 		static bool isMethodImplemented (HttpContext& context);
 		
 		static bool findTarget (HttpContext& context);
 
+		/**
+		* Apply mappings and find file system path and handlers of requested target,
+		* cached decision is used when it is available.
+		* @param[in/out]	context		Filled HttpContext instance
+		* @param[in]		dirSettings	Settings of directory which contains target
+		*/
+		static resolved_target_ptr resolveTarget (HttpContext& context, const struct DirectorySettings& dirSettings);
+
 		/**
 		* Run handlers registered for current directory against current target,
 		* returns true if request was completed.
 		* @param[in/out]	context		Filled HttpContext instance
 		*/
 		static bool runHandlers (HttpContext& context, const struct DirectorySettings& dirSettings);
+		static bool runHandlers (HttpContext& context, 
+			const std::vector<const PluginRegistrationInfo*>& handlers);
+
+		static void findHandlers (std::vector<const PluginRegistrationInfo*>& handlers,
+			const struct DirectorySettings& dirSettings, string_constref extension);
 		
-		static void applyMappings (HttpContext& context, const struct DirectorySettings& dirSettings);
+		// returns true if request path was changed by mapping
+		static bool applyMappings (HttpContext& context, const struct DirectorySettings& dirSettings);
 
 		static void processDirectFileRequest (HttpContext& context);
 		
 		static void sendFileToClient (HttpContext& context, 
-			std::streamsize fileSize, 
-			string_constref filePath, 
-			std::time_t modifyTime,
+			const FileInfo& fileInfo,
 			bool loadRange);
 
 		static void processDirectoryRequest (HttpContext& context, 
 			const struct DirectorySettings& dirSettings);
 
-		static string formatParentDirRecord (const DirectorySettings& dirSettings, 
-			string_constref parentPath);
-		static string formatHeaderRecord (const DirectorySettings& dirSettings, 
-			string_constref virtualPath);
-		static string formatItemRecord (string_constref itemTemplate,
-			string_constref itemUrl,
-			string_constref itemName,
-			const size_t itemSize,
-			std::time_t lastWriteTime);
-		static string formatFooterRecord (const DirectorySettings& dirSettings, 
-			string_constref virtualPath,
-			const size_t fileCount, const size_t dirCount, const size_t errCount);
-
-		inline static string formatDateTime (const struct tm& dateTime)
-		{
-			const int buffSize = 20;
-			aconnect::char_type buff[buffSize] = {0};
-
-			int cnt = snprintf (buff, buffSize, "%.2d.%.2d.%.4d %.2d:%.2d:%.2d", 
-				dateTime.tm_mday,
-				dateTime.tm_mon + 1,
-				dateTime.tm_year + 1900,
-				dateTime.tm_hour,
-				dateTime.tm_min,
-				dateTime.tm_sec
-				);
-
-			return string (buff, aconnect::util::min2(cnt, buffSize) );
-		}
+		/**
+		* Render complete HTML page with directory content
+		* @param[out]	content		Rendered page
+		* @param[out]	errCount	Count of directory items which can not be loaded
+		*/
+		static void formatDirectoryListing (HttpContext& context, 
+			const struct DirectorySettings& dirSettings,
+			string& content, size_t& errCount);
 	};
 }
 #endif // AHTTP_SERVER_H
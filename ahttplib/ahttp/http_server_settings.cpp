@@ -33,11 +33,13 @@ distribution.
 #include <boost/lexical_cast.hpp>
 
 #include <assert.h>
+#include <algorithm>
 
 #include "tinyxml/tinyxml.h"
 
 #include "aconnect/util.hpp"
 #include "aconnect/util.string.hpp"
+#include "aconnect/util.time.hpp"
 
 #include "ahttp/http_support.hpp"
 #include "ahttp/http_server_settings.hpp"
@@ -76,6 +78,401 @@ namespace ahttp
 
 	}
 
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		ModuleCallbacksTable
+	//
+
+	void ModuleCallbacksTable::build (const directory_plugins_list& modules)
+	{
+		clear ();
+
+		// grouped by callback type, registration order is kept
+		for (int type = 0; type < ModuleCallbackTypesCount; ++type) 
+		{
+			offsets[type] = records.size();
+			
+			for (directory_plugins_list::const_iterator it = modules.begin(); it != modules.end(); ++it) {
+				if (it->moduleCallbacks[type]) {
+					Record record = { it->moduleCallbacks[type], it->pluginIndex };
+					records.push_back (record);
+				}
+			}
+		}
+
+		offsets[ModuleCallbackTypesCount] = records.size();
+	}
+
+	void ModuleCallbacksTable::clear ()
+	{
+		records.clear();
+		std::fill (offsets, offsets + ModuleCallbackTypesCount + 1, (size_t) 0);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		UrlMapping
+	//
+
+	UrlMapping::UrlMapping (string_constptr regexStr, string_constref targetTemplate) :
+		regex (regexStr),
+		target (targetTemplate)
+	{
+		compile ();
+	}
+
+	void UrlMapping::compile ()
+	{
+		segments.clear();
+
+		Segment literal;
+		literal.group = -1;
+		
+		const size_t length = target.size();
+		size_t pos = 0;
+		
+		while (pos < length) 
+		{
+			// "{N}" - substitution, "{{N}" and "{N}}" are skipped
+			if (target[pos] == '{') {
+				size_t numEnd = pos + 1;
+				while (numEnd < length && isdigit ((unsigned char) target[numEnd]))
+					++numEnd;
+
+				if (numEnd > pos + 1 && numEnd < length && target[numEnd] == '}'
+					&& !(pos > 0 && target[pos - 1] == '{') 
+					&& !(numEnd + 1 < length && target[numEnd + 1] == '}'))
+				{
+					if (!literal.text.empty()) {
+						segments.push_back (literal);
+						literal.text.clear();
+					}
+
+					Segment group;
+					group.text = target.substr (pos, numEnd - pos + 1);
+					group.group = atoi (group.text.c_str() + 1) + 1; // {0} - first regex group
+					segments.push_back (group);
+
+					pos = numEnd + 1;
+					continue;
+				}
+			}
+
+			literal.text += target[pos++];
+		}
+
+		if (!literal.text.empty())
+			segments.push_back (literal);
+	}
+
+	string UrlMapping::rewrite (const boost::smatch &matches) const
+	{
+		string res;
+		res.reserve (target.size() + 64);
+
+		for (std::vector<Segment>::const_iterator it = segments.begin(); it != segments.end(); ++it) 
+		{
+			if (it->group == -1)
+				res.append (it->text);
+			else if (it->group < (int) matches.size())
+				res.append (matches[it->group].first, matches[it->group].second);
+			else
+				res.append (it->text); // there is no such group
+		}
+
+		return res;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		ListingTemplate
+	//
+
+	namespace
+	{
+		struct ListingMark
+		{
+			string_constptr					mark;
+			ListingField::ListingFieldType	field;
+		};
+
+		const ListingMark ListingMarks[] = 
+		{
+			{ SettingsTags::NameMark,				ListingField::Name },
+			{ SettingsTags::UrlMark,				ListingField::Url },
+			{ SettingsTags::SizeMark,				ListingField::Size },
+			{ SettingsTags::TimeMark,				ListingField::Time },
+			{ SettingsTags::PageUrlMark,			ListingField::PageUrl },
+			{ SettingsTags::ParentUrlMark,			ListingField::ParentUrl },
+			{ SettingsTags::FilesCountMark,			ListingField::FilesCount },
+			{ SettingsTags::DirectoriesCountMark,	ListingField::DirectoriesCount },
+			{ SettingsTags::ErrorsCountMark,		ListingField::ErrorsCount }
+		};
+
+		// append decimal number right-aligned in 'minWidth' symbols
+		void appendNumber (string& content, boost::uintmax_t value, size_t minWidth = 0)
+		{
+			char_type buff[24];
+			char_type *pos = buff + sizeof (buff);
+
+			do {
+				*--pos = (char_type) ('0' + value % 10);
+				value /= 10;
+			} while (value > 0);
+
+			const size_t length = buff + sizeof (buff) - pos;
+			if (length < minWidth)
+				content.append (minWidth - length, ' ');
+			content.append (pos, length);
+		}
+
+		// sample: 06.11.1994 08:49:37
+		void appendDateTime (string& content, std::time_t time)
+		{
+			const struct tm dateTime = aconnect::util::getDateTimeUtc (time);
+			
+			const int buffSize = 20;
+			char_type buff[buffSize];
+
+			int cnt = snprintf (buff, buffSize, "%.2d.%.2d.%.4d %.2d:%.2d:%.2d", 
+				dateTime.tm_mday,
+				dateTime.tm_mon + 1,
+				dateTime.tm_year + 1900,
+				dateTime.tm_hour,
+				dateTime.tm_min,
+				dateTime.tm_sec);
+
+			if (cnt > 0)
+				content.append (buff, util::min2 (cnt, buffSize - 1));
+		}
+	}
+
+	void ListingTemplate::compile (string_constref source)
+	{
+		segments.clear();
+		
+		Segment literal;
+		literal.field = ListingField::Literal;
+
+		const size_t marksCount = sizeof (ListingMarks) / sizeof (ListingMarks[0]);
+		size_t pos = 0;
+
+		while (pos < source.size()) 
+		{
+			if (source[pos] == '{') 
+			{
+				size_t ndx = 0;
+				for (; ndx < marksCount; ++ndx) {
+					if (source.compare (pos, strlen (ListingMarks[ndx].mark), ListingMarks[ndx].mark) == 0)
+						break;
+				}
+
+				if (ndx < marksCount) {
+					if (!literal.text.empty()) {
+						segments.push_back (literal);
+						literal.text.clear();
+					}
+
+					Segment field;
+					field.field = ListingMarks[ndx].field;
+					field.text = ListingMarks[ndx].mark;
+					segments.push_back (field);
+
+					pos += field.text.size();
+					continue;
+				}
+			}
+
+			literal.text += source[pos++];
+		}
+
+		if (!literal.text.empty())
+			segments.push_back (literal);
+	}
+
+	void ListingTemplate::render (string& content, const Values& values) const
+	{
+		const size_t sizeMinWidth = 16;
+
+		for (std::vector<Segment>::const_iterator it = segments.begin(); it != segments.end(); ++it) 
+		{
+			switch (it->field)
+			{
+			case ListingField::Name:
+				if (values.name)	aconnect::util::appendEscapedHtml (content, values.name->c_str(), values.name->size());
+				else				content.append (it->text);
+				break;
+			case ListingField::Url:
+				content.append (values.url ? *values.url : it->text);
+				break;
+			case ListingField::PageUrl:
+				content.append (values.pageUrl ? *values.pageUrl : it->text);
+				break;
+			case ListingField::ParentUrl:
+				content.append (values.parentUrl ? *values.parentUrl : it->text);
+				break;
+
+			case ListingField::Size:
+				if (values.size != (boost::uintmax_t) -1)	appendNumber (content, values.size, sizeMinWidth);
+				else										content.append (it->text);
+				break;
+			case ListingField::Time:
+				if (values.time != (std::time_t) -1)		appendDateTime (content, values.time);
+				else										content.append (it->text);
+				break;
+
+			case ListingField::FilesCount:
+				if (values.filesCount != (size_t) -1)		appendNumber (content, values.filesCount);
+				else										content.append (it->text);
+				break;
+			case ListingField::DirectoriesCount:
+				if (values.directoriesCount != (size_t) -1)	appendNumber (content, values.directoriesCount);
+				else										content.append (it->text);
+				break;
+			case ListingField::ErrorsCount:
+				if (values.errorsCount != (size_t) -1)		appendNumber (content, values.errorsCount);
+				else										content.append (it->text);
+				break;
+
+			default:
+				content.append (it->text);
+			}
+		}
+	}
+
+	void DirectorySettings::compileTemplates ()
+	{
+		headerRecord.compile (headerTemplate);
+		directoryRecord.compile (directoryTemplate);
+		parentDirectoryRecord.compile (parentDirectoryTemplate);
+		virtualDirectoryRecord.compile (virtualDirectoryTemplate);
+		fileRecord.compile (fileTemplate);
+		footerRecord.compile (footerTemplate);
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		DirectoryRouter
+	//
+
+	namespace
+	{
+		struct SegmentLess
+		{
+			inline bool operator() (const std::pair<string, int> &item, 
+				const std::pair<string_constptr, size_t> &segment) const {
+				return item.first.compare (0, string::npos, segment.first, segment.second) < 0;
+			}
+		};
+	}
+
+	void DirectoryRouter::clear ()
+	{
+		_nodes.clear();
+		_nodes.resize (1);
+		_nodes[0].settings = NULL;
+	}
+
+	void DirectoryRouter::build (const directories_map& directories)
+	{
+		clear ();
+
+		for (directories_map::const_iterator it = directories.begin(); it != directories.end(); ++it)
+		{
+			string_constref path = it->second.virtualPath;
+			assert (!path.empty() && path[0] == strings::SlashCh);
+			
+			int nodeNdx = 0;
+			size_t segmentStart = 1, slashPos;
+			
+			while ((slashPos = path.find (strings::SlashCh, segmentStart)) != string::npos) {
+				nodeNdx = addChild (nodeNdx, path.substr (segmentStart, slashPos - segmentStart));
+				segmentStart = slashPos + 1;
+			}
+
+			_nodes[nodeNdx].settings = &it->second;
+		}
+	}
+
+	int DirectoryRouter::addChild (int nodeNdx, string_constref segment)
+	{
+		int childNdx = findChild (nodeNdx, segment.c_str(), segment.size());
+		if (childNdx != -1)
+			return childNdx;
+
+		childNdx = (int) _nodes.size();
+		_nodes.push_back (Node());
+		_nodes.back().settings = NULL;
+
+		std::vector<std::pair<string, int> > &children = _nodes[nodeNdx].children;
+		std::vector<std::pair<string, int> >::iterator pos = std::lower_bound (children.begin(), children.end(), 
+			std::make_pair (segment.c_str(), segment.size()), SegmentLess());
+		
+		children.insert (pos, std::make_pair (segment, childNdx));
+		return childNdx;
+	}
+
+	int DirectoryRouter::findChild (int nodeNdx, string_constptr segment, size_t length) const
+	{
+		const std::vector<std::pair<string, int> > &children = _nodes[nodeNdx].children;
+		std::vector<std::pair<string, int> >::const_iterator pos = std::lower_bound (children.begin(), children.end(), 
+			std::make_pair (segment, length), SegmentLess());
+
+		if (pos != children.end() && pos->first.compare (0, string::npos, segment, length) == 0)
+			return pos->second;
+
+		return -1;
+	}
+
+	const DirectorySettings* DirectoryRouter::find (string_constref virtualPath) const
+	{
+		int nodeNdx = 0;
+		size_t segmentStart = 1, slashPos;
+		
+		// only segments ended with '/' are directories
+		while ((slashPos = virtualPath.find (strings::SlashCh, segmentStart)) != string::npos) 
+		{
+			const int childNdx = findChild (nodeNdx, virtualPath.c_str() + segmentStart, slashPos - segmentStart);
+			if (childNdx == -1 || NULL == _nodes[childNdx].settings)
+				break;
+
+			nodeNdx = childNdx;
+			segmentStart = slashPos + 1;
+		}
+
+		return _nodes[nodeNdx].settings;
+	}
+
+	const DirectorySettings* DirectoryRouter::findLinkedDirectory (string_constref virtualPath) const
+	{
+		int nodeNdx = 0;
+		size_t segmentStart = 1;
+		
+		while (segmentStart <= virtualPath.size()) 
+		{
+			size_t segmentEnd = virtualPath.find (strings::SlashCh, segmentStart);
+			if (segmentEnd == string::npos)
+				segmentEnd = virtualPath.size();
+
+			if (segmentEnd == segmentStart)
+				return NULL;
+
+			nodeNdx = findChild (nodeNdx, virtualPath.c_str() + segmentStart, segmentEnd - segmentStart);
+			if (nodeNdx == -1)
+				return NULL;
+
+			segmentStart = segmentEnd + 1;
+		}
+
+		const DirectorySettings* settings = _nodes[nodeNdx].settings;
+		return (nodeNdx != 0 && settings && settings->isLinkedDirectory) ? settings : NULL;
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		HttpServerSettings
+	//
+
 	HttpServerSettings::HttpServerSettings() :
 		InstanceId (1),
 		_port(-1), 
@@ -86,6 +483,7 @@ namespace ahttp
 		_keepAliveTimeout (defaults::KeepAliveTimeout),
 		_commandSocketTimeout (defaults::CommandSocketTimeout),
 		_responseBufferSize (defaults::ResponseBufferSize),
+		_responseMemoryLimit (defaults::ResponseMemoryLimit),
 		_maxChunkSize (defaults::MaxChunkSize),
 		_logger (NULL),
 		_serverVersion (defaults::ServerVersion),
@@ -93,7 +491,12 @@ namespace ahttp
 		_loaded (false),
 		_directoryConfigFile (defaults::DirectoryConfigFile),
 		_messagesFile (defaults::DirectoryConfigFile),
-		_uploadCreationTriesCount (defaults::UploadCreationTriesCount)
+		_uploadCreationTriesCount (defaults::UploadCreationTriesCount),
+		_fileCacheSize (defaults::FileCacheSize),
+		_fileCacheTtl (defaults::FileCacheTtl),
+		_targetCacheSize (defaults::TargetCacheSize),
+		_listingCacheSize (defaults::ListingCacheSize),
+		_rootDirectoryInfo (NULL)
 	{
 		_settings.socketReadTimeout = defaults::ServerSocketTimeout;
 		_settings.socketWriteTimeout = defaults::ServerSocketTimeout;
@@ -225,6 +628,10 @@ namespace ahttp
 			_directories [it->virtualPath] = *it;
 	
 			fillDirectoriesMap (directoriesList, it);
+			_router.build (_directories);
+
+			for (directories_map::iterator dirIter = _directories.begin(); dirIter != _directories.end(); ++dirIter)
+				dirIter->second.compileTemplates();
 			
 			fillModulesCallbackInfo();
 
@@ -380,46 +787,13 @@ namespace ahttp
 
 	}
 
-	void HttpServerSettings::addModuleCallbacksToMap (void** moduleCallbacks, int pluginIndex, callback_map& callbackMap )
-	{
-		for (int ndx=0; ndx<ModuleCallbackTypesCount; ++ndx)
-		{
-			if (moduleCallbacks[ndx])
-			{
-				callback_map::iterator it = callbackMap.find ((ModuleCallbackType) ndx);
-				if (it == callbackMap.end()) {
-					std::list< std::pair <void*, int> > lst;
-					lst.push_back ( std::make_pair (moduleCallbacks[ndx], pluginIndex));
-
-					callbackMap.insert ( std::make_pair ((ModuleCallbackType) ndx, lst)); 
-				
-				} else {
-					it->second.push_back ( std::make_pair (moduleCallbacks[ndx], pluginIndex) );
-				}
-			}
-		
-		}
-	}
-
-
 	void HttpServerSettings::fillModulesCallbackInfo ()
 	{
-		_modulesCallbacks.clear();
-	
-		directories_map::const_iterator dirIter = _directories.begin();
-	
-		for (; dirIter != _directories.end(); ++dirIter) 
-		{
-			callback_map dirCallbacks;
+		for (directories_map::iterator dirIter = _directories.begin(); dirIter != _directories.end(); ++dirIter) 
+			dirIter->second.moduleCallbacks.build (dirIter->second.modules);
 
-			directory_plugins_list::const_iterator it = dirIter->second.modules.begin();
-			for (; it != dirIter->second.modules.end(); ++it) 
-			{
-				addModuleCallbacksToMap ( (void**) it->moduleCallbacks, it->pluginIndex, dirCallbacks);
-			}
-			
-			_modulesCallbacks[dirIter->second.number] = dirCallbacks;
-		}
+		directories_map::const_iterator rootRecord = _directories.find (strings::Slash);
+		_rootDirectoryInfo = (rootRecord != _directories.end() ? &rootRecord->second : NULL);
 	}
 
 
@@ -565,8 +939,20 @@ namespace ahttp
 		// pooling - OPTIONAL
 		loadBoolAttribute (serverElem, SettingsTags::PoolingEnabledAttr, _settings.enablePooling);
 
+		// fixed workers pool with bounded pending queue - OPTIONAL
+		loadBoolAttribute (serverElem, SettingsTags::PreSpawnWorkersAttr, _settings.preSpawnWorkers);
+		loadIntAttribute (serverElem, SettingsTags::PendingQueueSizeAttr, _settings.pendingQueueSize);
+
 		// worker life time - OPTIONAL
 		loadIntAttribute (serverElem, SettingsTags::WorkerLifeTimeAttr, _settings.workerLifeTime);
+
+		// reactor mode - OPTIONAL
+		loadBoolAttribute (serverElem, SettingsTags::ReactorEnabledAttr, _settings.enableReactor);
+		loadIntAttribute (serverElem, SettingsTags::ReactorThreadsCountAttr, _settings.reactorThreadsCount);
+		loadIntAttribute (serverElem, SettingsTags::RequestHeaderTimeoutAttr, _settings.requestHeaderTimeout);
+
+		// listening sockets count (SO_REUSEPORT) - OPTIONAL
+		loadIntAttribute (serverElem, SettingsTags::ListenersCountAttr, _settings.listenersCount);
 		
 		// read timeouts
 		loadIntAttribute(serverElem, SettingsTags::ServerSocketTimeoutAttr, _settings.socketWriteTimeout);
@@ -590,6 +976,12 @@ namespace ahttp
 		loadStringAttribute (serverElem, SettingsTags::UploadsDirAttr, _globalUploadsDirectory, true);
 		loadIntAttribute (serverElem, SettingsTags::UploadCreationTriesCountAttr, _uploadCreationTriesCount);
 
+		// static files metadata cache - OPTIONAL
+		loadIntAttribute (serverElem, SettingsTags::FileCacheSizeAttr, _fileCacheSize);
+		loadIntAttribute (serverElem, SettingsTags::FileCacheTtlAttr, _fileCacheTtl);
+		loadIntAttribute (serverElem, SettingsTags::TargetCacheSizeAttr, _targetCacheSize);
+		loadIntAttribute (serverElem, SettingsTags::ListingCacheSizeAttr, _listingCacheSize);
+
 		// load locale an apply it,
 		// locale should be defined to perform correct MBSTR->WIDE conversion
 		
@@ -623,6 +1015,10 @@ namespace ahttp
 		if (!util::isNullOrEmpty(strValue))
 			_responseBufferSize = boost::lexical_cast<size_t> (strValue);
 
+		strValue = serverElem->Attribute (SettingsTags::ResponseMemoryLimitAttr);
+		if (!util::isNullOrEmpty(strValue))
+			_responseMemoryLimit = boost::lexical_cast<size_t> (strValue);
+
 		strValue = serverElem->Attribute (SettingsTags::MaxChunkSizeAttr);
 		if (!util::isNullOrEmpty(strValue))
 			_maxChunkSize = boost::lexical_cast<size_t> (strValue);
@@ -1268,7 +1664,7 @@ namespace ahttp
 					SettingsTags::UrlElement, dirInfo.name.c_str());
 
 
-			dirInfo.mappings.push_back( std::make_pair(boost::regex(re), url));
+			dirInfo.mappings.push_back( UrlMapping (re, url));
 
 			item = item->NextSiblingElement (SettingsTags::RegisterElement);
 		}
@@ -28,8 +28,10 @@ distribution.
 #define AHTTP_SERVER_SETTINGS_H
 #pragma once
 
+#include <ctime>
 #include <stdexcept>
 #include <boost/regex.hpp>
+#include <boost/cstdint.hpp>
 
 
 #include "aconnect/types.hpp"
@@ -43,6 +45,21 @@ namespace ahttp
 
 	#include "http_settings_tags.inl"
 
+	namespace SettingsTags
+	{
+		string_constant ReactorEnabledAttr = "reactor-enabled";
+		string_constant ReactorThreadsCountAttr = "reactor-threads-count";
+		string_constant RequestHeaderTimeoutAttr = "request-header-timeout";
+		string_constant ListenersCountAttr = "listeners-count";
+		string_constant PreSpawnWorkersAttr = "pre-spawn-workers";
+		string_constant PendingQueueSizeAttr = "pending-queue-size";
+		string_constant FileCacheSizeAttr = "file-cache-size";
+		string_constant FileCacheTtlAttr = "file-cache-ttl";
+		string_constant TargetCacheSizeAttr = "target-cache-size";
+		string_constant ResponseMemoryLimitAttr = "response-memory-limit";
+		string_constant ListingCacheSizeAttr = "listing-cache-size";
+	}
+
 	namespace Tristate
 	{
 		enum TristateEnum
@@ -150,15 +167,125 @@ namespace ahttp
 
 	typedef std::map <string, struct DirectorySettings> directories_map;
 	typedef std::vector<std::pair<bool, string> > default_documents_vector;
-	typedef std::map<ModuleCallbackType, std::list< std::pair <void*, int> > > callback_map;
-	typedef std::map<int, callback_map > directories_callback_map;
 	
 	typedef std::list <PluginRegistrationInfo> directory_plugins_list; 
 	
 	// key - registered plugin name, value - plugin registartion info
 	typedef std::map <string, struct PluginInfo> global_plugins_map;
 
-	typedef std::vector<std::pair<boost::regex, string> > mappings_vector;
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Flat directory modules callbacks table, built once at settings load:
+	//	callbacks of type T are stored in records [offsets[T], offsets[T + 1]).
+
+	struct ModuleCallbacksTable
+	{
+		struct Record
+		{
+			void*	callback;
+			int		pluginIndex;
+		};
+
+		ModuleCallbacksTable ()	{	clear();	}
+
+		void build (const directory_plugins_list& modules);
+		void clear ();
+
+		inline bool empty (ModuleCallbackType type) const {
+			return offsets[type] == offsets[type + 1];
+		}
+		
+		// valid only for not empty callbacks list
+		inline const Record* begin (ModuleCallbackType type) const	{	return &records[offsets[type]];			}
+		inline const Record* end (ModuleCallbackType type) const	{	return &records[0] + offsets[type + 1];	}
+
+		std::vector<Record>	records;
+		size_t				offsets[ModuleCallbackTypesCount + 1];
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		URL mapping, target template is parsed at load time to list of
+	//	literal and {N} substitution segments.
+
+	struct UrlMapping
+	{
+		struct Segment
+		{
+			int		group;		// regex group index, -1 - literal
+			string	text;		// literal text or source "{N}"
+		};
+
+		UrlMapping (string_constptr regexStr, string_constref targetTemplate);
+
+		// build target URL from matched groups
+		string rewrite (const boost::smatch &matches) const;
+
+		boost::regex			regex;
+		string					target;
+		std::vector<Segment>	segments;
+
+	protected:
+		void compile ();
+	};
+
+	typedef std::vector<UrlMapping> mappings_vector;
+
+	namespace ListingField
+	{
+		enum ListingFieldType
+		{
+			Literal = 0,
+			Name,
+			Url,
+			Size,
+			Time,
+			PageUrl,
+			ParentUrl,
+			FilesCount,
+			DirectoriesCount,
+			ErrorsCount
+		};
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Directory listing record template, parsed at load time to list of
+	//	literal and field ({name}, {url}, {size}...) substitution segments.
+
+	struct ListingTemplate
+	{
+		struct Segment
+		{
+			ListingField::ListingFieldType	field;
+			string							text;	// literal text or source mark
+		};
+
+		// substituted values, not set field is written as is
+		struct Values
+		{
+			Values () : name (NULL), url (NULL), size (-1), time (-1),
+				pageUrl (NULL), parentUrl (NULL), 
+				filesCount (-1), directoriesCount (-1), errorsCount (-1) { }
+
+			const string*		name;
+			const string*		url;
+			boost::uintmax_t	size;
+			std::time_t			time;
+			const string*		pageUrl;
+			const string*		parentUrl;
+			size_t				filesCount;
+			size_t				directoriesCount;
+			size_t				errorsCount;
+		};
+
+		void compile (string_constref source);
+		
+		// append rendered record to 'content'
+		void render (string& content, const Values& values) const;
+
+		std::vector<Segment>	segments;
+	};
 
 	namespace defaults
 	{
@@ -167,11 +294,18 @@ namespace ahttp
 		const int ServerSocketTimeout	= 900;	// sec
 		const int CommandSocketTimeout	= 30;	// sec
 		const size_t ResponseBufferSize	= 2 * 1024 * 1024;	// bytes
+		const size_t ResponseMemoryLimit	= 64 * 1024 * 1024;	// bytes, all response buffers
+		const size_t ReadBufferSize			= 64 * 1024;	// bytes, file and request body reading
 		const size_t MaxChunkSize				= 65535;	// bytes
 		const size_t MaxRequestSize				= 2097152;	// bytes (2 Mb)
 
 		const int UploadCreationTriesCount	= 10;
 
+		const int FileCacheSize			= 1024;	// cached files count
+		const int FileCacheTtl			= 2;	// sec
+		const int TargetCacheSize		= 4096;	// resolved targets count
+		const int ListingCacheSize		= 256;	// rendered directory listings count
+
 
 		string_constant ServerVersion = "ahttpserver";
 		string_constant DirectoryConfigFile = "directory.config";
@@ -218,6 +352,7 @@ namespace ahttp
 		
 		directory_plugins_list handlers;
 		directory_plugins_list modules;
+		ModuleCallbacksTable moduleCallbacks;	// filled from 'modules'
 
 		mappings_vector	mappings;
 		
@@ -228,6 +363,16 @@ namespace ahttp
 			fileTemplate,
 			footerTemplate;
 
+		// compiled templates, filled by compileTemplates()
+		ListingTemplate headerRecord,
+			directoryRecord,
+			parentDirectoryRecord,
+			virtualDirectoryRecord,
+			fileRecord,
+			footerRecord;
+
+		void compileTemplates ();
+
 		size_t maxRequestSize;
 		Tristate::TristateEnum enableParentPathAccess; 
 
@@ -235,6 +380,43 @@ namespace ahttp
 	};
 
 
+	//////////////////////////////////////////////////////////////////////////
+	//
+	//		Prefix tree of registered virtual directories (one node per path segment),
+	//	built at settings load: path is resolved in one pass without allocations.
+
+	class DirectoryRouter
+	{
+	public:
+		DirectoryRouter ()	{	clear();	}
+
+		void build (const directories_map& directories);
+		void clear ();
+
+		/**
+		* Find the deepest registered directory for virtual path,
+		* all parent directories must be registered too.
+		* @return	NULL when root directory is not registered
+		*/
+		const DirectorySettings* find (string_constref virtualPath) const;
+
+		// linked virtual directory with virtual path == 'virtualPath' + '/', or NULL
+		const DirectorySettings* findLinkedDirectory (string_constref virtualPath) const;
+
+	protected:
+		struct Node
+		{
+			const DirectorySettings*				settings;
+			std::vector<std::pair<string, int> >	children;	// segment -> node index, sorted
+		};
+
+		int findChild (int nodeNdx, string_constptr segment, size_t length) const;
+		int addChild (int nodeNdx, string_constref segment);
+
+		std::vector<Node> _nodes;	// _nodes[0] - root
+	};
+
+
 	class HttpServerSettings
 	{
 	public:
@@ -265,7 +447,7 @@ namespace ahttp
 		inline aconnect::Logger* logger()							{		return _logger;					}
 		inline void setLogger (aconnect::Logger* logger)			{		_logger = logger;				}
 
-		inline const string serverVersion() const		{		return _serverVersion;			}
+		inline string_constref serverVersion() const		{		return _serverVersion;			}
 		inline void setServerVersion (string version)	{		_serverVersion = version;		}
 
 		inline const aconnect::Log::LogLevel logLevel() const		{		return _logLevel;				}
@@ -277,11 +459,17 @@ namespace ahttp
 		inline const int keepAliveTimeout() const					{		return _keepAliveTimeout;		}
 		inline const int commandSocketTimeout() const				{		return _commandSocketTimeout;	}
 		inline const size_t responseBufferSize() const				{		return _responseBufferSize;		}
+		inline const size_t responseMemoryLimit() const				{		return _responseMemoryLimit;	}
 		inline const size_t maxChunkSize() const					{		return _maxChunkSize;			}
 		inline const directories_map& Directories() const			{		return _directories;			}
+		inline const DirectoryRouter& router() const				{		return _router;					}
 		inline const string& globalUploadsDirectory() const			{		return _globalUploadsDirectory;		}
 		inline const int uploadCreationTriesCount() const			{		return _uploadCreationTriesCount;	}
 		inline const bool isLoadedCorrectly() const					{		return _loaded;						}
+		inline const int fileCacheSize() const						{		return _fileCacheSize;				}
+		inline const int fileCacheTtl() const						{		return _fileCacheTtl;				}
+		inline const int targetCacheSize() const					{		return _targetCacheSize;			}
+		inline const int listingCacheSize() const					{		return _listingCacheSize;			}
 
 		
 		inline const DirectorySettings& getRootDirSettings() const	{		
@@ -292,9 +480,8 @@ namespace ahttp
 			return rootRecord->second;			
 		}
 
-		const directories_callback_map& modulesCallbacks () const {
-			return _modulesCallbacks;
-		}
+		// NULL until directories are loaded
+		inline const DirectorySettings* rootDirectoryInfo() const	{		return _rootDirectoryInfo;			}
 
 		const DirectorySettings* getDirSettingsByName(string_constref dirName) const;
 		
@@ -319,7 +506,6 @@ namespace ahttp
 
 		static std::set<string> parseExtensions(string_constref ext);
 
-		static void addModuleCallbacksToMap (void** moduleCallbacks, int pluginIndex, callback_map& callbackMap );
 
 
 		string_constref getMessage (string_constref key) const 
@@ -388,9 +574,11 @@ namespace ahttp
 
 		int _commandSocketTimeout;
 		size_t _responseBufferSize;
+		size_t _responseMemoryLimit;
 		size_t _maxChunkSize;
 
 		directories_map _directories;
+		DirectoryRouter _router;
 		aconnect::str2str_map _mimeTypes;
 		aconnect::str2str_map _messages;
 
@@ -407,9 +595,13 @@ namespace ahttp
 		string	_messagesFile;
 		string	_globalUploadsDirectory;
 		int	_uploadCreationTriesCount;
+		
+		int _fileCacheSize;
+		int _fileCacheTtl;
+		int _targetCacheSize;
+		int _listingCacheSize;
 
-		// key - directory::number, value - list of callbacks
-		directories_callback_map _modulesCallbacks;
+		const DirectorySettings* _rootDirectoryInfo;
 	};
 }
 #endif // AHTTP_SERVER_SETTINGS_H
@@ -33,9 +33,17 @@ distribution.
 
 #include <algorithm>
 #include <boost/filesystem.hpp>
+#include <boost/thread/mutex.hpp>
+
+#if defined (__GNUC__)
+#	include <sys/types.h>
+#	include <sys/stat.h>
+#	include <cerrno>
+#endif
 
 #include "aconnect/util.time.hpp"
 #include "aconnect/util.string.hpp"
+#include "aconnect/util.atomic.hpp"
 
 #include "ahttp/http_support.hpp"
 
@@ -43,25 +51,215 @@ namespace fs = boost::filesystem;
 
 namespace ahttp 
 { 
+	namespace
+	{
+		const int DateBufferSize = 32;
+
+		int formatDate (aconnect::char_type *buff, const tm& dateTime)
+		{
+			return snprintf (buff, DateBufferSize, "%s, %.2d %s %.4d %.2d:%.2d:%.2d GMT", 
+				strings::WeekDays_RFC1123[dateTime.tm_wday],
+				dateTime.tm_mday,
+				strings::Months_RFC1123[dateTime.tm_mon],
+
+				dateTime.tm_year + 1900,
+				dateTime.tm_hour,
+				dateTime.tm_min,
+				dateTime.tm_sec
+				);
+		}
+
+		// current date header line
+		struct DateHeaderLine
+		{
+			std::time_t		time;
+			size_t			size;
+			aconnect::char_type	value[DateBufferSize + 16];
+		};
+
+		// published through sequence counter: odd value - line is being updated,
+		// readers copy the line and retry when counter was changed meanwhile
+		DateHeaderLine dateHeaderLine = { 0, 0, {0} };
+		volatile aconnect::atomic_type dateHeaderSequence = 0;
+		boost::mutex dateHeaderMutex;
+
+		inline void readDateHeader (DateHeaderLine &line)
+		{
+			using namespace aconnect;
+			atomic_type sequence;
+
+			do {
+				sequence = util::atomicLoad (&dateHeaderSequence);
+				line = dateHeaderLine;
+				util::memoryBarrier ();
+			
+			} while ( (sequence & 1) || sequence != util::atomicLoad (&dateHeaderSequence) );
+		}
+
+		// names indexed by ServerVariable::ServerVariableType
+		string_constptr ServerVariableNames[ServerVariable::Count] = 
+		{
+			strings::ServerVariables::ALL_RAW,
+			strings::ServerVariables::APPL_MD_PATH,
+			strings::ServerVariables::APPL_PHYSICAL_PATH,
+			strings::ServerVariables::AUTH_PASSWORD,
+			strings::ServerVariables::AUTH_TYPE,
+			strings::ServerVariables::AUTH_USER,
+			strings::ServerVariables::CERT_COOKIE,
+			strings::ServerVariables::CERT_FLAGS,
+			strings::ServerVariables::CERT_ISSUER,
+			strings::ServerVariables::CERT_KEYSIZE,
+			strings::ServerVariables::CERT_SECRETKEYSIZE,
+			strings::ServerVariables::CERT_SERIALNUMBER,
+			strings::ServerVariables::CERT_SERVER_ISSUER,
+			strings::ServerVariables::CERT_SERVER_SUBJECT,
+			strings::ServerVariables::CERT_SUBJECT,
+			strings::ServerVariables::CONTENT_LENGTH,
+			strings::ServerVariables::CONTENT_TYPE,
+			strings::ServerVariables::GATEWAY_INTERFACE,
+			strings::ServerVariables::HTTPS,
+			strings::ServerVariables::HTTPS_KEYSIZE,
+			strings::ServerVariables::HTTPS_SECRETKEYSIZE,
+			strings::ServerVariables::HTTPS_SERVER_ISSUER,
+			strings::ServerVariables::HTTPS_SERVER_SUBJECT,
+			strings::ServerVariables::INSTANCE_ID,
+			strings::ServerVariables::INSTANCE_META_PATH,
+			strings::ServerVariables::LOCAL_ADDR,
+			strings::ServerVariables::LOGON_USER,
+			strings::ServerVariables::PATH_INFO,
+			strings::ServerVariables::PATH_INFO_RELATIVE,
+			strings::ServerVariables::PATH_TRANSLATED,
+			strings::ServerVariables::QUERY_STRING,
+			strings::ServerVariables::REMOTE_ADDR,
+			strings::ServerVariables::REMOTE_HOST,
+			strings::ServerVariables::REMOTE_USER,
+			strings::ServerVariables::REQUEST_METHOD,
+			strings::ServerVariables::SCRIPT_NAME,
+			strings::ServerVariables::SERVER_NAME,
+			strings::ServerVariables::SERVER_PORT,
+			strings::ServerVariables::SERVER_PORT_SECURE,
+			strings::ServerVariables::SERVER_PROTOCOL,
+			strings::ServerVariables::SERVER_SOFTWARE,
+			strings::ServerVariables::URL,
+			strings::ServerVariables::URL_ENCODED,
+			strings::ServerVariables::HTTP_ACCEPT,
+			strings::ServerVariables::HTTP_ACCEPT_LANGUAGE,
+			strings::ServerVariables::HTTP_COOKIE,
+			strings::ServerVariables::HTTP_CONNECTION,
+			strings::ServerVariables::HTTP_HOST,
+			strings::ServerVariables::HTTP_REFERER,
+			strings::ServerVariables::HTTP_USER_AGENT,
+			strings::ServerVariables::HTTP_ACCEPT_ENCODING,
+			strings::ServerVariables::HTTP_ACCEPT_CHARSET,
+			strings::ServerVariables::HTTP_KEEP_ALIVE,
+		};
+
+		//////////////////////////////////////////////////////////////////////////
+		//
+		//		Perfect hash of server variable names: seed is selected 
+		//	to map all names to different slots, name is verified by single compare.
+		
+		const unsigned long ServerVariableHashSeed = 130878UL;
+		const unsigned long ServerVariableHashMult = 31UL;
+		const size_t ServerVariableSlotsCount = 128;		// power of 2
+
+		inline size_t serverVariableHash (string_constptr name)
+		{
+			unsigned long hash = ServerVariableHashSeed;
+			for (; *name; ++name) {
+				unsigned long ch = (unsigned char) *name;
+				if (ch >= 'a' && ch <= 'z')
+					ch -= 'a' - 'A';
+				hash = ((hash ^ ch) * ServerVariableHashMult) & 0xFFFFFFFFUL;
+			}
+			
+			return (size_t) ((hash ^ (hash >> 16)) & (ServerVariableSlotsCount - 1));
+		}
+
+		struct ServerVariablesTable
+		{
+			unsigned char slots[ServerVariableSlotsCount];
+
+			ServerVariablesTable () 
+			{
+				std::fill (slots, slots + ServerVariableSlotsCount, (unsigned char) ServerVariable::Unknown);
+				
+				for (int ndx = 0; ndx < ServerVariable::Count; ++ndx) {
+					size_t slot = serverVariableHash (ServerVariableNames[ndx]);
+					assert (slots[slot] == ServerVariable::Unknown && "Server variables hash collision - select other seed");
+					slots[slot] = (unsigned char) ndx;
+				}
+			}
+		};
+
+		const ServerVariablesTable serverVariablesTable;
+	}
+
+	void appendDateHeader (string& target)
+	{
+		using namespace aconnect;
+
+		const std::time_t now = std::time (NULL);
+		
+		DateHeaderLine line;
+		readDateHeader (line);
+
+		if (line.time != now) 
+		{
+			// other thread is updating the date - previous value is used, if any
+			boost::mutex::scoped_try_lock lock (dateHeaderMutex);
+			if (!lock && 0 == line.time)
+				lock.lock ();
+
+			if (lock && dateHeaderLine.time == now)
+				line = dateHeaderLine;
+
+			else if (lock) 
+			{
+				aconnect::char_type date[DateBufferSize];
+				formatDate (date, util::getDateTimeUtc (now));
+
+				line.size = snprintf (line.value, sizeof (line.value), "%s%s%s%s", strings::HeaderDate, 
+					strings::HeaderValueDelimiter, date, strings::HeadersDelimiter);
+				line.time = now;
+
+				util::atomicAdd (&dateHeaderSequence, 1);
+				dateHeaderLine = line;
+				util::atomicAdd (&dateHeaderSequence, 1);
+			}
+		}
+
+		if (line.size > 0)
+			target.append (line.value, line.size);
+	}
+
 	// sample: Sun, 06 Nov 1994 08:49:37 GMT  ; RFC 822, updated by RFC 1123
 	string formatDate_RFC1123 (const tm& dateTime) 
 	{
-		aconnect::char_type buff[32] = {0};
-
-		int cnt = snprintf (buff, 32, "%s, %.2d %s %.4d %.2d:%.2d:%.2d GMT", 
-			strings::WeekDays_RFC1123[dateTime.tm_wday],
-			dateTime.tm_mday,
-			strings::Months_RFC1123[dateTime.tm_mon],
+		aconnect::char_type buff[DateBufferSize] = {0};
 
-			dateTime.tm_year + 1900,
-			dateTime.tm_hour,
-			dateTime.tm_min,
-			dateTime.tm_sec
-			);
+		int cnt = formatDate (buff, dateTime);
 
 		return string (buff, cnt);
 	}
 
+	ServerVariable::ServerVariableType getServerVariableType (string_constptr name)
+	{
+		using namespace aconnect;
+
+		const unsigned char type = serverVariablesTable.slots[serverVariableHash (name)];
+		if (type == ServerVariable::Unknown || !util::equals (name, ServerVariableNames[type]))
+			return ServerVariable::Unknown;
+
+		return (ServerVariable::ServerVariableType) type;
+	}
+
+	string_constptr getServerVariableName (ServerVariable::ServerVariableType type)
+	{
+		assert (type >= 0 && type < ServerVariable::Count);
+		return ServerVariableNames[type];
+	}
+
 	// sample: Sun, 06 Nov 1994 08:49:37 GMT  ; RFC 822, updated by RFC 1123
 	std::time_t getDateFrom_RFC1123 (string_constref dt)
 	{
@@ -126,16 +324,38 @@ namespace ahttp
 					return;
 				
 				item.name = dirIter->path().leaf();
+
+#if defined (__GNUC__)
+				// single stat call instead of several boost::filesystem requests
+				struct stat itemStat;
+				if (stat (dirIter->path().string().c_str(), &itemStat) != 0) {
+					logger.error ("Directory item loading failed, path: %s, system error code: %d", 
+						dirIter->path().string().c_str(), errno);
+					item.clear();
+					++errCount;
+					continue;
+				}
+
+				const bool isDirectory = S_ISDIR (itemStat.st_mode);
+				item.lastWriteTime = itemStat.st_mtime;
+				if (!isDirectory)
+					item.size = (boost::uintmax_t) itemStat.st_size;
+#else
+				const bool isDirectory = fs::is_directory( dirIter->status() );
 				item.lastWriteTime = fs::last_write_time (dirIter->path());
+				if (!isDirectory)
+					item.size = fs::file_size (dirIter->path());
+#endif
 
-				if ( fs::is_directory( dirIter->status() ) ) {
+				item.url = dirVirtPath;
+				aconnect::util::appendEncodedUrlPart (item.url, item.name.c_str(), item.name.size());
+
+				if ( isDirectory ) {
 					item.type = WdDirectory;
-					item.url = dirVirtPath + aconnect::util::encodeUrlPart (item.name) + strings::Slash;
+					item.url += strings::Slash;
 
 				} else  {
 					item.type = WdFile;
-					item.url = dirVirtPath + aconnect::util::encodeUrlPart (item.name);
-					item.size = fs::file_size (dirIter->path());
 				}
 
 				items.push_back (item);
@@ -162,11 +382,10 @@ namespace ahttp
 					typeid(ex).name(), ex.what());
 				++errCount;
 			}
-
-			if (sortType == WdSortByTypeAndName)
-				std::sort(items.begin(), items.end(), sortWdByTypeAndName);
 		}
 
+		if (sortType == WdSortByTypeAndName)
+			std::sort(items.begin(), items.end(), sortWdByTypeAndName);
 	}
 }
 
@@ -49,6 +49,70 @@ namespace ahttp
 		};
 	};
 
+	// server variables from strings::ServerVariables, same order
+	namespace ServerVariable
+	{
+		enum ServerVariableType
+		{
+			AllRaw = 0,
+			ApplMdPath,
+			ApplPhysicalPath,
+			AuthPassword,
+			AuthType,
+			AuthUser,
+			CertCookie,
+			CertFlags,
+			CertIssuer,
+			CertKeySize,
+			CertSecretKeySize,
+			CertSerialNumber,
+			CertServerIssuer,
+			CertServerSubject,
+			CertSubject,
+			ContentLength,
+			ContentType,
+			GatewayInterface,
+			Https,
+			HttpsKeySize,
+			HttpsSecretKeySize,
+			HttpsServerIssuer,
+			HttpsServerSubject,
+			InstanceId,
+			InstanceMetaPath,
+			LocalAddr,
+			LogonUser,
+			PathInfo,
+			PathInfoRelative,
+			PathTranslated,
+			QueryString,
+			RemoteAddr,
+			RemoteHost,
+			RemoteUser,
+			RequestMethod,
+			ScriptName,
+			ServerName,
+			ServerPort,
+			ServerPortSecure,
+			ServerProtocol,
+			ServerSoftware,
+			Url,
+			UrlEncoded,
+			HttpAccept,
+			HttpAcceptLanguage,
+			HttpCookie,
+			HttpConnection,
+			HttpHost,
+			HttpReferer,
+			HttpUserAgent,
+			HttpAcceptEncoding,
+			HttpAcceptCharset,
+			HttpKeepAlive,
+
+			Count,
+			Unknown = Count
+		};
+	};
+
 	enum WebDirectoryItemType // defines sorting order
 	{
 		WdUnknown,
@@ -298,7 +362,7 @@ namespace ahttp
 		string_constant WindowsSlash = "\\";
 		const char_type SlashCh = '/';
 
-		string_constant ChunkHeaderFormat = "%x\r\n";
+		string_constant ChunkHeaderFormat = "%lx\r\n";
 		string_constant ChunkEndMark = "\r\n";
 		string_constant LastChunkFormat = "0\r\n\r\n";
 			
@@ -387,6 +451,62 @@ namespace ahttp
 			}
 			return desc;
 		};
+
+		// precomputed status lines, NULL for unknown status
+		inline string_constptr httpStatusLine (int status) 
+		{
+			switch(status) 
+			{
+			case 100 : return "HTTP/1.1 100 Continue\r\n";
+			case 101 : return "HTTP/1.1 101 Switching Protocols\r\n";
+
+			case 200 : return "HTTP/1.1 200 OK\r\n";
+			case 201 : return "HTTP/1.1 201 Created\r\n";
+			case 202 : return "HTTP/1.1 202 Accepted\r\n";
+			case 203 : return "HTTP/1.1 203 Non-Authoritative Information\r\n";
+			case 204 : return "HTTP/1.1 204 No Content\r\n";
+			case 205 : return "HTTP/1.1 205 Reset Content\r\n";
+			case 206 : return "HTTP/1.1 206 Partial Content\r\n";
+
+			case 300 : return "HTTP/1.1 300 Multiple Choices\r\n";
+			case 301 : return "HTTP/1.1 301 Moved Permanently\r\n";
+			case 302 : return "HTTP/1.1 302 Found\r\n";
+			case 303 : return "HTTP/1.1 303 See Other\r\n";
+			case 304 : return "HTTP/1.1 304 Not Modified\r\n";
+			case 305 : return "HTTP/1.1 305 Use Proxy\r\n";
+			case 306 : return "HTTP/1.1 306 (Unused)\r\n";
+			case 307 : return "HTTP/1.1 307 Temporary Redirect\r\n";
+
+			case 400 : return "HTTP/1.1 400 Bad Request\r\n";
+			case 401 : return "HTTP/1.1 401 Unauthorized\r\n";
+			case 402 : return "HTTP/1.1 402 Payment Required\r\n";
+			case 403 : return "HTTP/1.1 403 Forbidden\r\n";
+			case 404 : return "HTTP/1.1 404 Not Found\r\n";
+			case 405 : return "HTTP/1.1 405 Method Not Allowed\r\n";
+			case 406 : return "HTTP/1.1 406 Not Acceptable\r\n";
+			case 407 : return "HTTP/1.1 407 Proxy Authentication Required\r\n";
+			case 408 : return "HTTP/1.1 408 Request Timeout\r\n";
+			case 409 : return "HTTP/1.1 409 Conflict\r\n";
+			case 410 : return "HTTP/1.1 410 Gone\r\n";
+			case 411 : return "HTTP/1.1 411 Length Required\r\n";
+			case 412 : return "HTTP/1.1 412 Precondition Failed\r\n";
+			case 413 : return "HTTP/1.1 413 Request Entity Too Large\r\n";
+			case 414 : return "HTTP/1.1 414 Request-URI Too Long\r\n";
+			case 415 : return "HTTP/1.1 415 Unsupported Media Type\r\n";
+			case 416 : return "HTTP/1.1 416 Requested Range Not Satisfiable\r\n";
+			case 417 : return "HTTP/1.1 417 Expectation Failed\r\n";
+
+			case 500 : return "HTTP/1.1 500 Internal Server Error\r\n";
+			case 501 : return "HTTP/1.1 501 Not Implemented\r\n";
+			case 502 : return "HTTP/1.1 502 Bad Gateway\r\n";
+			case 503 : return "HTTP/1.1 503 Service Unavailable\r\n";
+			case 504 : return "HTTP/1.1 504 Gateway Timeout\r\n";
+			case 505 : return "HTTP/1.1 505 HTTP Version Not Supported\r\n";
+
+			default:
+				return NULL;
+			}
+		};
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -404,8 +524,15 @@ namespace ahttp
 	// sample: Sun, 06 Nov 1994 08:49:37 GMT  ; RFC 822, updated by RFC 1123
 	string formatDate_RFC1123 (const struct tm& dateTime);
 
+	// append "Date: <current date>\r\n" header line, date string is formatted once per second
+	void appendDateHeader (string& target);
+
 	// sample: Sun, 06 Nov 1994 08:49:37 GMT  ; RFC 822, updated by RFC 1123
 	std::time_t getDateFrom_RFC1123 (string_constref date);
+
+	// case-insensitive lookup by perfect hash, ServerVariable::Unknown for unknown names
+	ServerVariable::ServerVariableType getServerVariableType (string_constptr name);
+	string_constptr getServerVariableName (ServerVariable::ServerVariableType type);
 } 
 
 #endif // AHTTP_HTTP_SUPPORT_H
@@ -272,7 +272,17 @@ void processCommand (const aconnect::ClientInfo& client)
 				Settings::StatisticsFormat,
 				(long) ahttp::HttpServer::RequestsCount,
 				(long) Global::httpServer.currentWorkersCount(),
-				(long) Global::httpServer.currentPendingWorkersCount());
+				(long) Global::httpServer.currentPendingWorkersCount(),
+				Global::httpServer.pendingQueueDepth(),
+				Global::httpServer.shedConnectionsCount(),
+				Global::httpServer.queuedConnectionsCount() > 0 ? 
+					Global::httpServer.queueWaitTime() / Global::httpServer.queuedConnectionsCount() : 0,
+				ahttp::HttpServer::TargetCache.hitsCount(),
+				ahttp::HttpServer::TargetCache.missesCount(),
+				ahttp::HttpResponseStream::MemoryBudget.usedSize(),
+				ahttp::HttpResponseStream::MemoryBudget.highWaterMark(),
+				ahttp::HttpResponseStream::MemoryBudget.maxBufferSize(),
+				ahttp::HttpResponseStream::MemoryBudget.earlyFlushesCount());
 			
 			response.append (buff, util::min2(formattedCount, buffSize));
 		
@@ -286,10 +296,13 @@ void processCommand (const aconnect::ClientInfo& client)
 				Global::httpServer.stop (true);
 				Global::globalSettings.destroyPlugins (ahttp::PluginHandler, false);
 				Global::globalSettings.destroyPlugins (ahttp::PluginModule, false);
+				// cached targets refer to directories settings
+				ahttp::HttpServer::TargetCache.clear();
 				
 				Global::Stopped = false;
 
 				Global::globalSettings.load ( Global::settingsFilePath.c_str() );
+				ahttp::HttpServer::init ( &Global::globalSettings);
 				Global::globalSettings.initPlugins(ahttp::PluginModule);
 				Global::globalSettings.initPlugins(ahttp::PluginHandler);
 				
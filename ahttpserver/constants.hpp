@@ -23,9 +23,14 @@ namespace Settings
 		"- to stop server run \"ahttpserver stop\"\r\n"
 		"- to get statistics run \"ahttpserver stat\"\r\n";
 	const aconnect::string_constant StatisticsFormat = 
-		"ahttpserver statistics\r\nprocessed requests count: %d\r\n"
-		"worker threads count: %d\r\n"
-		"pending threads count: %d\r\n";
+		"ahttpserver statistics\r\nprocessed requests count: %ld\r\n"
+		"worker threads count: %ld\r\n"
+		"pending threads count: %ld\r\n"
+		"pending queue depth: %ld\r\n"
+		"rejected connections count: %ld\r\n"
+		"average queue wait time: %ld msec\r\n"
+		"resolved targets cache hits: %ld, misses: %ld\r\n"
+		"response buffers memory: %ld bytes, high-water mark: %ld bytes, max buffer: %ld bytes, early flushes: %ld\r\n";
 
 	const aconnect::string_constant CommandStat = "stat";
 	const aconnect::string_constant CommandStart = "start";
@@ -37,26 +37,30 @@ distribution.
 //	
 aconnect::string_constptr RequestWrapper::param (aconnect::string_constptr key)  
 {
-	processRequest();
+	if (requestReadInRawForm_)
+		throwRequestReadRawError ();
 
+	const aconnect::string name (key);
+	
 	PyThreadStateGuard guard;
 
-	aconnect::str2str_map::const_iterator iter;
-	if ((iter = _context->GetParameters.find(key)) != _context->GetParameters.end())
-		return iter->second.c_str();
+	// collections are not filled - only requested value is decoded
+	if (_context->findQueryParameter (name, _paramValue))
+		return _paramValue.c_str();
 
-	if ((iter = _context->PostParameters.find(key)) != _context->PostParameters.end())
-		return iter->second.c_str();
+	_requestBodyLoaded = true;
+	if (_context->findPostParameter (name, _paramValue))
+		return _paramValue.c_str();
 
-	if ((iter = _context->Cookies.find(key)) != _context->Cookies.end())
-		return iter->second.c_str();
+	if (_context->findCookie (name, _paramValue))
+		return _paramValue.c_str();
 
 	return NULL;
 }
 
 std::string RequestWrapper::rawRead (int buffSize)	{ 
 
-	if (_requestLoaded) 
+	if (_requestLoaded || _requestBodyLoaded) 
 		throwRequestProcessedError ();
 
 	requestReadInRawForm_ = true;
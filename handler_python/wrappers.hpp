@@ -70,7 +70,7 @@ public:
 	}
 
 	inline size_t getLength() {
-		return _header->Headers.size(); 
+		return _header->headersCount(); 
 	}
 	inline std::string getHeader (aconnect::string_constptr key) const {
 		PyThreadStateGuard guard;
@@ -83,10 +83,10 @@ public:
 	inline const aconnect::str2str_map& items () {
 		PyThreadStateGuard guard;
 
-		if (_items.size() != _header->Headers.size()) {
-			_items.clear();
-			std::copy (_header->Headers.begin(), 
-				_header->Headers.end(),
+		if (_items.empty() && _header->headersCount() > 0) {
+			aconnect::str2str_map_ci headers = _header->getHeaders();
+			std::copy (headers.begin(), 
+				headers.end(),
 				std::inserter(_items, _items.begin()));
 		}
 
@@ -95,7 +95,7 @@ public:
 	inline std::string requestMethod() const	{ return _header->Method;		}
 	inline int requestHttpVerHigh()	const 		{ return _header->VersionHigh;	}
 	inline int requestHttpVerLow() const		{ return _header->VersionLow;	}
-	inline std::string userAgent() const 		{ PyThreadStateGuard guard;	return _header->getHeader ( ahttp::strings::HeaderUserAgent);	}
+	inline std::string userAgent() const 		{ PyThreadStateGuard guard;	return _header->getHeader ( ahttp::RequestHeaderUserAgent);	}
 
 protected:
 	ahttp::HttpRequestHeader *_header;
@@ -114,6 +114,7 @@ public:
 	RequestWrapper (ahttp::HttpContext *context) : 
 		  _context(context), 
 		  _requestLoaded (false), 
+		  _requestBodyLoaded (false), 
 		  requestReadInRawForm_(false)
 	{
 	  assert (context);
@@ -158,7 +159,9 @@ protected:
 
 	ahttp::HttpContext *_context;
 	bool _requestLoaded;
+	bool _requestBodyLoaded;		// POST data is read by 'param' call
 	bool requestReadInRawForm_;
+	std::string _paramValue;		// last value returned by 'param'
 
 };
 
@@ -219,12 +219,12 @@ HANDLER_EXPORT bool onRequestResolve (ahttp::HttpContext& context, int moduleInd
 
 	const ModuleConfig& config = cgfIter->second;
 
-	if (!context.RequestHeader.hasHeader (strings::HeaderAuthorization)) {
+	if (!context.RequestHeader.hasHeader (ahttp::RequestHeaderAuthorization)) {
 		writeAccessDenied (context, config);
 		return true;
 	}
 
-	aconnect::string auth = context.RequestHeader.getHeader (strings::HeaderAuthorization);
+	aconnect::string auth = context.RequestHeader.getHeader (ahttp::RequestHeaderAuthorization);
 	if (auth.find(Globals::BasicAutenticationKey) != 0) {
 		writeAccessDenied (context, config);
 		return true;
@@ -0,0 +1,662 @@
+/*
+This file is part of [ahttp] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "aconnect/lib_file_begin.inl"
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <boost/timer.hpp>
+#include <boost/lexical_cast.hpp>
+#include <boost/algorithm/string.hpp>
+#include <boost/regex.hpp>
+
+#include "aconnect/types.hpp"
+#include "aconnect/error.hpp"
+#include "aconnect/util.string.hpp"
+#include "aconnect/util.scan.hpp"
+
+#include "ahttp/aconnect_types.hpp"
+
+#include "ahttp/http_request.hpp"
+#include "ahttp/http_multipart.hpp"
+#include "ahttp/http_server_settings.hpp"
+
+#include "tinyxml/tinyxml.h"
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Throughput of parsing and encoding routines, implementations
+//	replaced by them are measured on the same data for comparison.
+
+using aconnect::string;
+using aconnect::string_constref;
+using aconnect::string_constptr;
+namespace util = aconnect::util;
+
+namespace
+{
+	const double MinMeasureTime = 0.5;	// sec
+	const size_t DataSize = 1024 * 1024;
+	const size_t ReadSize = 16 * 1024;	// simulated socket read size
+	const size_t ParserBufferSize = 64 * 1024;	// as used by HttpContext
+
+	string_constptr UploadFileName = "ahttp_bench.upload";
+
+	// inputs
+	string binaryData;
+	string multipartMessage;
+	string multipartBoundary;
+	string plainText;		// no special symbols
+	string escapedText;		// "%41" sequence
+	string markupText;		// '<' every 4th symbol
+	string requestHeader;
+	std::vector<string> mappedPaths;
+
+	// results are accumulated to keep calls from being optimized out
+	size_t resultsSink = 0;
+
+	// "name" parameter of part header
+	string partFieldName (string_constref header)
+	{
+		const string mark = "name=\"";
+		string::size_type pos = header.find (mark);
+		if (pos == string::npos)
+			return string();
+
+		pos += mark.size();
+		return header.substr (pos, header.find ('"', pos) - pos);
+	}
+
+	inline bool isFilePart (string_constref header) {
+		return header.find ("filename=\"") != string::npos;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Replaced implementations
+
+namespace baseline
+{
+	// HttpContext::loadMultipartFormData before MultipartParser: data is collected
+	// in string and searched by string::find, upload is written by std::ofstream
+	void loadMultipartFormData (string_constref message, string_constref boundary,
+		aconnect::str2str_map &fields)
+	{
+		size_t readBytes = 0,
+			messagePos = 0;
+		string record, fieldName;
+		size_t boundaryPos = 0,
+			endPos = 0;
+		bool isFileData = false;
+
+		const string boundaryBegin = "--" + boundary;
+		const string boundaryBeginWithEndMark = "\r\n--" + boundary;
+		const string boundaryEnd = "--" + boundary + "--";
+
+		const size_t boundOffset = boundaryBegin.size() + 2;
+		const size_t endMarkLen = 4;
+		const size_t headerEndMarkLen = 2;
+
+		std::ofstream currentFile;
+
+		do
+		{
+			readBytes = std::min (ReadSize, message.size() - messagePos);
+			record.append (message, messagePos, readBytes);
+			messagePos += readBytes;
+
+			boundaryPos = record.find (boundaryBegin);
+
+			while (record.length())
+			{
+				if (boundaryPos == 0
+					&& (endPos = record.find ("\r\n\r\n", 0)) != string::npos)
+				{
+					if (currentFile.is_open()) {
+						currentFile.flush();
+						currentFile.rdbuf()->close();
+					}
+
+					const string header = record.substr (boundOffset, endPos - boundOffset);
+					fieldName = partFieldName (header);
+					isFileData = isFilePart (header);
+
+					record.erase (0, endPos + endMarkLen);
+					boundaryPos = util::findSequence (record, boundaryBeginWithEndMark);
+
+					if (!isFileData) {
+						fields [fieldName] += record.substr (0, boundaryPos);
+					} else {
+						currentFile.open (UploadFileName, std::ios::out | std::ios::binary);
+						if (currentFile.good() && record.size())
+							currentFile << record.substr (0, boundaryPos);
+					}
+
+					record.erase (0, boundaryPos);
+					boundaryPos = 0;
+
+				} else if (!fieldName.empty() && boundaryPos != 0 && boundaryPos != string::npos) {
+
+					if (!isFileData)
+						fields [fieldName] += record.substr (0, boundaryPos - headerEndMarkLen);
+					else if (currentFile.good())
+						currentFile << record.substr (0, boundaryPos - headerEndMarkLen);
+
+					record.erase (0, boundaryPos);
+					boundaryPos = 0;
+
+				} else {
+					if (isFileData
+						&& currentFile.good()
+						&& currentFile.is_open()
+						&& util::findSequence (record, boundaryBeginWithEndMark) == string::npos
+						&& util::findSequence (record, boundaryBegin) == string::npos)
+					{
+						currentFile << record;
+						record.clear();
+					} else {
+						break;
+					}
+				}
+
+				if (record.find (boundaryEnd) == 0) {
+					readBytes = 0;
+					break;
+				}
+			}
+
+		} while (readBytes > 0);
+
+		if (currentFile.is_open()) {
+			currentFile.flush();
+			currentFile.rdbuf()->close();
+		}
+	}
+
+	string decodeUrl (string_constref url)
+	{
+		string res;
+		for (size_t ndx = 0; ndx < url.size(); ++ndx) {
+			if (url[ndx] == '%' && ndx + 2 < url.size()) {
+				res += (char) ((util::parseHexSymbol (url[ndx + 1]) << 4) + util::parseHexSymbol (url[ndx + 2]));
+				ndx += 2;
+			} else {
+				res += (url[ndx] == '+' ? ' ' : url[ndx]);
+			}
+		}
+		return res;
+	}
+
+	// HttpRequestHeader before in place parsing: tokenized lines, map of header copies
+	class HttpRequestHeader
+	{
+	public:
+		aconnect::str2str_map_ci Headers;
+
+		int VersionHigh, VersionLow;
+		size_t ContentLength;
+
+		string Method;
+		string Path;
+
+		HttpRequestHeader () : VersionHigh (0), VersionLow (0), ContentLength (0), _contentLengthLoaded (false) { }
+
+		void load (string_constref headerBody)
+		{
+			aconnect::SimpleTokenizer tokens (headerBody, "\r\n");
+
+			int lineNdx = 0;
+			string::size_type pos = string::npos,
+				prevPos = string::npos;
+
+			for (aconnect::SimpleTokenizer::iterator tok_iter = tokens.begin();
+					tok_iter != tokens.end();
+					++tok_iter)
+			{
+				string_constref line = tok_iter.current_token();
+				if (line.empty())
+					continue;
+
+				if (0 == lineNdx) {
+					pos = line.find (' ');
+					if (pos == string::npos)
+						throw aconnect::request_processing_error ("Incorrect request string: %s", line.c_str());
+
+					Method = line.substr (0, pos);
+					prevPos = pos + 1;
+
+					pos = line.find (' ', pos + 1);
+
+					if (pos != string::npos) {
+						Path = line.substr (prevPos, pos - prevPos);
+						prevPos = pos + 1;
+
+						const size_t offset = strlen ("HTTP/");
+
+						if ((pos = line.find ('.', prevPos + offset)) != string::npos) {
+							VersionHigh = boost::lexical_cast<int> (line.substr (prevPos + offset, pos - offset - prevPos));
+							VersionLow = boost::lexical_cast<int> (line.substr (pos + 1));
+						} else {
+							VersionHigh = boost::lexical_cast<int> (line.substr (prevPos + offset));
+							VersionLow = 0;
+						}
+
+					} else {
+						Path = line.substr (prevPos);
+					}
+
+				} else {
+					pos = line.find (':');
+					if (pos == string::npos)
+						throw aconnect::request_processing_error ("Incorrect request header: %s", line.c_str());
+
+					loadHeader (line.substr (0, pos), boost::algorithm::trim_copy (line.substr (pos + 1)));
+				}
+
+				++lineNdx;
+			}
+
+			if (util::equals (Method, "GET"))
+				_contentLengthLoaded = true;
+		}
+
+	protected:
+		void loadHeader (string_constref name, string_constref value)
+		{
+			if (util::equals (name, "Content-Length")) {
+				ContentLength = boost::lexical_cast<size_t> (value);
+				_contentLengthLoaded = true;
+			}
+
+			Headers.insert (std::make_pair (name, value));
+		}
+
+		bool _contentLengthLoaded;
+	};
+
+	// mappings before target templates precompiling: regex is copied on each request,
+	// each group is substituted by regex_replace with format string built from matched text
+	typedef std::vector<std::pair<boost::regex, string> > mappings_vector;
+
+	string applyMappings (const mappings_vector &mappings, string_constref virtualPath)
+	{
+		boost::smatch matches;
+		string res;
+
+		for (mappings_vector::const_iterator iter = mappings.begin(); iter != mappings.end(); ++iter)
+		{
+			if (boost::regex_match (virtualPath, matches, boost::regex (iter->first))) {
+				string target = iter->second;
+
+				for (int ndx = 1; ndx < (int) matches.size(); ++ndx)
+				{
+					boost::regex re ("(^|[^\\{])\\{" + boost::lexical_cast<string> (ndx - 1) + "\\}([^\\}]|$)");
+					target = boost::regex_replace (target, re, "($1)" + matches.str(ndx) + "($2)",
+						boost::match_default | boost::format_all);
+				}
+				res = target;
+			}
+		}
+
+		return res;
+	}
+
+	mappings_vector Mappings;
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Measured operations
+
+namespace
+{
+	class UploadHandler : public ahttp::MultipartHandler
+	{
+	public:
+		UploadHandler (aconnect::str2str_map &fields) : _fields (fields), _file (NULL) { }
+		~UploadHandler () {
+			if (_file)
+				fclose (_file);
+		}
+
+		virtual void onPartBegin (string_constref header)
+		{
+			_fieldName = partFieldName (header);
+			if (isFilePart (header)) {
+				// uploads are written without buffering, as by HttpContext
+				_file = fopen (UploadFileName, "wb");
+				if (_file)
+					setvbuf (_file, NULL, _IONBF, 0);
+			}
+		}
+		virtual void onPartData (string_constptr data, size_t size)
+		{
+			if (_file)
+				fwrite (data, 1, size, _file);
+			else
+				_fields[_fieldName].append (data, size);
+		}
+		virtual void onPartEnd ()
+		{
+			if (_file)
+				fclose (_file);
+			_file = NULL;
+		}
+
+	protected:
+		aconnect::str2str_map &_fields;
+		string _fieldName;
+		FILE *_file;
+	};
+
+	void loadMultipart (aconnect::str2str_map &fields)
+	{
+		ahttp::MultipartParser parser (multipartBoundary, ParserBufferSize);
+		UploadHandler handler (fields);
+
+		size_t pos = 0;
+		while (pos < multipartMessage.size() && !parser.isFinished())
+		{
+			size_t freeSize;
+			aconnect::char_type *buff = parser.buffer (freeSize);
+			const size_t readSize = std::min (std::min (freeSize, ReadSize), multipartMessage.size() - pos);
+
+			memcpy (buff, multipartMessage.c_str() + pos, readSize);
+			pos += readSize;
+			parser.consume (readSize, handler);
+		}
+	}
+
+	void parseMultipart ()
+	{
+		aconnect::str2str_map fields;
+		loadMultipart (fields);
+		resultsSink += fields.size();
+	}
+	void parseMultipartBaseline ()
+	{
+		aconnect::str2str_map fields;
+		baseline::loadMultipartFormData (multipartMessage, multipartBoundary, fields);
+		resultsSink += fields.size();
+	}
+
+	void decodePlain ()				{	resultsSink += util::decodeUrl (plainText).size();			}
+	void decodeEscaped ()			{	resultsSink += util::decodeUrl (escapedText).size();		}
+	void decodeEscapedBaseline ()	{	resultsSink += baseline::decodeUrl (escapedText).size();	}
+	void decodeEscapedInPlace ()	{
+		string buffer = escapedText;
+		resultsSink += util::decodeUrlInPlace (&buffer[0], buffer.size());
+	}
+	void encodePlain ()				{	resultsSink += util::encodeUrlPart (plainText).size();		}
+	void encodeBinary ()			{	resultsSink += util::encodeUrlPart (binaryData).size();		}
+	void escapePlain ()				{	resultsSink += util::escapeHtml (plainText).size();			}
+	void escapeMarkup ()			{	resultsSink += util::escapeHtml (markupText).size();		}
+
+	void parseHeader ()	{
+		ahttp::HttpRequestHeader header;
+		header.load (requestHeader);
+		resultsSink += header.headersCount();
+	}
+	void parseHeaderBaseline ()	{
+		baseline::HttpRequestHeader header;
+		header.load (requestHeader);
+		resultsSink += header.Headers.size();
+	}
+
+	bool isLineEnd (char ch)	{	return ch == '\r' || ch == '\n';	}
+
+	void findLineEndScan ()	{
+		resultsSink += util::findLineEnd (plainText.c_str(), plainText.c_str() + plainText.size()) - plainText.c_str();
+	}
+	void findLineEndBaseline ()	{
+		resultsSink += std::find_if (plainText.c_str(), plainText.c_str() + plainText.size(), isLineEnd) - plainText.c_str();
+	}
+	void findSequenceScan ()	{
+		resultsSink += util::findString (plainText, "\r\n\r\n");
+	}
+	void findSequenceBaseline ()	{
+		string_constptr seq = "\r\n\r\n";
+		resultsSink += std::search (plainText.c_str(), plainText.c_str() + plainText.size(), seq, seq + 4) - plainText.c_str();
+	}
+	void findAnyOfScan ()	{
+		resultsSink += util::findAnyOf (plainText.c_str(), plainText.c_str() + plainText.size(), "&<>", 3) - plainText.c_str();
+	}
+	void findUrlUnsafeScan ()	{
+		resultsSink += util::findUrlUnsafe (plainText.c_str(), plainText.c_str() + plainText.size()) - plainText.c_str();
+	}
+
+	std::vector<ahttp::UrlMapping> Mappings;
+
+	void rewriteUrls ()
+	{
+		boost::smatch matches;
+		for (size_t ndx = 0; ndx < mappedPaths.size(); ++ndx)
+		{
+			string target;
+			for (size_t mappingNdx = 0; mappingNdx < Mappings.size(); ++mappingNdx) {
+				if (boost::regex_match (mappedPaths[ndx], matches, Mappings[mappingNdx].regex))
+					target = Mappings[mappingNdx].rewrite (matches);
+			}
+			resultsSink += target.size();
+		}
+	}
+	void rewriteUrlsBaseline ()
+	{
+		for (size_t ndx = 0; ndx < mappedPaths.size(); ++ndx)
+			resultsSink += baseline::applyMappings (baseline::Mappings, mappedPaths[ndx]).size();
+	}
+
+	// <mappings> of directory.config
+	bool loadMappings (string_constptr configPath)
+	{
+		TiXmlDocument doc (configPath);
+		if (!doc.LoadFile() || !doc.RootElement())
+			return false;
+
+		TiXmlElement *mappingsElement = doc.RootElement()->FirstChildElement ("mappings");
+		if (!mappingsElement)
+			return false;
+
+		for (TiXmlElement *item = mappingsElement->FirstChildElement ("register");
+			item;
+			item = item->NextSiblingElement ("register"))
+		{
+			TiXmlElement *regexElement = item->FirstChildElement ("regex"),
+				*urlElement = item->FirstChildElement ("url");
+			if (!regexElement || !urlElement || !regexElement->GetText() || !urlElement->GetText())
+				continue;
+
+			Mappings.push_back (ahttp::UrlMapping (regexElement->GetText(), urlElement->GetText()));
+			baseline::Mappings.push_back (std::make_pair (boost::regex (regexElement->GetText()),
+				string (urlElement->GetText())));
+		}
+
+		return !Mappings.empty();
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+
+	void measure (string_constref name, size_t bytesPerRun, void (*operation)())
+	{
+		boost::timer timer;
+		size_t runs = 0;
+
+		do {
+			operation ();
+			++runs;
+		} while (timer.elapsed() < MinMeasureTime);
+
+		const double elapsed = timer.elapsed();
+
+		std::cout << std::setw (36) << std::left << name
+			<< std::setw (12) << std::right << std::fixed << std::setprecision (0) << runs / elapsed << " runs/sec";
+		if (bytesPerRun)
+			std::cout << std::setw (10) << std::setprecision (1) << runs * bytesPerRun / elapsed / (1024 * 1024) << " MB/sec";
+		std::cout << std::endl;
+	}
+
+	void prepareData ()
+	{
+		const char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+
+		srand (7);
+		for (size_t ndx = 0; ndx < DataSize; ++ndx) {
+			binaryData += (char) (rand() % 256);
+			plainText += alphabet[rand() % (sizeof(alphabet) - 1)];
+			markupText += (ndx % 4 == 0) ? '<' : alphabet[rand() % (sizeof(alphabet) - 1)];
+		}
+
+		for (size_t ndx = 0; ndx < DataSize / 3; ++ndx)
+			escapedText += "%41";
+
+		multipartBoundary = "---------------------------41184676334";
+		multipartMessage = "--" + multipartBoundary + "\r\n"
+			"Content-Disposition: form-data; name=\"title\"\r\n\r\n"
+			"Upload test\r\n"
+			"--" + multipartBoundary + "\r\n"
+			"Content-Disposition: form-data; name=\"file\"; filename=\"data.bin\"\r\n"
+			"Content-Type: application/octet-stream\r\n\r\n"
+			+ binaryData + binaryData + binaryData + binaryData + "\r\n"
+			"--" + multipartBoundary + "--\r\n";
+
+		requestHeader = "GET /python/index.py?id=12&page=3 HTTP/1.1\r\n"
+			"Host: localhost:5555\r\n"
+			"User-Agent: Mozilla/5.0 (Windows; U; Windows NT 5.1; en-US; rv:1.9.0.1) Gecko/2008070208 Firefox/3.0.1\r\n"
+			"Accept: text/html,application/xhtml+xml,application/xml;q=0.9,*/*;q=0.8\r\n"
+			"Accept-Language: en-us,en;q=0.5\r\n"
+			"Accept-Encoding: gzip,deflate\r\n"
+			"Accept-Charset: ISO-8859-1,utf-8;q=0.7,*;q=0.7\r\n"
+			"Keep-Alive: 300\r\n"
+			"Connection: keep-alive\r\n"
+			"Referer: http://localhost:5555/python/\r\n"
+			"Cookie: session=4f2a9c01; theme=default\r\n\r\n";
+
+		// paths relative to directory with sample directory.config
+		mappedPaths.push_back ("mapping_test");
+		mappedPaths.push_back ("mapping_test/");
+		mappedPaths.push_back ("mapping_test/1234");
+		mappedPaths.push_back ("mapping_test/1234/");
+		mappedPaths.push_back ("index.py");
+		mappedPaths.push_back ("python/mapping_test.py");
+	}
+
+	// both loaders must store the same data
+	bool checkMultipartLoaders ()
+	{
+		aconnect::str2str_map fields, baselineFields;
+
+		loadMultipart (fields);
+		std::ifstream upload (UploadFileName, std::ios::binary | std::ios::ate);
+		const std::streamoff uploadSize = upload.tellg();
+		upload.close();
+
+		baseline::loadMultipartFormData (multipartMessage, multipartBoundary, baselineFields);
+		std::ifstream baselineUpload (UploadFileName, std::ios::binary | std::ios::ate);
+		const std::streamoff baselineUploadSize = baselineUpload.tellg();
+
+		return fields == baselineFields && uploadSize == baselineUploadSize
+			&& uploadSize == (std::streamoff) (4 * binaryData.size());
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+int main (int argc, char* args[])
+{
+	prepareData ();
+
+	// sample config is used by default, 'make bench' runs from the root folder
+	string_constptr configPath = argc > 1 ? args[1] : "out/web/directory.config";
+
+	try
+	{
+		if (!checkMultipartLoaders ())
+			std::cerr << "Multipart loaders results are different" << std::endl;
+
+		measure ("MultipartParser + unbuffered write", multipartMessage.size(), parseMultipart);
+		measure ("string::find loop + ofstream", multipartMessage.size(), parseMultipartBaseline);
+
+		measure ("decodeUrl (plain)", plainText.size(), decodePlain);
+		measure ("decodeUrl (escaped)", escapedText.size(), decodeEscaped);
+		measure ("decodeUrlInPlace (escaped)", escapedText.size(), decodeEscapedInPlace);
+		measure ("per symbol decode (escaped)", escapedText.size(), decodeEscapedBaseline);
+		measure ("encodeUrlPart (plain)", plainText.size(), encodePlain);
+		measure ("encodeUrlPart (binary)", binaryData.size(), encodeBinary);
+		measure ("escapeHtml (plain)", plainText.size(), escapePlain);
+		measure ("escapeHtml (markup)", markupText.size(), escapeMarkup);
+
+		measure ("HttpRequestHeader::load", requestHeader.size(), parseHeader);
+		measure ("tokenizer + headers map", requestHeader.size(), parseHeaderBaseline);
+
+		const string_constptr instructionSets[] = { "scalar", "sse2", "avx2" };
+		const string selectedSet = util::scanInstructionSet();
+
+		std::cout << std::endl;
+		measure ("std::find_if", plainText.size(), findLineEndBaseline);
+		measure ("std::search", plainText.size(), findSequenceBaseline);
+
+		for (size_t ndx = 0; ndx < ARRAY_SIZE (instructionSets); ++ndx)
+		{
+			if (!util::useInstructionSet (instructionSets[ndx]))
+				continue;
+
+			const string prefix = string (instructionSets[ndx]) + ": ";
+			measure (prefix + "findLineEnd", plainText.size(), findLineEndScan);
+			measure (prefix + "findString", plainText.size(), findSequenceScan);
+			measure (prefix + "findAnyOf", plainText.size(), findAnyOfScan);
+			measure (prefix + "findUrlUnsafe", plainText.size(), findUrlUnsafeScan);
+			measure (prefix + "decodeUrl (escaped)", escapedText.size(), decodeEscaped);
+			measure (prefix + "escapeHtml (markup)", markupText.size(), escapeMarkup);
+		}
+		util::useInstructionSet (selectedSet.c_str());
+
+		std::cout << std::endl;
+		if (loadMappings (configPath)) {
+			measure ("UrlMapping::rewrite", 0, rewriteUrls);
+			measure ("regex_replace per group", 0, rewriteUrlsBaseline);
+		} else {
+			std::cerr << "Mappings are not loaded: " << configPath << std::endl;
+		}
+	}
+	catch (std::exception &ex)
+	{
+		std::cerr << "Unexpected exception: " << ex.what() << std::endl;
+		return 2;
+	}
+
+	remove (UploadFileName);
+
+	// keeps results alive
+	return resultsSink == 0 ? 1 : 0;
+}
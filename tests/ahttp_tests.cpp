@@ -0,0 +1,683 @@
+/*
+This file is part of [ahttp] library.
+
+Author: Artem Kustikov (kustikoff[at]tut.by)
+version: 0.19
+
+This code is provided 'as-is', without any express or implied
+warranty. In no event will the authors be held liable for any
+damages arising from the use of this code.
+
+Permission is granted to anyone to use this code for any
+purpose, including commercial applications, and to alter it and
+redistribute it freely, subject to the following restrictions:
+
+1. The origin of this code must not be misrepresented; you must
+not claim that you wrote the original code. If you use this
+code in a product, an acknowledgment in the product documentation
+would be appreciated but is not required.
+
+2. Altered source versions must be plainly marked as such, and
+must not be misrepresented as being the original code.
+
+3. This notice may not be removed or altered from any source
+distribution.
+*/
+
+#include "aconnect/lib_file_begin.inl"
+
+#include <iostream>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+#include <boost/regex.hpp>
+#include <boost/lexical_cast.hpp>
+
+#include "aconnect/types.hpp"
+#include "aconnect/error.hpp"
+#include "aconnect/util.string.hpp"
+#include "aconnect/util.scan.hpp"
+#include "aconnect/timer_wheel.hpp"
+
+#include "ahttp/aconnect_types.hpp"
+
+#include "ahttp/http_request.hpp"
+#include "ahttp/http_multipart.hpp"
+#include "ahttp/http_parameters.hpp"
+#include "ahttp/http_server_settings.hpp"
+#include "ahttp/http_support.hpp"
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Standalone checks of parsing and encoding routines,
+//	optimized versions are compared with straightforward reference ones.
+
+using aconnect::string;
+using aconnect::string_constref;
+using aconnect::string_constptr;
+namespace util = aconnect::util;
+
+namespace
+{
+	int checksCount = 0;
+	int failedCount = 0;
+
+	void check (bool condition, string_constptr expression, string_constptr file, int line)
+	{
+		++checksCount;
+		if (condition)
+			return;
+
+		++failedCount;
+		std::cerr << file << "(" << line << "): check failed: " << expression << std::endl;
+	}
+}
+
+#define TEST_CHECK(expr)	check ((expr), #expr, __FILE__, __LINE__)
+
+#define TEST_CHECK_THROW(expr, error_type) \
+	{ \
+		bool thrown = false; \
+		try { expr; } catch (error_type&) { thrown = true; } \
+		check (thrown, #expr " throws " #error_type, __FILE__, __LINE__); \
+	}
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Reference implementations
+
+namespace reference
+{
+	bool isLineEnd (char ch)	{	return ch == '\r' || ch == '\n';	}
+
+	bool isUrlUnsafe (char ch)
+	{
+		return !((ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z')
+			|| ch == '\'' || ch == '-' || ch == '.' || ch == '_');
+	}
+
+	string encodeUrlPart (string_constref str)
+	{
+		const char hex[] = "0123456789ABCDEF";
+		string res;
+		for (size_t ndx = 0; ndx < str.size(); ++ndx) {
+			const unsigned char ch = (unsigned char) str[ndx];
+			if (isUrlUnsafe (ch)) {
+				res += '%';
+				res += hex[ch >> 4];
+				res += hex[ch & 0x0F];
+			} else {
+				res += ch;
+			}
+		}
+		return res;
+	}
+
+	// throws std::out_of_range on invalid escape
+	string decodeUrl (string_constref url)
+	{
+		string res;
+		for (size_t ndx = 0; ndx < url.size(); ++ndx) {
+			if (url[ndx] == '+') {
+				res += ' ';
+			} else if (url[ndx] == '%') {
+				if (ndx + 2 >= url.size())
+					throw std::out_of_range ("Invalid hex symbol");
+				res += (char) ((util::parseHexSymbol (url[ndx + 1]) << 4) + util::parseHexSymbol (url[ndx + 2]));
+				ndx += 2;
+			} else {
+				res += url[ndx];
+			}
+		}
+		return res;
+	}
+
+	string escapeHtml (string_constref str)
+	{
+		string res;
+		for (size_t ndx = 0; ndx < str.size(); ++ndx) {
+			if (str[ndx] == '&')
+				res += "&amp;";
+			else if (str[ndx] == '<')
+				res += "&lt;";
+			else if (str[ndx] == '>')
+				res += "&gt;";
+			else
+				res += str[ndx];
+		}
+		return res;
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Helpers
+
+string randomString (size_t maxLength, string_constptr alphabet)
+{
+	const size_t alphabetSize = strlen (alphabet);
+	const size_t length = rand() % (maxLength + 1);
+
+	string res;
+	for (size_t ndx = 0; ndx < length; ++ndx) {
+		if (rand() % 8 == 0)
+			res += (char) (rand() % 256);
+		else
+			res += alphabet[rand() % alphabetSize];
+	}
+	return res;
+}
+
+class CollectingHandler : public ahttp::MultipartHandler
+{
+public:
+	CollectingHandler () : _partOpened (false), _eventsValid (true) { }
+
+	virtual void onPartBegin (string_constref header) {
+		_eventsValid = _eventsValid && !_partOpened;
+		_partOpened = true;
+		headers.push_back (header);
+		bodies.push_back (string());
+	}
+	virtual void onPartData (string_constptr data, size_t size) {
+		_eventsValid = _eventsValid && _partOpened;
+		if (_partOpened)
+			bodies.back().append (data, size);
+	}
+	virtual void onPartEnd () {
+		_eventsValid = _eventsValid && _partOpened;
+		_partOpened = false;
+	}
+
+	inline bool isValid() const		{	return _eventsValid && !_partOpened;	}
+
+	std::vector<string> headers;
+	std::vector<string> bodies;
+
+protected:
+	bool _partOpened;
+	bool _eventsValid;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//
+//		Tests
+
+void testMultipartParser ()
+{
+	for (int iter = 0; iter < 300; ++iter)
+	{
+		const string boundary = "----FormBoundary" + boost::lexical_cast<string> (iter);
+		string message = (iter % 3 == 0) ? "preamble\r\n" : "";
+		std::vector<string> headers, bodies;
+
+		const int partsCount = 1 + rand() % 4;
+		for (int part = 0; part < partsCount; ++part)
+		{
+			const string partHeader = (part == 1 && iter % 5 == 0) ? "" :
+				"Content-Disposition: form-data; name=\"f" + boost::lexical_cast<string> (part) + "\"";
+			string body = randomString (rand() % 3 == 0 ? 100000 : 50, "abc\r\n-");
+
+			// partial boundary inside content
+			if (iter % 7 == 0)
+				body += "\r\n--" + boundary.substr (0, boundary.size() - 1);
+
+			message += "--" + boundary + "\r\n" + (partHeader.empty() ? string() : partHeader + "\r\n")
+				+ "\r\n" + body + "\r\n";
+			headers.push_back (partHeader);
+			bodies.push_back (body);
+		}
+		message += "--" + boundary + "--\r\nepilogue";
+
+		ahttp::MultipartParser parser (boundary, 1000 + rand() % 70000);
+		CollectingHandler handler;
+
+		// small and large reads
+		const size_t maxRead = (iter % 2) ? 10 : 90000;
+		size_t pos = 0;
+		while (pos < message.size() && !parser.isFinished())
+		{
+			size_t freeSize;
+			aconnect::char_type *buff = parser.buffer (freeSize);
+			const size_t readSize = std::min (std::min (freeSize, 1 + rand() % maxRead), message.size() - pos);
+
+			memcpy (buff, message.c_str() + pos, readSize);
+			pos += readSize;
+			parser.consume (readSize, handler);
+		}
+
+		TEST_CHECK (parser.isFinished());
+		TEST_CHECK (handler.isValid());
+		TEST_CHECK (handler.headers == headers);
+		TEST_CHECK (handler.bodies == bodies);
+	}
+
+	for (int iter = 0; iter < 10000; ++iter)
+	{
+		const string text = randomString (200, "ab-\r\n"),
+			pattern = "\r\n--" + randomString (4, "ab-");
+		ahttp::BoundaryMatcher matcher (pattern);
+		TEST_CHECK (matcher.find (text.c_str(), text.size()) == text.find (pattern));
+	}
+
+	// unterminated part header
+	ahttp::MultipartParser parser ("b", 64 * 1024);
+	CollectingHandler handler;
+	const string message = "--b\r\n" + string (ahttp::MultipartParser::MaxPartHeaderSize + 1, 'h');
+
+	size_t freeSize;
+	memcpy (parser.buffer (freeSize), message.c_str(), message.size());
+	TEST_CHECK_THROW (parser.consume (message.size(), handler), aconnect::request_processing_error);
+}
+
+void testUrlCoding ()
+{
+	for (int iter = 0; iter < 100000; ++iter)
+	{
+		const string str = randomString (80, "abcXYZ09%+&<>._-'/ ");
+
+		TEST_CHECK (util::encodeUrlPart (str) == reference::encodeUrlPart (str));
+		TEST_CHECK (util::escapeHtml (str) == reference::escapeHtml (str));
+		TEST_CHECK (util::decodeUrl (util::encodeUrlPart (str)) == str);
+
+		// random '%' makes most strings invalid
+		string expected;
+		bool expectedThrown = false;
+		try {
+			expected = reference::decodeUrl (str);
+		} catch (std::out_of_range&) {
+			expectedThrown = true;
+		}
+
+		bool thrown = false;
+		try {
+			TEST_CHECK (util::decodeUrl (str) == expected);
+		} catch (std::out_of_range&) {
+			thrown = true;
+		}
+		TEST_CHECK (thrown == expectedThrown);
+
+		string buffer = str;
+		thrown = false;
+		try {
+			if (!buffer.empty())
+				buffer.resize (util::decodeUrlInPlace (&buffer[0], buffer.size()));
+			TEST_CHECK (buffer == expected);
+		} catch (std::out_of_range&) {
+			thrown = true;
+			TEST_CHECK (buffer == str);
+		}
+		TEST_CHECK (thrown == expectedThrown);
+	}
+
+	// adversarial '%'-heavy input
+	string escaped;
+	for (int ndx = 0; ndx < 10000; ++ndx)
+		escaped += "%41";
+	TEST_CHECK (util::decodeUrl (escaped) == string (10000, 'A'));
+
+	string percents (10000, '%');
+	TEST_CHECK (util::encodeUrlPart (percents).size() == 3 * percents.size());
+	TEST_CHECK (util::decodeUrl (util::encodeUrlPart (percents)) == percents);
+	TEST_CHECK_THROW (util::decodeUrl (percents), std::out_of_range);
+	TEST_CHECK_THROW (util::decodeUrl (escaped + "%4"), std::out_of_range);
+	TEST_CHECK_THROW (util::decodeUrl (escaped + "%"), std::out_of_range);
+	TEST_CHECK_THROW (util::decodeUrl (escaped + "%zz"), std::out_of_range);
+
+	string invalid = escaped + "%4";
+	const string source = invalid;
+	TEST_CHECK_THROW (util::decodeUrlInPlace (&invalid[0], invalid.size()), std::out_of_range);
+	TEST_CHECK (invalid == source);
+
+	TEST_CHECK (util::decodeUrl ("a+b%2Bc") == "a b+c");
+	TEST_CHECK (util::escapeHtml (string (1000, '<')).size() == 4000);
+}
+
+void testRequestParameters ()
+{
+	const string query = "a=1&b=x%20y&&c&a=2&first+name=J%26D&=e";
+	ahttp::RequestParameters params;
+	params.load (query.c_str(), query.size(), '&');
+
+	string value;
+	TEST_CHECK (params.find ("a", value) && value == "2");
+	TEST_CHECK (params.find ("b", value) && value == "x y");
+	TEST_CHECK (params.find ("c", value) && value.empty());
+	TEST_CHECK (params.find ("first name", value) && value == "J&D");
+	TEST_CHECK (!params.has ("d"));
+
+	const string cookies = "x=1; y=2;\tz=3";
+	ahttp::RequestParameters cookieParams;
+	cookieParams.load (cookies.c_str(), cookies.size(), ';', true);
+	TEST_CHECK (cookieParams.size() == 3 && cookieParams.get ("z") == "3");
+
+	// writable source is decoded once, repeated reads return the same values
+	char body[] = "b=x%20y&n%61me=v%2Bw&bad=%zz&%2541=1";
+	ahttp::RequestParameters form;
+	form.loadWritable (body, sizeof(body) - 1, '&');
+	for (int ndx = 0; ndx < 2; ++ndx) {
+		TEST_CHECK (form.find ("b", value) && value == "x y");
+		TEST_CHECK (form.find ("name", value) && value == "v+w");
+		TEST_CHECK (form.has ("%41") && !form.has ("A"));
+		TEST_CHECK_THROW (form.find ("bad", value), std::out_of_range);
+	}
+}
+
+void testRequestHeader ()
+{
+	ahttp::HttpRequestHeader header;
+	header.load ("POST /path/page.py?id=1 HTTP/1.1\r\n"
+		"Host: localhost\r\n"
+		"content-length: 15\r\n"
+		"X-Custom:  value \r\n"
+		"Cookie: a=1\r\n\r\n");
+
+	TEST_CHECK (header.Method == "POST");
+	TEST_CHECK (header.Path == "/path/page.py?id=1");
+	TEST_CHECK (header.VersionHigh == 1 && header.VersionLow == 1);
+	TEST_CHECK (header.isContentLengthRead() && header.ContentLength == 15);
+	TEST_CHECK (header.headersCount() == 4);
+	TEST_CHECK (header.headerName (2) == "X-Custom");
+	TEST_CHECK (header.getHeader ("x-custom") == "value");
+	TEST_CHECK (header.getHeader (ahttp::RequestHeaderHost) == "localhost");
+	TEST_CHECK (header.hasHeader (ahttp::RequestHeaderCookie));
+	TEST_CHECK (!header.hasHeader (ahttp::RequestHeaderReferer));
+	TEST_CHECK (!header.hasHeader (ahttp::RequestHeaderUnknown));
+	TEST_CHECK (header.getHeader (ahttp::RequestHeaderUnknown).empty());
+
+	TEST_CHECK (header.Headers.size() == 4);
+	TEST_CHECK (header.Headers.count ("HOST") == 1);
+	TEST_CHECK (header.removeHeader ("cookie"));
+	TEST_CHECK (!header.hasHeader (ahttp::RequestHeaderCookie));
+	TEST_CHECK (header.Headers.size() == 3);
+
+	// reload clears previous headers
+	header.load ("GET / HTTP/1.0\r\nReferer: http://localhost/\r\n\r\n");
+	TEST_CHECK (header.Method == "GET" && header.VersionLow == 0);
+	TEST_CHECK (!header.hasHeader (ahttp::RequestHeaderHost));
+	TEST_CHECK (header.hasHeader (ahttp::RequestHeaderReferer));
+
+	const string maxLength = boost::lexical_cast<string> ((size_t) -1);
+	header.load ("POST / HTTP/1.1\r\nContent-Length: " + maxLength + "\r\n\r\n");
+	TEST_CHECK (header.ContentLength == (size_t) -1);
+
+	TEST_CHECK_THROW (header.load ("POST / HTTP/1.1\r\nContent-Length: " + maxLength + "0\r\n\r\n"),
+		aconnect::request_processing_error);
+	TEST_CHECK_THROW (header.load ("POST / HTTP/1.1\r\nContent-Length: 99999999999999999999999\r\n\r\n"),
+		aconnect::request_processing_error);
+}
+
+void testScanKernels ()
+{
+	const char symbols[] = "&<>%";
+
+	for (int iter = 0; iter < 100000; ++iter)
+	{
+		// random start offset checks unaligned loads
+		const string data = randomString (300, "ab\r\n-&<>%._");
+		const size_t offset = data.empty() ? 0 : rand() % (data.size() + 1);
+		string_constptr begin = data.c_str() + offset,
+			end = data.c_str() + data.size();
+
+		TEST_CHECK (util::findLineEnd (begin, end) == std::find_if (begin, end, reference::isLineEnd));
+		TEST_CHECK (util::findUrlUnsafe (begin, end) == std::find_if (begin, end, reference::isUrlUnsafe));
+
+		const size_t symbolsCount = 1 + rand() % 4;
+		TEST_CHECK (util::findAnyOf (begin, end, symbols, symbolsCount)
+			== std::find_first_of (begin, end, symbols, symbols + symbolsCount));
+
+		string seq = randomString (6, "ab\r\n-");
+		if (seq.empty())
+			seq = "\r\n";
+		TEST_CHECK (util::findSequence (begin, end, seq.c_str(), seq.size())
+			== std::search (begin, end, seq.c_str(), seq.c_str() + seq.size()));
+		TEST_CHECK (util::findString (data, seq, offset) == data.find (seq, offset));
+	}
+
+	// match at the last position of long buffer
+	string data (4096, 'a');
+	data += "\r\n\r\n";
+	TEST_CHECK (util::findString (data, "\r\n\r\n") == 4096);
+	TEST_CHECK (util::findLineEnd (data.c_str(), data.c_str() + data.size()) == data.c_str() + 4096);
+}
+
+void testUrlMapping ()
+{
+	const ahttp::UrlMapping mapping ("^mapping_test\\/?(\\d+)?\\/?$", "python/mapping_test.py?id={0}");
+	boost::smatch matches;
+	const string url = "mapping_test/15";
+
+	TEST_CHECK (boost::regex_match (url, matches, mapping.regex));
+	TEST_CHECK (mapping.rewrite (matches) == "python/mapping_test.py?id=15");
+
+	// escaped and missing groups, format symbols are copied as is
+	const ahttp::UrlMapping complex ("^(\\w+)/(\\w+)$", "{1}/{{0}/{0}}/{5}/$1({0})");
+	const string source = "first/second";
+
+	TEST_CHECK (boost::regex_match (source, matches, complex.regex));
+	TEST_CHECK (complex.rewrite (matches) == "second/{{0}/{0}}/{5}/$1(first)");
+}
+
+void testServerVariables ()
+{
+	// ServerVariable::ServerVariableType order
+	const string_constptr names[] = {
+		ahttp::strings::ServerVariables::ALL_RAW,
+		ahttp::strings::ServerVariables::APPL_MD_PATH,
+		ahttp::strings::ServerVariables::APPL_PHYSICAL_PATH,
+		ahttp::strings::ServerVariables::AUTH_PASSWORD,
+		ahttp::strings::ServerVariables::AUTH_TYPE,
+		ahttp::strings::ServerVariables::AUTH_USER,
+		ahttp::strings::ServerVariables::CERT_COOKIE,
+		ahttp::strings::ServerVariables::CERT_FLAGS,
+		ahttp::strings::ServerVariables::CERT_ISSUER,
+		ahttp::strings::ServerVariables::CERT_KEYSIZE,
+		ahttp::strings::ServerVariables::CERT_SECRETKEYSIZE,
+		ahttp::strings::ServerVariables::CERT_SERIALNUMBER,
+		ahttp::strings::ServerVariables::CERT_SERVER_ISSUER,
+		ahttp::strings::ServerVariables::CERT_SERVER_SUBJECT,
+		ahttp::strings::ServerVariables::CERT_SUBJECT,
+		ahttp::strings::ServerVariables::CONTENT_LENGTH,
+		ahttp::strings::ServerVariables::CONTENT_TYPE,
+		ahttp::strings::ServerVariables::GATEWAY_INTERFACE,
+		ahttp::strings::ServerVariables::HTTPS,
+		ahttp::strings::ServerVariables::HTTPS_KEYSIZE,
+		ahttp::strings::ServerVariables::HTTPS_SECRETKEYSIZE,
+		ahttp::strings::ServerVariables::HTTPS_SERVER_ISSUER,
+		ahttp::strings::ServerVariables::HTTPS_SERVER_SUBJECT,
+		ahttp::strings::ServerVariables::INSTANCE_ID,
+		ahttp::strings::ServerVariables::INSTANCE_META_PATH,
+		ahttp::strings::ServerVariables::LOCAL_ADDR,
+		ahttp::strings::ServerVariables::LOGON_USER,
+		ahttp::strings::ServerVariables::PATH_INFO,
+		ahttp::strings::ServerVariables::PATH_INFO_RELATIVE,
+		ahttp::strings::ServerVariables::PATH_TRANSLATED,
+		ahttp::strings::ServerVariables::QUERY_STRING,
+		ahttp::strings::ServerVariables::REMOTE_ADDR,
+		ahttp::strings::ServerVariables::REMOTE_HOST,
+		ahttp::strings::ServerVariables::REMOTE_USER,
+		ahttp::strings::ServerVariables::REQUEST_METHOD,
+		ahttp::strings::ServerVariables::SCRIPT_NAME,
+		ahttp::strings::ServerVariables::SERVER_NAME,
+		ahttp::strings::ServerVariables::SERVER_PORT,
+		ahttp::strings::ServerVariables::SERVER_PORT_SECURE,
+		ahttp::strings::ServerVariables::SERVER_PROTOCOL,
+		ahttp::strings::ServerVariables::SERVER_SOFTWARE,
+		ahttp::strings::ServerVariables::URL,
+		ahttp::strings::ServerVariables::URL_ENCODED,
+		ahttp::strings::ServerVariables::HTTP_ACCEPT,
+		ahttp::strings::ServerVariables::HTTP_ACCEPT_LANGUAGE,
+		ahttp::strings::ServerVariables::HTTP_COOKIE,
+		ahttp::strings::ServerVariables::HTTP_CONNECTION,
+		ahttp::strings::ServerVariables::HTTP_HOST,
+		ahttp::strings::ServerVariables::HTTP_REFERER,
+		ahttp::strings::ServerVariables::HTTP_USER_AGENT,
+		ahttp::strings::ServerVariables::HTTP_ACCEPT_ENCODING,
+		ahttp::strings::ServerVariables::HTTP_ACCEPT_CHARSET,
+		ahttp::strings::ServerVariables::HTTP_KEEP_ALIVE
+	};
+	TEST_CHECK (ARRAY_SIZE (names) == ahttp::ServerVariable::Count);
+
+	for (int type = 0; type < ahttp::ServerVariable::Count; ++type)
+	{
+		string name = names[type];
+		TEST_CHECK (ahttp::getServerVariableType (name.c_str()) == type);
+		TEST_CHECK (string (ahttp::getServerVariableName ((ahttp::ServerVariable::ServerVariableType) type)) == name);
+
+		// names are case-insensitive
+		std::transform (name.begin(), name.end(), name.begin(), ::tolower);
+		TEST_CHECK (ahttp::getServerVariableType (name.c_str()) == type);
+
+		TEST_CHECK (ahttp::getServerVariableType ((name + "_").c_str()) == ahttp::ServerVariable::Unknown);
+		TEST_CHECK (ahttp::getServerVariableType (name.substr (1).c_str()) == ahttp::ServerVariable::Unknown);
+	}
+
+	TEST_CHECK (ahttp::getServerVariableType ("") == ahttp::ServerVariable::Unknown);
+	TEST_CHECK (ahttp::getServerVariableType ("HTTP_X_FORWARDED_FOR") == ahttp::ServerVariable::Unknown);
+}
+
+namespace 
+{
+	// advance wheel to 'tick', returns expired timers count, all of them must expire at 'tick'
+	size_t advanceWheel (aconnect::TimerWheel &wheel, aconnect::timer_tick_type tick)
+	{
+		std::vector<aconnect::TimerNode*> expired;
+		const size_t count = wheel.advance (tick, expired);
+
+		for (size_t ndx = 0; ndx < expired.size(); ++ndx) {
+			TEST_CHECK (expired[ndx]->expireTick == tick);
+			TEST_CHECK (!expired[ndx]->isArmed());
+		}
+		return count;
+	}
+}
+
+void testTimerWheel ()
+{
+	using aconnect::TimerWheel;
+	using aconnect::TimerNode;
+	using aconnect::timer_tick_type;
+
+	// level boundaries: 64, 4096, 262144 ticks
+	const timer_tick_type delays[] = { 1, 2, 63, 64, 65, 4095, 4096, 4097, 262143, 262144, 262145, 
+		TimerWheel::MaxDelay - 1, TimerWheel::MaxDelay, TimerWheel::MaxDelay + 100 };
+	const timer_tick_type startTicks[] = { 0, 1, 63, 64, 100, 4095, 4096, 262143, 262144 + 4096 + 5, 
+		TimerWheel::MaxDelay, 987654321UL };
+
+	for (size_t startNdx = 0; startNdx < ARRAY_SIZE (startTicks); ++startNdx)
+	{
+		const timer_tick_type start = startTicks[startNdx];
+		TimerWheel wheel (start);
+		TimerNode nodes[ARRAY_SIZE (delays)];
+
+		for (size_t ndx = 0; ndx < ARRAY_SIZE (delays); ++ndx)
+			wheel.arm (&nodes[ndx], delays[ndx]);
+		TEST_CHECK (wheel.size() == ARRAY_SIZE (delays));
+
+		// every timer expires exactly at its tick, not before
+		for (size_t ndx = 0; ndx < ARRAY_SIZE (delays); ++ndx) {
+			const timer_tick_type expireTick = start + util::min2 (delays[ndx], TimerWheel::MaxDelay);
+			if (!nodes[ndx].isArmed())
+				continue;
+
+			TEST_CHECK (nodes[ndx].expireTick == expireTick);
+			TEST_CHECK (advanceWheel (wheel, expireTick - 1) == 0);
+			TEST_CHECK (advanceWheel (wheel, expireTick) > 0);
+			TEST_CHECK (!nodes[ndx].isArmed());
+		}
+		TEST_CHECK (wheel.size() == 0);
+	}
+
+	// re-arming armed timer: previous expiration is dropped
+	{
+		TimerWheel wheel (10);
+		TimerNode node;
+
+		wheel.arm (&node, 100);
+		TEST_CHECK (advanceWheel (wheel, 60) == 0);
+		wheel.arm (&node, 5000);
+		TEST_CHECK (wheel.size() == 1);
+		TEST_CHECK (advanceWheel (wheel, 5059) == 0);
+		TEST_CHECK (advanceWheel (wheel, 5060) == 1);
+
+		// shorter delay than the current one, from upper level
+		wheel.arm (&node, 300000);
+		TEST_CHECK (advanceWheel (wheel, 6000) == 0);
+		wheel.arm (&node, 3);
+		TEST_CHECK (wheel.size() == 1);
+		TEST_CHECK (advanceWheel (wheel, 6003) == 1);
+		TEST_CHECK (advanceWheel (wheel, 6000 + 300000) == 0);
+	}
+
+	// cancel after timer is cascaded to lower levels
+	{
+		TimerWheel wheel (0);
+		TimerNode first, second, third;
+
+		wheel.arm (&first, 300000);		// level 3
+		wheel.arm (&second, 5000);		// level 2
+		wheel.arm (&third, 5000);
+
+		TEST_CHECK (advanceWheel (wheel, 4200) == 0);	// 'second' is on level 1 now
+		wheel.cancel (&second);
+		TEST_CHECK (!second.isArmed());
+		TEST_CHECK (wheel.size() == 2);
+
+		TEST_CHECK (advanceWheel (wheel, 4999) == 0);
+		TEST_CHECK (advanceWheel (wheel, 5000) == 1);	// 'third' only
+		TEST_CHECK (!third.isArmed());
+
+		TEST_CHECK (advanceWheel (wheel, 299990) == 0);	// 'first' is on level 0 now
+		wheel.cancel (&first);
+		wheel.cancel (&first);
+		TEST_CHECK (wheel.size() == 0);
+		TEST_CHECK (advanceWheel (wheel, 300000 + TimerWheel::MaxDelay) == 0);
+
+		// cancelled timer can be armed again
+		wheel.arm (&second, 64);
+		TEST_CHECK (advanceWheel (wheel, wheel.currentTick() + 64) == 1);
+	}
+}
+
+//////////////////////////////////////////////////////////////////////////
+
+int main (int argc, char* args[])
+{
+	srand (7);
+	const string_constptr instructionSets[] = { "scalar", "sse2", "avx2" };
+	const string selectedSet = util::scanInstructionSet();
+
+	try
+	{
+		testMultipartParser ();
+		testRequestParameters ();
+		testRequestHeader ();
+
+		// kernels of every supported instruction set are checked
+		for (size_t ndx = 0; ndx < ARRAY_SIZE (instructionSets); ++ndx)
+		{
+			if (!util::useInstructionSet (instructionSets[ndx])) {
+				std::cout << "scan instruction set: " << instructionSets[ndx] << " is not supported" << std::endl;
+				continue;
+			}
+
+			std::cout << "scan instruction set: " << instructionSets[ndx] << std::endl;
+			testScanKernels ();
+			testUrlCoding ();
+		}
+		util::useInstructionSet (selectedSet.c_str());
+		testUrlMapping ();
+		testServerVariables ();
+		testTimerWheel ();
+	}
+	catch (std::exception &ex)
+	{
+		std::cerr << "Unexpected exception: " << ex.what() << std::endl;
+		return 2;
+	}
+
+	std::cout << checksCount << " checks, " << failedCount << " failed" << std::endl;
+	return failedCount == 0 ? 0 : 1;
+}